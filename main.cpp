@@ -4,11 +4,22 @@
 #include <QFileInfo>
 #include <QDebug>
 #include <QTimer>
+#include <QUrl>
 #include <csignal>
+#include <functional>
+#include <memory>
 
 #include "config/config.h"
 #include "core/audiorecorder.h"
+#include "core/openaitranscriptionservice.h"
+#ifdef HAVE_WEBSOCKETS
+#include "core/realtimetranscriptionservice.h"
+#endif
+#include "core/requeststats.h"
 #include "core/statusutils.h"
+#include "core/tracer.h"
+#include "core/transcriptionbackend.h"
+#include "core/transcriptionqueue.h"
 #include "ui/mainwindow.h"
 
 // Global pointers for signal handling
@@ -21,19 +32,29 @@ static void signalHandler(int sig)
 
     // Handle SIGUSR1 (user signal 1) to show window and start recording
     if (sig == SIGUSR1 && g_mainWindow && !g_mainWindow->isVisible()) {
+        // A trace session covers one hotkey press until the text is delivered
+        Tracer::instance().beginSession();
+        TraceSpan span("SIGUSR1", "main");
+
         // Ensure any existing recording is stopped
         if (g_audioRecorder && g_audioRecorder->isRecording()) {
             g_audioRecorder->stopRecording();
         }
 
         // Show window first
-        g_mainWindow->show();
+        {
+            TraceSpan showSpan("show window", "main");
+            g_mainWindow->show();
+        }
 
-        // Now clean up any previous files just before starting new recording
-        for (const auto& f : QStringList{OUTPUT_FILE_PATH, TRANSCRIPTION_OUTPUT_PATH}) {
-            QFile file(f);
+        // Now clean up the saved copy of the previous recording just before
+        // starting a new one. Queued transcriptions work from their own
+        // buffers, and the transcription file belongs to them until pasted.
+        {
+            TraceSpan cleanupSpan("remove previous recording", "main");
+            QFile file(g_audioRecorder ? g_audioRecorder->outputFilePath() : QString());
             if (file.exists() && file.remove()) {
-                qInfo() << "[DEBUG] Removed previous file:" << f;
+                qInfo() << "[DEBUG] Removed previous file:" << file.fileName();
             }
         }
 
@@ -59,7 +80,7 @@ static void signalHandler(int sig)
         }
         
         // Remove application files
-        for (const auto& f : QStringList{OUTPUT_FILE_PATH, TRANSCRIPTION_OUTPUT_PATH, STATUS_FILE_PATH, LOCK_FILE_PATH}) {
+        for (const auto& f : QStringList{g_audioRecorder ? g_audioRecorder->outputFilePath() : QString(), TRANSCRIPTION_OUTPUT_PATH, STATUS_FILE_PATH, LOCK_FILE_PATH}) {
             QFile file(f);
             if (file.exists() && file.remove()) {
                 qInfo() << "[INFO] Removed file:" << f;
@@ -141,9 +162,110 @@ int main(int argc, char *argv[])
                                      "Stop recording after <milliseconds> timeout.",
                                      "milliseconds");
     parser.addOption(timeoutOption);
+
+    QCommandLineOption formatOption(QStringList() << "f" << "format",
+                                    QString("Audio format to record: %1 (default: mp3, wav with --backend realtime).")
+                                        .arg(availableAudioFormatNames().join(", ")),
+                                    "format", "mp3");
+    parser.addOption(formatOption);
+
+    QCommandLineOption saveAudioOption(QStringList() << "s" << "save-audio",
+                                       "Also save each recording to /tmp/voice_input_recording.<ext>.");
+    parser.addOption(saveAudioOption);
+
+    QCommandLineOption durabilityOption(QStringList() << "durability",
+                                        "When --save-audio flushes the file to disk: none, periodic or stop "
+                                        "(default: none).",
+                                        "policy", "none");
+    parser.addOption(durabilityOption);
+
+    QCommandLineOption streamOption(QStringList() << "stream",
+                                    "Upload audio while recording instead of after it stops.");
+    parser.addOption(streamOption);
+
+    QCommandLineOption segmentOption(QStringList() << "segment",
+                                     "Split long recordings at pauses and transcribe the pieces in parallel.");
+    parser.addOption(segmentOption);
+
+    QCommandLineOption noVadOption(QStringList() << "no-vad",
+                                   "Upload the recording as is, without trimming silence.");
+    parser.addOption(noVadOption);
+
+    QCommandLineOption maxPauseOption(QStringList() << "max-pause",
+                                      QString("Shorten pauses to at most <milliseconds> before upload (default: %1).")
+                                          .arg(DEFAULT_MAX_PAUSE_MS),
+                                      "milliseconds");
+    parser.addOption(maxPauseOption);
+
+    QCommandLineOption autoStopOption(QStringList() << "auto-stop",
+                                      "Stop recording and transcribe after <milliseconds> of silence following speech.",
+                                      "milliseconds");
+    parser.addOption(autoStopOption);
+
+    QCommandLineOption preRollOption(QStringList() << "pre-roll",
+                                     "Keep the microphone open while idle and start each recording with the last "
+                                     "<milliseconds> of audio, so the first words are never cut off.",
+                                     "milliseconds");
+    parser.addOption(preRollOption);
+
+    QCommandLineOption inputFileOption(QStringList() << "input-file",
+                                       "Replay <path> (MP3 or WAV) instead of recording from the microphone; "
+                                       "each recording stops at the end of the file.",
+                                       "path");
+    parser.addOption(inputFileOption);
+
+    QCommandLineOption inputPacingOption(QStringList() << "input-pacing",
+                                         "How --input-file is fed: realtime or fast (as fast as the encoder keeps up).",
+                                         "pacing", "realtime");
+    parser.addOption(inputPacingOption);
+
+    QCommandLineOption hedgeOption(QStringList() << "hedge",
+                                   "Send the recording a second time when the response is later than usual "
+                                   "(p95 of recent requests) and use whichever reply arrives first.");
+    parser.addOption(hedgeOption);
+
+    QCommandLineOption apiBaseUrlOption(QStringList() << "api-base-url",
+                                        "Base URL of the transcription API (default: " + QString(TRANSCRIPTION_API_BASE_URL) +
+                                        ", or $OPENAI_BASE_URL), e.g. http://127.0.0.1:8089/v1 for voice_input_mock_server.",
+                                        "url");
+    parser.addOption(apiBaseUrlOption);
+
+    QCommandLineOption backendOption(QStringList() << "backend",
+                                     QString("Transcription backend: %1 (default: openai). realtime (builds with QtWebSockets) "
+                                             "streams audio over a WebSocket and shows the text while you speak.")
+                                         .arg(availableTranscriptionBackendNames().join(", ")),
+                                     "backend", "openai");
+    parser.addOption(backendOption);
+
+    QCommandLineOption jobsOption(QStringList() << "jobs",
+                                  QString("Transcribe up to <n> recordings at once, so the next one can start "
+                                          "while earlier ones are transcribed (default: %1).")
+                                      .arg(TRANSCRIPTION_MAX_PARALLEL_JOBS),
+                                  "n");
+    parser.addOption(jobsOption);
+
+    QCommandLineOption traceOption(QStringList() << "trace",
+                                   "Write a Chrome trace (chrome://tracing, ui.perfetto.dev) of each recording, "
+                                   "from the hotkey to the paste, to " + QString(TRACE_FILE_BASE_PATH) + "_<time>.json.");
+    parser.addOption(traceOption);
+
+    QCommandLineOption requestStatsOption(QStringList() << "request-stats",
+                                          "Print p50/p95/p99 of the transcription request phases over the recent "
+                                          "requests and exit.");
+    parser.addOption(requestStatsOption);
     
     parser.process(app);
 
+    if (parser.isSet(requestStatsOption)) {
+        RequestStatistics stats;
+        stats.load();
+        const QString summary = stats.describe();
+        qInfo().noquote() << "Request statistics from" << stats.path() << "(milliseconds unless noted)\n"
+                          << (summary.isEmpty() ? QString("no requests recorded yet") : summary);
+        QFile::remove(LOCK_FILE_PATH);
+        return APP_EXIT_SUCCESS;
+    }
+
     int timeoutMs = DEFAULT_TIMEOUT;
     if (parser.isSet(timeoutOption)) {
         bool ok = false;
@@ -153,8 +275,131 @@ int main(int argc, char *argv[])
         }
     }
 
+    int autoStopMs = 0;
+    if (parser.isSet(autoStopOption)) {
+        bool ok = false;
+        int val = parser.value(autoStopOption).toInt(&ok);
+        if (ok && val > 0) {
+            autoStopMs = val;
+        }
+    }
+
+    int maxPauseMs = DEFAULT_MAX_PAUSE_MS;
+    if (parser.isSet(maxPauseOption)) {
+        bool ok = false;
+        int val = parser.value(maxPauseOption).toInt(&ok);
+        if (ok && val >= 0) {
+            maxPauseMs = val;
+        }
+    }
+
+    int parallelJobs = TRANSCRIPTION_MAX_PARALLEL_JOBS;
+    if (parser.isSet(jobsOption)) {
+        bool ok = false;
+        int val = parser.value(jobsOption).toInt(&ok);
+        if (ok && val > 0) {
+            parallelJobs = val;
+        }
+    }
+
+    if (parser.isSet(traceOption)) {
+        Tracer::instance().enable(TRACE_FILE_BASE_PATH);
+        Tracer::instance().setThreadName("gui");
+    }
+
+    const QString backendName = parser.value(backendOption).trimmed().toLower();
+    if (!availableTranscriptionBackendNames().contains(backendName)) {
+        qCritical() << "[ERROR] Unsupported transcription backend:" << parser.value(backendOption)
+                    << "- available:" << availableTranscriptionBackendNames().join(", ");
+        QFile::remove(LOCK_FILE_PATH);
+        return APP_EXIT_FAILURE_GENERAL;
+    }
+
+    // The realtime API takes raw PCM, so it records WAV unless told otherwise
+    const bool needsPcm = backendName == "realtime";
+    const QString formatName = needsPcm && !parser.isSet(formatOption) ? QString("wav") : parser.value(formatOption);
+    AudioFormat audioFormat = AudioFormat::Mp3;
+    if (!parseAudioFormat(formatName, &audioFormat) || !isAudioFormatAvailable(audioFormat)) {
+        qCritical() << "[ERROR] Unsupported audio format:" << formatName
+                    << "- available:" << availableAudioFormatNames().join(", ");
+        QFile::remove(LOCK_FILE_PATH);
+        return APP_EXIT_FAILURE_GENERAL;
+    }
+
+    AsyncFileWriter::Durability durability = AsyncFileWriter::Durability::None;
+    if (!AsyncFileWriter::parseDurability(parser.value(durabilityOption), &durability)) {
+        qCritical() << "[ERROR] Unsupported durability policy:" << parser.value(durabilityOption)
+                    << "- available: none, periodic, stop";
+        QFile::remove(LOCK_FILE_PATH);
+        return APP_EXIT_FAILURE_GENERAL;
+    }
+
+    FileAudioSource::Pacing inputPacing = FileAudioSource::Pacing::RealTime;
+    if (!FileAudioSource::parsePacing(parser.value(inputPacingOption), &inputPacing)) {
+        qCritical() << "[ERROR] Unsupported input pacing:" << parser.value(inputPacingOption)
+                    << "- available: realtime, fast";
+        QFile::remove(LOCK_FILE_PATH);
+        return APP_EXIT_FAILURE_GENERAL;
+    }
+
+    const QString apiBaseUrl = parser.value(apiBaseUrlOption);
+    if (parser.isSet(apiBaseUrlOption)) {
+        const QUrl url(apiBaseUrl, QUrl::StrictMode);
+        if (!url.isValid() || url.host().isEmpty() || (url.scheme() != "http" && url.scheme() != "https")) {
+            qCritical() << "[ERROR] Invalid API base URL:" << apiBaseUrl << "- expected http(s)://host[:port]/path";
+            QFile::remove(LOCK_FILE_PATH);
+            return APP_EXIT_FAILURE_GENERAL;
+        }
+    }
+
+    // Backends for parallel jobs are made alike as the queue needs them
+    std::function<TranscriptionBackend*()> makeBackend;
+#ifdef HAVE_WEBSOCKETS
+    if (backendName == "realtime") {
+        makeBackend = [apiBaseUrl]() -> TranscriptionBackend* {
+            auto* realtime = new RealtimeTranscriptionService();
+            realtime->setApiBaseUrl(apiBaseUrl);
+            return realtime;
+        };
+    }
+#endif
+    if (backendName == "openai") {
+        const bool hedging = parser.isSet(hedgeOption);
+        makeBackend = [apiBaseUrl, hedging]() -> TranscriptionBackend* {
+            auto* openAi = new OpenAiTranscriptionService();
+            openAi->setApiBaseUrl(apiBaseUrl);
+            openAi->setHedging(hedging);
+            return openAi;
+        };
+    }
+
+    // Create the transcription backend
+    std::unique_ptr<TranscriptionBackend> backend(makeBackend());
+    if (!backend->acceptsFormat(audioFormat)) {
+        qCritical() << "[ERROR] The" << backend->name() << "backend cannot transcribe" << audioFormatName(audioFormat)
+                    << "recordings";
+        QFile::remove(LOCK_FILE_PATH);
+        return APP_EXIT_FAILURE_GENERAL;
+    }
+    if (parser.isSet(streamOption) && !backend->supportsStreaming()) {
+        qWarning() << "[WARNING] The" << backend->name() << "backend starts after the recording; --stream is ignored";
+    }
+
     // Create the AudioRecorder
     AudioRecorder recorder;
+    recorder.setAudioFormat(audioFormat);
+    recorder.setSaveToFile(parser.isSet(saveAudioOption));
+    recorder.setSaveDurability(durability);
+    recorder.setSegmentationEnabled(parser.isSet(segmentOption));
+    recorder.setSilenceTrimming(!parser.isSet(noVadOption), maxPauseMs);
+    recorder.setAutoStopSilence(autoStopMs);
+    recorder.setMaxDuration(timeoutMs);
+    if (parser.isSet(preRollOption)) {
+        recorder.setPreRoll(parser.value(preRollOption).toInt());
+    }
+    if (parser.isSet(inputFileOption)) {
+        recorder.setInputFile(parser.value(inputFileOption), inputPacing);
+    }
     g_audioRecorder = &recorder; // For signalHandler access
 
     // Connect aboutToQuit for graceful cleanup
@@ -162,7 +407,7 @@ int main(int argc, char *argv[])
         recorder.stopRecording();
         
         // Remove all application files
-        for (const auto& f : QStringList{OUTPUT_FILE_PATH, TRANSCRIPTION_OUTPUT_PATH, STATUS_FILE_PATH, LOCK_FILE_PATH}) {
+        for (const auto& f : QStringList{recorder.outputFilePath(), TRANSCRIPTION_OUTPUT_PATH, STATUS_FILE_PATH, LOCK_FILE_PATH}) {
             QFile file(f);
             if (file.exists() && file.remove()) {
                 qInfo() << "[INFO] Removed file:" << f;
@@ -177,7 +422,7 @@ int main(int argc, char *argv[])
     });
     
     // Clean up any leftover files
-    for (const auto& f : QStringList{OUTPUT_FILE_PATH, TRANSCRIPTION_OUTPUT_PATH}) {
+    for (const auto& f : QStringList{recorder.outputFilePath(), TRANSCRIPTION_OUTPUT_PATH}) {
         QFile file(f);
         if (file.exists() && file.remove()) {
             qInfo() << "[DEBUG] Removed leftover file:" << f;
@@ -193,12 +438,16 @@ int main(int argc, char *argv[])
     qInfo() << "[INFO] Audio system initialized successfully";
     
     // Create main window (UI) and pass a pointer to the recorder
-    MainWindow window(&recorder);
+    // The realtime backend exists to stream, so it always does
+    const bool streaming = parser.isSet(streamOption) || backendName == "realtime";
+    MainWindow window(&recorder, new TranscriptionQueue(backend.release(), makeBackend, parallelJobs));
+    window.setStreamingUpload(streaming);
     g_mainWindow = &window;  // For signalHandler access
 
-    // Start with window hidden - make sure audio stream is paused
+    // Start with window hidden - make sure audio stream is paused (unless in warm standby)
     recorder.pauseAudioStream();
-    qInfo() << "[INFO] Starting in background mode with microphone paused."
+    qInfo() << "[INFO] Starting in background mode with microphone"
+            << (recorder.preRoll() > 0 ? "in warm standby." : "paused.")
             << "To show window and begin recording:\n```\nkill -SIGUSR1"
             << QCoreApplication::applicationPid() << "\n```";
 
@@ -0,0 +1,705 @@
+#include <QDir>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QFile>
+#include <QImage>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QLoggingCategory>
+#include <QNetworkReply>
+#include <QRandomGenerator>
+#include <QStandardPaths>
+#include <QTimer>
+#include <QVector>
+#include <QtMath>
+#include <QtTest>
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include "config/config.h"
+#include "core/asyncfilewriter.h"
+#include "core/audioencoder.h"
+#include "core/audiofiledecoder.h"
+#include "core/audiohealth.h"
+#include "core/audiorecorder.h"
+#include "core/chunkedarena.h"
+#include "core/mp3encoder.h"
+#include "core/openaitranscriptionservice.h"
+#include "core/polyphaseresampler.h"
+#include "mock/mocktranscriptionserver.h"
+#include "ui/volumebar.h"
+
+Q_DECLARE_METATYPE(AudioFormat)
+Q_DECLARE_METATYPE(AsyncFileWriter::Durability)
+Q_DECLARE_METATYPE(FileAudioSource::Pacing)
+
+namespace {
+
+// Reference recording for the file based benchmarks; QtTest owns the command line
+constexpr auto BENCH_CLIP_ENV = "VOICE_INPUT_BENCH_CLIP";
+
+// Warm-standby pre-roll of the recorder in the callback benchmark
+constexpr int BENCH_PRE_ROLL_MS = 500;
+
+// Requests per row of the first upload byte benchmark, the upload each one
+// sends, and how long the pre-connect gets (in use, the whole recording)
+constexpr int BENCH_FIRST_BYTE_REQUESTS = 20;
+constexpr int BENCH_FIRST_BYTE_UPLOAD_BYTES = 64 * 1024;
+constexpr int BENCH_PRECONNECT_MS = 50;
+
+// Speech-like test signal: a few harmonics with a slow envelope plus noise
+std::vector<short> makeSyntheticPcm(int frames, quint32 seed)
+{
+    QRandomGenerator rng(seed);
+    std::vector<short> pcm(static_cast<std::size_t>(frames));
+    for (int i = 0; i < frames; ++i) {
+        const double t = static_cast<double>(i) / FALLBACK_SAMPLE_RATE;
+        const double envelope = 0.5 + 0.5 * qSin(2.0 * M_PI * 3.0 * t);
+        const double voice = 0.30 * qSin(2.0 * M_PI * 180.0 * t)
+                           + 0.15 * qSin(2.0 * M_PI * 360.0 * t)
+                           + 0.08 * qSin(2.0 * M_PI * 720.0 * t);
+        const double noise = (rng.generateDouble() - 0.5) * 0.05;
+        pcm[static_cast<std::size_t>(i)] = static_cast<short>(qBound(-1.0, envelope * voice + noise, 1.0) * 32767.0);
+    }
+    return pcm;
+}
+
+// Encode mono PCM the way the recorder's worker does, in worker-sized batches.
+// Returns the number of encoded bytes, or -1 on error.
+qint64 encodeWith(AudioEncoder& encoder, const std::vector<short>& pcm, int sampleRate)
+{
+    if (!encoder.begin(sampleRate, 1)) {
+        return -1;
+    }
+
+    QByteArray out;
+    qint64 total = 0;
+    for (std::size_t offset = 0; offset < pcm.size(); offset += ENCODER_BATCH_FRAMES) {
+        const int count = static_cast<int>(qMin<std::size_t>(ENCODER_BATCH_FRAMES, pcm.size() - offset));
+        out.clear();
+        if (!encoder.encode(pcm.data() + offset, count, out)) {
+            return -1;
+        }
+        total += out.size();
+    }
+    out.clear();
+    if (!encoder.finish(out)) {
+        return -1;
+    }
+    return total + out.size();
+}
+
+std::vector<short> resampleToSpeechRate(const std::vector<short>& pcm, int sampleRate)
+{
+    PolyphaseResampler resampler(sampleRate, SPEECH_SAMPLE_RATE, RESAMPLER_TAPS_PER_PHASE);
+    std::vector<short> speech;
+    speech.reserve(resampler.maxOutputFrames(pcm.size()));
+    resampler.process(pcm.data(), pcm.size(), speech);
+    resampler.flush(speech);
+    return speech;
+}
+
+// A verbose_json transcription response with `segmentCount` segments of
+// about ten words each, the largest body handleNetworkReply() gets to parse
+QByteArray makeTranscriptionResponse(int segmentCount)
+{
+    static const QStringList words = {"so", "the", "recording", "starts", "when", "I", "press", "the",
+                                      "hotkey", "and", "stops", "after", "a", "pause", "of", "silence"};
+    QJsonArray segments;
+    QStringList texts;
+    for (int i = 0; i < segmentCount; ++i) {
+        QStringList sentence;
+        QJsonArray tokens;
+        for (int w = 0; w < 10; ++w) {
+            sentence << words.at((i * 7 + w) % words.size());
+            tokens.append(50364 + (i * 10 + w) % 1000);
+        }
+        const QString text = " " + sentence.join(' ') + ".";
+        texts << text;
+        segments.append(QJsonObject{{"id", i},
+                                    {"seek", i * 400},
+                                    {"start", i * 4.0},
+                                    {"end", i * 4.0 + 3.8},
+                                    {"text", text},
+                                    {"tokens", tokens},
+                                    {"temperature", 0.1},
+                                    {"avg_logprob", -0.21},
+                                    {"compression_ratio", 1.4},
+                                    {"no_speech_prob", 0.01}});
+    }
+    const QJsonObject response{{"task", "transcribe"},
+                               {"language", "english"},
+                               {"duration", segmentCount * 4.0},
+                               {"text", texts.join(QString())},
+                               {"segments", segments}};
+    return QJsonDocument(response).toJson(QJsonDocument::Compact);
+}
+
+// A finished reply with a fixed body, as QNetworkAccessManager hands one
+// to handleNetworkReply()
+class CannedReply : public QNetworkReply
+{
+public:
+    CannedReply(const QByteArray& body, int httpStatus)
+        : m_body(body),
+          m_offset(0)
+    {
+        setOperation(QNetworkAccessManager::PostOperation);
+        setAttribute(QNetworkRequest::HttpStatusCodeAttribute, httpStatus);
+        open(QIODevice::ReadOnly | QIODevice::Unbuffered);
+        setFinished(true);
+    }
+
+    void abort() override {}
+    bool isSequential() const override { return true; }
+    qint64 bytesAvailable() const override { return m_body.size() - m_offset + QNetworkReply::bytesAvailable(); }
+
+protected:
+    qint64 readData(char* data, qint64 maxSize) override
+    {
+        const qint64 count = qMin(maxSize, static_cast<qint64>(m_body.size()) - m_offset);
+        std::memcpy(data, m_body.constData() + m_offset, static_cast<std::size_t>(count));
+        m_offset += count;
+        return count;
+    }
+
+private:
+    QByteArray m_body;
+    qint64     m_offset;
+};
+
+} // namespace
+
+// Headless benchmarks for the recording and transcription hot paths, one
+// QBENCHMARK per case: ./voice_input_bench [case...] [-o results.xml,xml].
+// What a time per iteration cannot show (bytes, realtime factors, health
+// counters) is logged next to it.
+class VoiceInputBenchmarks : public QObject
+{
+    Q_OBJECT
+public:
+    // Widgets are measured without a display
+    static void initMain();
+
+private slots:
+    void initTestCase();
+
+    void speechRate_data();
+    void speechRate();
+    void encoders_data();
+    void encoders();
+    void startup_data();
+    void startup();
+    void fileWriter_data();
+    void fileWriter();
+    void mp3_data();
+    void mp3();
+    void callback_data();
+    void callback();
+    void volumeBar_data();
+    void volumeBar();
+    void response_data();
+    void response();
+    void firstByte_data();
+    void firstByte();
+    void replay_data();
+    void replay();
+
+private:
+    QString            m_clipPath;
+    std::vector<short> m_clip;
+    int                m_clipRate = 0;
+    std::vector<short> m_speech;      // The clip at SPEECH_SAMPLE_RATE
+};
+
+void VoiceInputBenchmarks::initMain()
+{
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    // Requests against the stand-in stay out of the app's request statistics
+    QStandardPaths::setTestModeEnabled(true);
+}
+
+void VoiceInputBenchmarks::initTestCase()
+{
+    m_clipPath = qEnvironmentVariable(BENCH_CLIP_ENV, "hello_world.mp3");
+    DecodedAudio audio;
+    QString error;
+    if (!decodeAudioFile(m_clipPath, audio, &error)) {
+        qWarning().noquote() << "Cannot load clip" << m_clipPath << ":" << error
+                             << QString("- set $%1; file based cases are skipped").arg(BENCH_CLIP_ENV);
+        return;
+    }
+    m_clip = std::move(audio.samples);
+    m_clipRate = audio.sampleRate;
+    m_speech = resampleToSpeechRate(m_clip, m_clipRate);
+    qInfo().noquote() << QString("Clip: %1 (%2 Hz, %3 s)")
+                             .arg(m_clipPath)
+                             .arg(m_clipRate)
+                             .arg(static_cast<double>(m_clip.size()) / m_clipRate, 0, 'f', 2);
+}
+
+void VoiceInputBenchmarks::speechRate_data()
+{
+    QTest::addColumn<bool>("resample");
+    QTest::addColumn<int>("bitrate");
+
+    QTest::newRow("capture rate, 128 kbps (previous)") << false << 128000;
+    QTest::newRow("speech rate (resampled)") << true << ENCODER_BITRATE;
+}
+
+void VoiceInputBenchmarks::speechRate()
+{
+    QFETCH(bool, resample);
+    QFETCH(int, bitrate);
+    if (m_clip.empty()) {
+        QSKIP("No clip");
+    }
+
+    // The whole recording, with the resampling stage in the pipeline cost
+    qint64 bytes = 0;
+    QBENCHMARK {
+        std::vector<short> speech;
+        if (resample) {
+            speech = resampleToSpeechRate(m_clip, m_clipRate);
+        }
+        Mp3Encoder encoder(bitrate);
+        bytes = encodeWith(encoder, resample ? speech : m_clip, resample ? SPEECH_SAMPLE_RATE : m_clipRate);
+    }
+    QVERIFY2(bytes >= 0, "LAME rejected the settings");
+
+    const double clipSeconds = static_cast<double>(m_clip.size()) / m_clipRate;
+    qInfo().noquote() << QString("Upload %1 bytes (%2 B/s of audio)").arg(bytes).arg(bytes / clipSeconds, 0, 'f', 0);
+}
+
+void VoiceInputBenchmarks::encoders_data()
+{
+    QTest::addColumn<AudioFormat>("format");
+
+    for (AudioFormat format : {AudioFormat::Mp3, AudioFormat::Wav, AudioFormat::Flac, AudioFormat::Opus}) {
+        QTest::newRow(qPrintable(audioFormatName(format))) << format;
+    }
+}
+
+void VoiceInputBenchmarks::encoders()
+{
+    QFETCH(AudioFormat, format);
+    if (m_clip.empty()) {
+        QSKIP("No clip");
+    }
+
+    // Every backend gets the same 16 kHz PCM the recorder would hand it
+    std::unique_ptr<AudioEncoder> encoder = createAudioEncoder(format);
+    if (!encoder) {
+        QSKIP("Not compiled in");
+    }
+
+    qint64 bytes = 0;
+    QBENCHMARK {
+        bytes = encodeWith(*encoder, m_speech, SPEECH_SAMPLE_RATE);
+    }
+    QVERIFY2(bytes >= 0, qPrintable(encoder->lastError()));
+
+    // Bytes per second of audio is what the upload has to move afterwards
+    const double seconds = static_cast<double>(m_speech.size()) / SPEECH_SAMPLE_RATE;
+    qInfo().noquote() << QString("%1 bytes for %2 s (%3 B/s, %4 kbps)")
+                             .arg(bytes)
+                             .arg(seconds, 0, 'f', 2)
+                             .arg(bytes / seconds, 0, 'f', 0)
+                             .arg(bytes * 8.0 / seconds / 1000.0, 0, 'f', 1);
+}
+
+void VoiceInputBenchmarks::startup_data()
+{
+    QTest::addColumn<AudioFormat>("format");
+    QTest::addColumn<bool>("segmented");
+    QTest::addColumn<bool>("prepared");
+
+    for (AudioFormat format : {AudioFormat::Mp3, AudioFormat::Wav, AudioFormat::Flac, AudioFormat::Opus}) {
+        for (bool segmented : {false, true}) {
+            for (bool prepared : {false, true}) {
+                QTest::addRow("%s%s, %s", qPrintable(audioFormatName(format)), segmented ? " +segments" : "",
+                              prepared ? "prepared sink" : "built on start")
+                    << format << segmented << prepared;
+            }
+        }
+    }
+}
+
+void VoiceInputBenchmarks::startup()
+{
+    QFETCH(AudioFormat, format);
+    QFETCH(bool, segmented);
+    QFETCH(bool, prepared);
+    if (!isAudioFormatAvailable(format)) {
+        QSKIP("Not compiled in");
+    }
+    if (m_clip.empty()) {
+        QSKIP("No clip");
+    }
+
+    // The recorder's own start and stop, with the clip replayed in real time
+    // in place of the microphone, so hardly any audio is encoded in between
+    AudioRecorder recorder;
+    recorder.setInputFile(m_clipPath, FileAudioSource::Pacing::RealTime);
+    recorder.setSaveToFile(false);
+    QVERIFY(recorder.setAudioFormat(format));
+    recorder.setSegmentationEnabled(segmented);
+    QVERIFY2(recorder.initializeAudioSystem(), "Cannot replay the clip");
+
+    // Each iteration first waits for the sink the last stopRecording() began
+    // to build, which in use overlaps the pause between two recordings.
+    // Without it startRecording() builds one on the spot, as every recording
+    // used to.
+    bool started = true;
+    qint64 startNs = 0;
+    qint64 starts = 0;
+    QElapsedTimer timer;
+    QLoggingCategory::setFilterRules("default.info=false");
+    QBENCHMARK {
+        recorder.m_sinkFuture.waitForFinished();
+        if (!prepared) {
+            recorder.m_preparedSink.reset();
+        }
+        timer.start();
+        started = recorder.startRecording() && started;
+        startNs += timer.nsecsElapsed();
+        ++starts;
+        recorder.stopRecording();
+    }
+    QLoggingCategory::setFilterRules(QString());
+    QVERIFY2(started, "Cannot start recording");
+
+    // The part the user waits for before the first sample is taken
+    qInfo().noquote() << QString("startRecording() alone: %1 us")
+                             .arg(static_cast<double>(startNs) / starts / 1000.0, 0, 'f', 1);
+}
+
+void VoiceInputBenchmarks::fileWriter_data()
+{
+    QTest::addColumn<bool>("async");
+    QTest::addColumn<AsyncFileWriter::Durability>("durability");
+
+    QTest::newRow("write per frame") << false << AsyncFileWriter::Durability::None;
+    for (AsyncFileWriter::Durability durability : {AsyncFileWriter::Durability::None,
+                                                   AsyncFileWriter::Durability::OnStop}) {
+        QTest::addRow("async writer, durability %s", qPrintable(AsyncFileWriter::durabilityName(durability)))
+            << true << durability;
+    }
+}
+
+void VoiceInputBenchmarks::fileWriter()
+{
+    QFETCH(bool, async);
+    QFETCH(AsyncFileWriter::Durability, durability);
+
+    // Ten minutes of 48 kbps MP3 as the encoder hands it out, one 576-sample
+    // MPEG-2 frame (216 bytes at 16 kHz) at a time
+    constexpr int FRAME_BYTES = ENCODER_BITRATE / 8 * 576 / SPEECH_SAMPLE_RATE;
+    constexpr int FRAMES = 10 * 60 * ENCODER_BITRATE / 8 / FRAME_BYTES;
+    const QByteArray frame(FRAME_BYTES, '\x5a');
+    const QString path = QDir::temp().filePath("voice_input_bench_write.bin");
+
+    if (!async) {
+        // One write per encoder frame, as the recorder's output file used to get
+        QFile file(path);
+        QVERIFY2(file.open(QIODevice::WriteOnly | QIODevice::Unbuffered), qPrintable(file.errorString()));
+        QBENCHMARK_ONCE {
+            for (int i = 0; i < FRAMES; ++i) {
+                file.write(frame);
+            }
+            file.close();
+        }
+        qInfo().noquote() << QString("%1 writes of %2 bytes").arg(FRAMES).arg(FRAME_BYTES);
+        QFile::remove(path);
+        return;
+    }
+
+    // Frames appended to the arena; the writer thread follows it in blocks
+    QSharedPointer<ChunkedArena> arena =
+        QSharedPointer<ChunkedArena>::create(RECORDING_ARENA_CHUNK_BYTES, RECORDING_ARENA_MAX_CHUNKS);
+    AsyncFileWriter writer(arena, path, durability);
+    double appendMs = 0.0;
+    QBENCHMARK_ONCE {
+        QElapsedTimer timer;
+        timer.start();
+        writer.start();
+        for (int i = 0; i < FRAMES; ++i) {
+            arena->append(frame.constData(), frame.size());
+        }
+        appendMs = timer.nsecsElapsed() / 1e6;
+        arena->finish();
+        writer.finish();
+        writer.wait();
+    }
+
+    const AsyncFileWriter::Stats stats = writer.stats();
+    qInfo().noquote() << QString("%1 writes (%2 ms on the encoder side), %3 fallocate, %4 syncs")
+                             .arg(stats.writes)
+                             .arg(appendMs, 0, 'f', 2)
+                             .arg(stats.preallocations)
+                             .arg(stats.syncs);
+    QFile::remove(path);
+}
+
+void VoiceInputBenchmarks::mp3_data()
+{
+    QTest::addColumn<bool>("fromClip");
+
+    QTest::newRow("synthetic") << false;
+    QTest::newRow("clip") << true;
+}
+
+void VoiceInputBenchmarks::mp3()
+{
+    QFETCH(bool, fromClip);
+    if (fromClip && m_clip.empty()) {
+        QSKIP("No clip");
+    }
+
+    // Steady-state LAME cost per worker batch at the speech rate
+    const std::vector<short> pcm = fromClip ? m_speech : makeSyntheticPcm(SPEECH_SAMPLE_RATE * 10, 7);
+    if (pcm.size() < static_cast<std::size_t>(ENCODER_BATCH_FRAMES)) {
+        QSKIP("Shorter than one batch");
+    }
+
+    Mp3Encoder encoder(ENCODER_BITRATE);
+    QVERIFY2(encoder.begin(SPEECH_SAMPLE_RATE, 1), qPrintable(encoder.lastError()));
+    QByteArray out;
+    std::size_t offset = 0;
+    const std::size_t lastOffset = pcm.size() - ENCODER_BATCH_FRAMES;
+    QBENCHMARK {
+        out.clear();
+        encoder.encode(pcm.data() + offset, ENCODER_BATCH_FRAMES, out);
+        offset = offset + ENCODER_BATCH_FRAMES > lastOffset ? 0 : offset + ENCODER_BATCH_FRAMES;
+    }
+    out.clear();
+    encoder.finish(out);
+}
+
+void VoiceInputBenchmarks::callback_data()
+{
+    QTest::addColumn<bool>("recording");
+
+    QTest::newRow("idle, into the pre-roll") << false;
+    QTest::newRow("recording, to the encoder worker") << true;
+}
+
+void VoiceInputBenchmarks::callback()
+{
+    QFETCH(bool, recording);
+
+    // The recorder's own per-buffer path, minus the PortAudio stream, for a
+    // device that delivers FALLBACK_SAMPLE_RATE
+    AudioRecorder recorder;
+    recorder.setPreRoll(BENCH_PRE_ROLL_MS);
+    recorder.configureCapture(FALLBACK_SAMPLE_RATE);
+
+    const std::vector<short> pcm = makeSyntheticPcm(FRAMES_PER_BUFFER * NUM_CHANNELS, 42);
+    const auto count = static_cast<std::size_t>(FRAMES_PER_BUFFER * NUM_CHANNELS);
+    std::vector<short> drained(recorder.m_pcmRing.capacity());
+    QBENCHMARK {
+        recorder.processCapturedAudio(pcm.data(), FRAMES_PER_BUFFER, recording, nullptr, 0);
+
+        // Stand-in for the encoder worker, amortized over a full ring
+        if (recorder.m_pcmRing.writeAvailable() < count) {
+            recorder.m_pcmRing.pop(drained.data(), drained.size());
+        }
+    }
+
+    // What the histogram in the recorder's health log would show for this path
+    if (recording) {
+        qInfo().noquote() << "Callback histogram:" << recorder.health().callbackTime.describe();
+    }
+}
+
+void VoiceInputBenchmarks::volumeBar_data()
+{
+    QTest::addColumn<bool>("render");
+
+    QTest::newRow("setLevel") << false;
+    QTest::newRow("setLevel + render") << true;
+}
+
+void VoiceInputBenchmarks::volumeBar()
+{
+    QFETCH(bool, render);
+
+    VolumeBar bar;
+    bar.resize(bar.sizeHint());
+    QImage frame(bar.size(), QImage::Format_ARGB32_Premultiplied);
+
+    // Sweep the level so every call changes some segments, as speech does;
+    // one render per METER_REFRESH_INTERVAL_MS while recording
+    int step = 0;
+    QBENCHMARK {
+        step = (step + 1) % 64;
+        const float level = static_cast<float>(step) / 64.0f;
+        bar.setLevel(level, qMin(level + 0.1f, 1.0f));
+        if (render) {
+            bar.render(&frame);
+        }
+    }
+}
+
+void VoiceInputBenchmarks::response_data()
+{
+    QTest::addColumn<int>("segments");
+
+    // One sentence, about ten minutes and about an hour of speech
+    for (int segments : {1, 150, 900}) {
+        QTest::addRow("%d segment(s)", segments) << segments;
+    }
+}
+
+void VoiceInputBenchmarks::response()
+{
+    QFETCH(int, segments);
+
+    // The real completion path: handleNetworkReply() reads the reply,
+    // parses it and emits the text, as when the request finishes
+    const QByteArray body = makeTranscriptionResponse(segments);
+    OpenAiTranscriptionService service;
+    QString text;
+    connect(&service, &TranscriptionBackend::transcriptionCompleted, this, [&text](const QString& result) {
+        text = result;
+    });
+
+    // Its per-reply log lines would swamp the results
+    QLoggingCategory::setFilterRules("default.info=false");
+    QBENCHMARK {
+        CannedReply* reply = new CannedReply(body, 200);
+        service.m_isTranscribing = true;
+        service.m_currentReply = reply;
+        service.handleNetworkReply(reply);
+        // Deleted later by the service, as after a real request
+        QCoreApplication::sendPostedEvents(nullptr, QEvent::DeferredDelete);
+    }
+    QLoggingCategory::setFilterRules(QString());
+
+    QVERIFY(!text.isEmpty());
+    qInfo().noquote() << QString("%1 KB per response").arg(body.size() / 1024.0, 0, 'f', 1);
+}
+
+void VoiceInputBenchmarks::firstByte_data()
+{
+    QTest::addColumn<bool>("persistent");
+
+    // A new QNetworkAccessManager, and with it a new connection, per request
+    // (as before), versus the long-lived one pre-connected at recording start
+    QTest::newRow("fresh manager per request") << false;
+    QTest::newRow("persistent, pre-connected") << true;
+}
+
+void VoiceInputBenchmarks::firstByte()
+{
+    QFETCH(bool, persistent);
+
+    // The stand-in on loopback: no DNS, no TLS and next to no round trip, so
+    // this is the least pre-connecting saves against the real API
+    MockTranscriptionServer server;
+    QVERIFY2(server.listen(QHostAddress::LocalHost, 0), qPrintable(server.errorString()));
+    OpenAiTranscriptionService service;
+    service.m_apiKey = "bench";
+    service.setApiBaseUrl(QString("http://127.0.0.1:%1/v1").arg(server.serverPort()));
+
+    QSharedPointer<ChunkedArena> audio =
+        QSharedPointer<ChunkedArena>::create(RECORDING_ARENA_CHUNK_BYTES, RECORDING_ARENA_MAX_CHUNKS);
+    const QByteArray payload(BENCH_FIRST_BYTE_UPLOAD_BYTES, 'a');
+    audio->append(payload.constData(), payload.size());
+    audio->finish();
+
+    int completed = 0;
+    connect(&service, &TranscriptionBackend::transcriptionCompleted, this, [&completed]() { ++completed; });
+
+    // From the transcription call until the reply reports its first body
+    // bytes written; the time in between requests is not counted
+    QVector<qint64> firstByteNs;
+    QLoggingCategory::setFilterRules("default.debug=false\ndefault.info=false");
+    for (int i = 0; i < BENCH_FIRST_BYTE_REQUESTS; ++i) {
+        if (persistent) {
+            service.preconnect();
+            QTest::qWait(BENCH_PRECONNECT_MS);
+        } else {
+            service.recreateNetworkManager();
+        }
+
+        qint64 firstNs = -1;
+        QElapsedTimer timer;
+        timer.start();
+        service.transcribeRecording(audio, AudioFormat::Mp3, "en");
+        if (!service.m_currentReply) {
+            break;
+        }
+        connect(service.m_currentReply, &QNetworkReply::uploadProgress, this,
+                [&firstNs, &timer](qint64 bytesSent, qint64) {
+                    if (bytesSent > 0 && firstNs < 0) {
+                        firstNs = timer.nsecsElapsed();
+                    }
+                });
+        QTest::qWaitFor([&]() { return completed > i || !service.isTranscribing(); }, 10000);
+        firstByteNs.append(firstNs);
+    }
+    QLoggingCategory::setFilterRules(QString());
+    QCOMPARE(completed, BENCH_FIRST_BYTE_REQUESTS);
+    QVERIFY(!firstByteNs.contains(-1));
+
+    std::sort(firstByteNs.begin(), firstByteNs.end());
+    const qint64 medianNs = firstByteNs.at(firstByteNs.size() / 2);
+    QTest::setBenchmarkResult(medianNs / 1e6, QTest::WalltimeMilliseconds);
+    qInfo().noquote() << QString("First upload byte after %1 ms (median), %2 ms (fastest), %3 ms (slowest)")
+                             .arg(medianNs / 1e6, 0, 'f', 3)
+                             .arg(firstByteNs.first() / 1e6, 0, 'f', 3)
+                             .arg(firstByteNs.last() / 1e6, 0, 'f', 3);
+}
+
+void VoiceInputBenchmarks::replay_data()
+{
+    QTest::addColumn<FileAudioSource::Pacing>("pacing");
+
+    QTest::newRow("fast") << FileAudioSource::Pacing::Fast;
+    QTest::newRow("realtime") << FileAudioSource::Pacing::RealTime;
+}
+
+void VoiceInputBenchmarks::replay()
+{
+    QFETCH(FileAudioSource::Pacing, pacing);
+    if (m_clip.empty()) {
+        QSKIP("No clip");
+    }
+
+    // A whole recording through the real recorder, fed from the clip in place
+    // of the microphone: callback, ring, resampler, trimmer, encoder worker
+    const double clipSeconds = static_cast<double>(m_clip.size()) / m_clipRate;
+    AudioRecorder recorder;
+    recorder.setInputFile(m_clipPath, pacing);
+    QVERIFY2(recorder.initializeAudioSystem(), "Cannot replay the clip");
+
+    QEventLoop loop;
+    connect(&recorder, &AudioRecorder::recordingStopped, &loop, &QEventLoop::quit);
+    QBENCHMARK_ONCE {
+        QTimer::singleShot(static_cast<int>(clipSeconds * 2000) + 10000, &loop, &QEventLoop::quit);
+        QVERIFY2(recorder.startRecording(), "Cannot start recording");
+        loop.exec();
+    }
+    if (recorder.isRecording()) {
+        recorder.stopRecording();
+        QFAIL("The recording did not stop at the end of the clip");
+    }
+
+    const AudioHealth health = recorder.health();
+    qInfo().noquote() << QString("%1 bytes, %2 s kept, %3 frames dropped")
+                             .arg(recorder.recordedAudio() ? recorder.recordedAudio()->size() : 0)
+                             .arg(recorder.recordedDurationMs() / 1000.0, 0, 'f', 2)
+                             .arg(health.droppedFrames);
+    qInfo().noquote() << "Callback time:" << health.callbackTime.describe();
+    qInfo().noquote() << "Encode time:  " << health.encodeTime.describe();
+}
+
+QTEST_MAIN(VoiceInputBenchmarks)
+
+#include "voiceinputbenchmarks.moc"
@@ -1,19 +1,121 @@
 #ifndef CONFIG_H
 #define CONFIG_H
 
-constexpr auto OUTPUT_FILE_PATH = "/tmp/voice_input_recording.mp3";
+constexpr auto OUTPUT_FILE_BASE_PATH = "/tmp/voice_input_recording"; // Extension follows the audio format
 constexpr auto TRANSCRIPTION_OUTPUT_PATH = "/tmp/voice_input_transcription.txt";
 constexpr auto LOCK_FILE_PATH = "/tmp/voice_input_lock.pid";
 constexpr auto STATUS_FILE_PATH = "/tmp/voice_input_status.txt";
 constexpr int DEFAULT_TIMEOUT = 0;           // No timeout by default
-constexpr int SAMPLE_RATE = 44100;           // CD-quality sample rate
+constexpr int SPEECH_SAMPLE_RATE = 16000;    // Rate fed to the encoder (what Whisper uses internally)
+constexpr int FALLBACK_SAMPLE_RATE = 44100;  // Capture rate if the device reports no usable default
+constexpr int MAX_CAPTURE_SAMPLE_RATE = 48000; // Upper bound used to size capture buffers
 constexpr int NUM_CHANNELS = 1;              // Mono
-constexpr int ENCODER_BITRATE = 128000;      // 128 kbps MP3 encoding
+constexpr int ENCODER_BITRATE = 48000;       // 48 kbps MP3 (MPEG-2 layer III at 16 kHz)
+constexpr int FRAMES_PER_BUFFER = 256;       // PortAudio callback size
+constexpr int FLAC_COMPRESSION_LEVEL = 5;    // libFLAC preset 0-8
+constexpr int OPUS_BITRATE = 24000;          // 24 kbps Opus, transparent for speech
+
+// Capture pipeline: the audio callback only copies PCM into a ring buffer,
+// a dedicated worker drains it in larger batches and does the encoding/IO
+constexpr int PCM_RING_BUFFER_MS = 4000;     // Capacity of the callback->encoder ring
+constexpr int FILE_INPUT_RETRY_INTERVAL_MS = 2; // --input-pacing fast: wait for ring space
+constexpr int ENCODER_BATCH_FRAMES = 4096;   // Max frames encoded per worker iteration
+constexpr int ENCODER_POLL_INTERVAL_MS = 10; // Worker sleep when the ring is empty
+constexpr int PRE_ROLL_MAX_MS = 2000;        // Longest warm-standby pre-roll (must fit the ring)
+
+// Encoded recordings are kept in memory and uploaded from there
+constexpr int RECORDING_ARENA_CHUNK_BYTES = 64 * 1024; // Allocation unit, never reallocated
+constexpr int RECORDING_ARENA_MAX_CHUNKS = 4096;       // 256 MB cap (hours of audio in any format)
+
+// --save-audio copy, written by its own thread while recording
+constexpr int FILE_WRITE_BLOCK_BYTES = 64 * 1024;           // One write syscall per block
+constexpr int FILE_WRITE_ALIGNMENT = 4096;                   // Page/sector alignment of the block buffer
+constexpr int FILE_WRITE_POLL_INTERVAL_MS = 100;             // Writer checks the recording this often
+constexpr int FILE_PREALLOCATE_MIN_BYTES = 1024 * 1024;      // First fallocate extent, doubled each time
+constexpr int FILE_PREALLOCATE_MAX_BYTES = 32 * 1024 * 1024; // Largest extent
+constexpr int FILE_SYNC_INTERVAL_MS = 1000;                  // fdatasync period with --durability periodic
+
+// --trace: one Chrome trace JSON per session (SIGUSR1 until the text is pasted)
+constexpr auto TRACE_FILE_BASE_PATH = "/tmp/voice_input_trace"; // _<timestamp>.json is appended
+constexpr int TRACE_MAX_EVENTS = 200000;     // Per session; later events are dropped
+
+// Transcription API. The base URL can be changed with --api-base-url or
+// OPENAI_BASE_URL (e.g. for a local stand-in); OPENAI_TRANSCRIPTION_URL
+// replaces the whole endpoint
+constexpr auto TRANSCRIPTION_API_BASE_URL = "https://api.openai.com/v1";
+constexpr auto TRANSCRIPTION_API_PATH = "/audio/transcriptions";    // Appended to the base URL
+constexpr int TRANSCRIPTION_RESPONSE_TIMEOUT_MS = 60000; // Once the upload is complete
+
+// --backend realtime: PCM is sent over a WebSocket while recording and the
+// server transcribes each turn (speech up to a pause) as soon as it ends
+constexpr auto REALTIME_API_PATH = "/realtime";               // Below the API base URL, ws(s)://
+constexpr auto REALTIME_TRANSCRIPTION_MODEL = "gpt-4o-transcribe";
+constexpr int REALTIME_SAMPLE_RATE = 24000;        // The only pcm16 rate the endpoint accepts
+constexpr int REALTIME_SEND_INTERVAL_MS = 100;     // How often new audio is sent
+constexpr int REALTIME_MAX_APPEND_MS = 1000;       // Audio per message when catching up
+constexpr int REALTIME_MIN_COMMIT_MS = 100;        // The server rejects committing less
+constexpr int REALTIME_VAD_SILENCE_MS = 500;       // Pause that ends a turn
+
+// Back-to-back recordings are transcribed side by side and pasted in order;
+// each job in flight has a backend instance of its own
+constexpr int TRANSCRIPTION_MAX_PARALLEL_JOBS = 2;  // Default for --jobs
+
+// Per-request latency statistics, kept across runs in the user's cache directory
+constexpr auto REQUEST_STATS_FILE_NAME = "voice_input_request_stats.json";
+constexpr int REQUEST_STATS_WINDOW = 500;       // Most recent samples kept per metric
+constexpr auto SERVER_PROCESSING_HEADER = "openai-processing-ms"; // Server-side time, in ms
+
+// Streaming upload: the request is opened when recording starts and encoded
+// audio is sent with chunked transfer encoding as it is produced
+constexpr int STREAM_UPLOAD_POLL_INTERVAL_MS = 50;       // How often new audio is picked up
+constexpr int STREAM_UPLOAD_MAX_QUEUED_BYTES = 64 * 1024; // Socket backlog before we wait
+
+// Voice activity trimming before encoding: silence before the first and after
+// the last word is dropped, and pauses are shortened to --max-pause
+constexpr int DEFAULT_MAX_PAUSE_MS = 700;        // Longest pause left in the upload
+constexpr int VAD_HANGOVER_MS = 200;             // Speech state held across dips inside words
+constexpr float VAD_MIN_SPEECH_RMS = 0.005f;     // About -46 dBFS, nothing quieter is speech
+constexpr float VAD_SPEECH_TO_NOISE_RATIO = 3.0f; // About +10 dB over the noise floor
+constexpr int AUTO_STOP_MIN_SPEECH_MS = 300;     // Speech needed before --auto-stop may end a recording
+
+// Long recordings are split at pauses and the pieces transcribed in parallel
+constexpr int SEGMENT_TARGET_SECONDS = 30;     // Cut at the first pause after this
+constexpr int SEGMENT_MAX_SECONDS = 60;        // Cut here even without a pause
+constexpr int SEGMENT_MAX_BYTES = 24 * 1024 * 1024; // Below the API's 25 MB upload limit
+constexpr int SEGMENT_MIN_PAUSE_MS = 300;      // Quiet time that counts as a pause
+constexpr float SEGMENT_SILENCE_RMS = 0.01f;   // About -40 dBFS
+constexpr int TRANSCRIPTION_MAX_PARALLEL_SEGMENTS = 4; // Requests in flight at once
+
+// Retries of failed requests (whole recordings and segments alike)
+constexpr int RETRY_MAX_ATTEMPTS = 4;          // Per request, including the first try
+constexpr int RETRY_BASE_DELAY_MS = 500;       // Backoff before the first retry, doubled after that
+constexpr int RETRY_MAX_DELAY_MS = 8000;
+constexpr int RETRY_DEADLINE_BASE_MS = 20000;  // Give up on a transcription after this...
+constexpr double RETRY_DEADLINE_PER_AUDIO_MS = 1.0; // ...plus this much per millisecond of audio
+constexpr int RETRY_DEADLINE_MAX_MS = 180000;
+constexpr int TRANSCRIPTION_STALL_TIMEOUT_MS = 10000; // No bytes moving while uploading or receiving
+
+// --hedge: once an upload has waited longer than the p95 time to first byte
+// of recent requests, the same audio is sent again and the first success wins
+constexpr int HEDGE_MIN_SAMPLES = 20;          // Recent requests needed before trusting the p95
+constexpr int HEDGE_DEFAULT_DELAY_MS = 5000;   // Until then
+constexpr int HEDGE_MIN_DELAY_MS = 1000;
+constexpr int HEDGE_MAX_DELAY_MS = 20000;
+
+// Resampler used when the device can't capture at SPEECH_SAMPLE_RATE directly
+constexpr int RESAMPLER_TAPS_PER_PHASE = 48;   // Filter length per polyphase branch
+constexpr double RESAMPLER_CUTOFF = 0.9;       // Passband edge relative to the lower Nyquist
+constexpr double RESAMPLER_KAISER_BETA = 8.0;  // ~80 dB stopband attenuation
+
+// Level metering
+constexpr int LEVEL_CLIP_THRESHOLD = 32767;    // |sample| at or above this counts as clipped
 
 // Volume Visualization Settings
-constexpr float VOLUME_SCALING_FACTOR = 5.0f;  // Amplify volume for better visualization
+constexpr float VOLUME_SCALING_FACTOR = 5.0f;  // Amplify RMS level for better visualization
 constexpr float VOLUME_LOG_BASE = 20.0f;       // Higher values make small sounds more visible
 constexpr float VOLUME_MIN_THRESHOLD = 0.001f; // Minimum volume to register any display
+constexpr float PEAK_HOLD_DECAY_PER_SECOND = 1.5f; // How fast the peak marker falls back
+constexpr int METER_REFRESH_INTERVAL_MS = 33;  // UI polls the level snapshot at ~30 fps
 
 // Base styles with consistent formatting
 constexpr auto STYLE_STATUS_NEUTRAL = "font-weight: bold; font-size: 12pt; color: #5CAAFF;";
@@ -0,0 +1,34 @@
+#include "arenadevice.h"
+
+ArenaDevice::ArenaDevice(QSharedPointer<const ChunkedArena> arena, QObject* parent)
+    : QIODevice(parent),
+      m_arena(std::move(arena))
+{
+}
+
+bool ArenaDevice::open(OpenMode mode)
+{
+    if (mode & WriteOnly) {
+        return false;
+    }
+    return QIODevice::open(mode | Unbuffered);
+}
+
+qint64 ArenaDevice::size() const
+{
+    return m_arena ? m_arena->size() : 0;
+}
+
+qint64 ArenaDevice::readData(char* data, qint64 maxSize)
+{
+    if (!m_arena) {
+        return -1;
+    }
+    // QIODevice advances pos() by what we return; 0 at the end signals EOF
+    return m_arena->read(pos(), data, maxSize);
+}
+
+qint64 ArenaDevice::writeData(const char* /*data*/, qint64 /*maxSize*/)
+{
+    return -1;
+}
@@ -0,0 +1,31 @@
+#ifndef ARENADEVICE_H
+#define ARENADEVICE_H
+
+#include <QIODevice>
+#include <QSharedPointer>
+
+#include "chunkedarena.h"
+
+// Read-only, random-access QIODevice over a ChunkedArena. Reads copy straight
+// from the arena chunks into the caller's buffer, so an upload never needs the
+// recording as one contiguous QByteArray or as a file.
+class ArenaDevice : public QIODevice
+{
+    Q_OBJECT
+public:
+    explicit ArenaDevice(QSharedPointer<const ChunkedArena> arena, QObject* parent = nullptr);
+
+    // Read-only; always unbuffered (like QBuffer) since the data is already in memory
+    bool open(OpenMode mode) override;
+    bool isSequential() const override { return false; }
+    qint64 size() const override;
+
+protected:
+    qint64 readData(char* data, qint64 maxSize) override;
+    qint64 writeData(const char* data, qint64 maxSize) override;
+
+private:
+    QSharedPointer<const ChunkedArena> m_arena;
+};
+
+#endif // ARENADEVICE_H
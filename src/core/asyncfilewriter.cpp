@@ -0,0 +1,272 @@
+#include "asyncfilewriter.h"
+
+#include <QDebug>
+#include <QFile>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "config/config.h"
+
+namespace {
+
+qint64 nowNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+} // namespace
+
+AsyncFileWriter::AsyncFileWriter(QSharedPointer<const ChunkedArena> source, const QString& path, Durability durability)
+    : m_source(source),
+      m_path(path),
+      m_durability(durability),
+      m_block(nullptr),
+      m_allocatedEnd(0),
+      m_nextExtent(FILE_PREALLOCATE_MIN_BYTES),
+      m_preallocateSupported(true),
+      m_finishRequested(false),
+      m_done(false)
+{
+}
+
+AsyncFileWriter::~AsyncFileWriter()
+{
+    finish();
+    wait();
+    std::free(m_block);
+}
+
+void AsyncFileWriter::start(std::unique_ptr<AsyncFileWriter> previous)
+{
+    m_previous = std::move(previous);
+    if (!m_thread.joinable() && !m_done.load(std::memory_order_acquire)) {
+        m_thread = std::thread(&AsyncFileWriter::run, this);
+    }
+}
+
+void AsyncFileWriter::finish()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_finishRequested = true;
+    }
+    m_wake.notify_one();
+}
+
+void AsyncFileWriter::wait()
+{
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+}
+
+AsyncFileWriter::Stats AsyncFileWriter::stats() const
+{
+    std::lock_guard<std::mutex> lock(m_statsMutex);
+    return m_stats;
+}
+
+QString AsyncFileWriter::lastError() const
+{
+    std::lock_guard<std::mutex> lock(m_statsMutex);
+    return m_lastError;
+}
+
+bool AsyncFileWriter::parseDurability(const QString& name, Durability* durability)
+{
+    const QString key = name.trimmed().toLower();
+    if (key == "none") {
+        *durability = Durability::None;
+    } else if (key == "periodic") {
+        *durability = Durability::Periodic;
+    } else if (key == "stop") {
+        *durability = Durability::OnStop;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+QString AsyncFileWriter::durabilityName(Durability durability)
+{
+    switch (durability) {
+    case Durability::None:      return "none";
+    case Durability::Periodic:  return "periodic";
+    case Durability::OnStop:    return "stop";
+    }
+    return QString();
+}
+
+void AsyncFileWriter::run()
+{
+    // The arena keeps everything appended meanwhile; nothing is lost by
+    // opening the file only once the previous copy is closed
+    m_previous.reset();
+
+    const int fd = ::open(QFile::encodeName(m_path).constData(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        fail(QString("Cannot open %1: %2").arg(m_path, QString::fromLocal8Bit(std::strerror(errno))));
+        m_done.store(true, std::memory_order_release);
+        return;
+    }
+    if (posix_memalign(reinterpret_cast<void**>(&m_block), FILE_WRITE_ALIGNMENT, FILE_WRITE_BLOCK_BYTES) != 0) {
+        m_block = nullptr;
+        fail("Cannot allocate the write buffer");
+        ::close(fd);
+        m_done.store(true, std::memory_order_release);
+        return;
+    }
+
+    qint64 written = 0;
+    qint64 lastSyncNs = nowNs();
+    bool ok = true;
+    while (ok) {
+        // Sample the flag before the size so nothing appended before finish() is missed
+        bool finishing = false;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            finishing = m_finishRequested;
+        }
+        const bool complete = m_source->isFinished();
+        const qint64 available = m_source->size();
+
+        // Only whole blocks while recording: every write starts block-aligned
+        while (ok && available - written >= FILE_WRITE_BLOCK_BYTES) {
+            ok = writeRange(fd, written, FILE_WRITE_BLOCK_BYTES);
+            written += FILE_WRITE_BLOCK_BYTES;
+        }
+
+        if (ok && (complete || finishing)) {
+            if (available > written) {
+                ok = writeRange(fd, written, available - written);
+                written = available;
+            }
+            // Headers (WAV sizes, FLAC STREAMINFO) are patched in the arena
+            // just before it finishes, possibly after block 0 went out
+            if (ok && written > 0) {
+                ok = writeRange(fd, 0, qMin<qint64>(written, FILE_WRITE_BLOCK_BYTES));
+            }
+            break;
+        }
+
+        if (m_durability == Durability::Periodic && nowNs() - lastSyncNs >= qint64(FILE_SYNC_INTERVAL_MS) * 1000000) {
+            sync(fd);
+            lastSyncNs = nowNs();
+        }
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_wake.wait_for(lock, std::chrono::milliseconds(FILE_WRITE_POLL_INTERVAL_MS),
+                        [this]() { return m_finishRequested; });
+    }
+
+    // Give back the preallocated space past the end
+    if (ok && ::ftruncate(fd, written) != 0) {
+        fail(QString("Cannot truncate %1: %2").arg(m_path, QString::fromLocal8Bit(std::strerror(errno))));
+    }
+    if (ok && m_durability != Durability::None) {
+        sync(fd);
+    }
+    ::close(fd);
+
+    const Stats s = stats();
+    if (ok && written == 0) {
+        ::unlink(QFile::encodeName(m_path).constData());
+    } else if (ok) {
+        qInfo().noquote() << QString("Saved %1 bytes to %2: %3 writes (avg %4 us, max %5 us), %6 preallocations "
+                                     "(%7 bytes), %8 syncs (max %9 ms, durability: %10)")
+                                 .arg(written)
+                                 .arg(m_path)
+                                 .arg(s.writes)
+                                 .arg(s.writes > 0 ? s.writeNsTotal / s.writes / 1000.0 : 0.0, 0, 'f', 1)
+                                 .arg(s.writeNsMax / 1000.0, 0, 'f', 1)
+                                 .arg(s.preallocations)
+                                 .arg(s.preallocatedBytes)
+                                 .arg(s.syncs)
+                                 .arg(s.syncNsMax / 1e6, 0, 'f', 2)
+                                 .arg(durabilityName(m_durability));
+    }
+    m_done.store(true, std::memory_order_release);
+}
+
+bool AsyncFileWriter::writeRange(int fd, qint64 offset, qint64 length)
+{
+    preallocate(fd, offset + length);
+
+    const qint64 copied = m_source->read(offset, m_block, length);
+    qint64 done = 0;
+    const qint64 startNs = nowNs();
+    qint64 calls = 0;
+    while (done < copied) {
+        const ssize_t n = ::pwrite(fd, m_block + done, static_cast<std::size_t>(copied - done), offset + done);
+        ++calls;
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            fail(QString("Cannot write %1: %2").arg(m_path, QString::fromLocal8Bit(std::strerror(errno))));
+            return false;
+        }
+        done += n;
+    }
+    const qint64 elapsedNs = nowNs() - startNs;
+
+    std::lock_guard<std::mutex> lock(m_statsMutex);
+    m_stats.writes += calls;
+    m_stats.bytesWritten += done;
+    m_stats.writeNsTotal += elapsedNs;
+    m_stats.writeNsMax = qMax(m_stats.writeNsMax, elapsedNs);
+    return true;
+}
+
+void AsyncFileWriter::preallocate(int fd, qint64 end)
+{
+    if (!m_preallocateSupported || end <= m_allocatedEnd) {
+        return;
+    }
+
+#ifdef __linux__
+    // Reserve ahead in doubling extents; KEEP_SIZE leaves the visible file
+    // size alone so a reader never sees the unwritten tail
+    const qint64 extent = qMax(m_nextExtent, end - m_allocatedEnd);
+    if (::fallocate(fd, FALLOC_FL_KEEP_SIZE, m_allocatedEnd, extent) != 0) {
+        // tmpfs and some network filesystems do not support it; plain writes still work
+        m_preallocateSupported = false;
+        return;
+    }
+    m_allocatedEnd += extent;
+    m_nextExtent = qMin<qint64>(m_nextExtent * 2, FILE_PREALLOCATE_MAX_BYTES);
+
+    std::lock_guard<std::mutex> lock(m_statsMutex);
+    ++m_stats.preallocations;
+    m_stats.preallocatedBytes += extent;
+#else
+    Q_UNUSED(fd);
+    m_preallocateSupported = false;
+#endif
+}
+
+void AsyncFileWriter::sync(int fd)
+{
+    const qint64 startNs = nowNs();
+    if (::fdatasync(fd) != 0) {
+        qWarning() << "fdatasync failed for" << m_path << ":" << std::strerror(errno);
+    }
+    const qint64 elapsedNs = nowNs() - startNs;
+
+    std::lock_guard<std::mutex> lock(m_statsMutex);
+    ++m_stats.syncs;
+    m_stats.syncNsTotal += elapsedNs;
+    m_stats.syncNsMax = qMax(m_stats.syncNsMax, elapsedNs);
+}
+
+void AsyncFileWriter::fail(const QString& error)
+{
+    qWarning().noquote() << error;
+    std::lock_guard<std::mutex> lock(m_statsMutex);
+    m_lastError = error;
+}
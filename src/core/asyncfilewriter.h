@@ -0,0 +1,99 @@
+#ifndef ASYNCFILEWRITER_H
+#define ASYNCFILEWRITER_H
+
+#include <QSharedPointer>
+#include <QString>
+#include <QtGlobal>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "chunkedarena.h"
+
+// Copies a recording to disk while it is still being encoded. A dedicated
+// thread follows the arena and writes it in large block-aligned pieces, so
+// the file sees one write per block instead of one per encoder frame. The
+// file is preallocated in growing extents and synced per the durability
+// policy. Once the arena is finished the tail and the (possibly patched)
+// header are written and the file is closed, all off the caller's thread.
+class AsyncFileWriter
+{
+public:
+    enum class Durability
+    {
+        None,       // Leave flushing to the kernel
+        Periodic,   // fdatasync every FILE_SYNC_INTERVAL_MS and at the end
+        OnStop      // fdatasync once, after the last write
+    };
+
+    struct Stats
+    {
+        qint64 writes = 0;          // write syscalls
+        qint64 bytesWritten = 0;
+        qint64 writeNsTotal = 0;
+        qint64 writeNsMax = 0;
+        qint64 preallocations = 0;  // fallocate calls
+        qint64 preallocatedBytes = 0;
+        qint64 syncs = 0;           // fdatasync calls
+        qint64 syncNsTotal = 0;
+        qint64 syncNsMax = 0;
+    };
+
+    AsyncFileWriter(QSharedPointer<const ChunkedArena> source, const QString& path, Durability durability);
+    ~AsyncFileWriter();
+
+    AsyncFileWriter(const AsyncFileWriter&) = delete;
+    AsyncFileWriter& operator=(const AsyncFileWriter&) = delete;
+
+    // `previous` is the writer of the last recording, usually to the same
+    // path; the new thread finishes and joins it before opening the file, so
+    // its final sync never blocks the caller
+    void start(std::unique_ptr<AsyncFileWriter> previous = nullptr);
+
+    // The arena is finished: write the rest and close, without waiting
+    void finish();
+
+    // Block until the file is complete and closed
+    void wait();
+
+    bool isDone() const { return m_done.load(std::memory_order_acquire); }
+    Stats stats() const;
+    QString lastError() const;
+    QString path() const { return m_path; }
+
+    static bool parseDurability(const QString& name, Durability* durability);
+    static QString durabilityName(Durability durability);
+
+private:
+    void run();
+    bool writeRange(int fd, qint64 offset, qint64 length);
+    void preallocate(int fd, qint64 end);
+    void sync(int fd);
+    void fail(const QString& error);
+
+private:
+    QSharedPointer<const ChunkedArena> m_source;
+    const QString       m_path;
+    const Durability    m_durability;
+
+    // Block-aligned staging buffer, owned by the writer thread
+    char*               m_block;
+    qint64              m_allocatedEnd;     // File space reserved so far
+    qint64              m_nextExtent;
+    bool                m_preallocateSupported;
+
+    std::unique_ptr<AsyncFileWriter> m_previous;    // Joined by run() first
+    std::thread             m_thread;
+    std::mutex              m_mutex;
+    std::condition_variable m_wake;
+    bool                    m_finishRequested;
+    std::atomic<bool>       m_done;
+
+    mutable std::mutex  m_statsMutex;
+    Stats               m_stats;
+    QString             m_lastError;
+};
+
+#endif // ASYNCFILEWRITER_H
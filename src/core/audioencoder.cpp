@@ -0,0 +1,120 @@
+#include "audioencoder.h"
+
+#include "config/config.h"
+#include "mp3encoder.h"
+#include "wavencoder.h"
+#ifdef HAVE_FLAC
+#include "flacencoder.h"
+#endif
+#ifdef HAVE_OPUS
+#include "oggopusencoder.h"
+#endif
+
+namespace {
+
+const AudioFormat ALL_FORMATS[] = {AudioFormat::Mp3, AudioFormat::Wav, AudioFormat::Flac, AudioFormat::Opus};
+
+} // namespace
+
+std::unique_ptr<AudioEncoder> createAudioEncoder(AudioFormat format)
+{
+    switch (format) {
+    case AudioFormat::Mp3:
+        return std::unique_ptr<AudioEncoder>(new Mp3Encoder(ENCODER_BITRATE));
+    case AudioFormat::Wav:
+        return std::unique_ptr<AudioEncoder>(new WavEncoder());
+#ifdef HAVE_FLAC
+    case AudioFormat::Flac:
+        return std::unique_ptr<AudioEncoder>(new FlacEncoder(FLAC_COMPRESSION_LEVEL));
+#endif
+#ifdef HAVE_OPUS
+    case AudioFormat::Opus:
+        return std::unique_ptr<AudioEncoder>(new OggOpusEncoder(OPUS_BITRATE));
+#endif
+    default:
+        return nullptr;
+    }
+}
+
+bool isAudioFormatAvailable(AudioFormat format)
+{
+    switch (format) {
+    case AudioFormat::Mp3:
+    case AudioFormat::Wav:
+        return true;
+    case AudioFormat::Flac:
+#ifdef HAVE_FLAC
+        return true;
+#else
+        return false;
+#endif
+    case AudioFormat::Opus:
+#ifdef HAVE_OPUS
+        return true;
+#else
+        return false;
+#endif
+    }
+    return false;
+}
+
+QStringList availableAudioFormatNames()
+{
+    QStringList names;
+    for (AudioFormat format : ALL_FORMATS) {
+        if (isAudioFormatAvailable(format)) {
+            names << audioFormatName(format);
+        }
+    }
+    return names;
+}
+
+QString audioFormatName(AudioFormat format)
+{
+    switch (format) {
+    case AudioFormat::Mp3:  return "mp3";
+    case AudioFormat::Wav:  return "wav";
+    case AudioFormat::Flac: return "flac";
+    case AudioFormat::Opus: return "opus";
+    }
+    return QString();
+}
+
+bool parseAudioFormat(const QString& name, AudioFormat* format)
+{
+    const QString normalized = name.trimmed().toLower();
+    for (AudioFormat candidate : ALL_FORMATS) {
+        if (audioFormatName(candidate) == normalized) {
+            *format = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+QString audioFormatExtension(AudioFormat format)
+{
+    switch (format) {
+    case AudioFormat::Mp3:  return "mp3";
+    case AudioFormat::Wav:  return "wav";
+    case AudioFormat::Flac: return "flac";
+    case AudioFormat::Opus: return "ogg";
+    }
+    return QString();
+}
+
+QString audioFormatMimeType(AudioFormat format)
+{
+    switch (format) {
+    case AudioFormat::Mp3:  return "audio/mpeg";
+    case AudioFormat::Wav:  return "audio/wav";
+    case AudioFormat::Flac: return "audio/flac";
+    case AudioFormat::Opus: return "audio/ogg";
+    }
+    return QString();
+}
+
+QString recordingFilePath(AudioFormat format)
+{
+    return QString("%1.%2").arg(OUTPUT_FILE_BASE_PATH, audioFormatExtension(format));
+}
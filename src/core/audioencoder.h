@@ -0,0 +1,67 @@
+#ifndef AUDIOENCODER_H
+#define AUDIOENCODER_H
+
+#include <QByteArray>
+#include <QString>
+#include <QStringList>
+#include <memory>
+
+// Container/codec the recording is encoded to
+enum class AudioFormat
+{
+    Mp3,    // LAME, CBR
+    Wav,    // Raw PCM, no encoding cost
+    Flac,   // Lossless
+    Opus    // Opus in Ogg, smallest uploads
+};
+
+// Streaming encoder for 16-bit PCM. Output is appended to the caller's buffer
+// so it can go to a file, memory or the network without the encoder caring.
+class AudioEncoder
+{
+public:
+    virtual ~AudioEncoder() = default;
+
+    virtual AudioFormat format() const = 0;
+
+    // Prepare a new stream; any previous stream is discarded
+    virtual bool begin(int sampleRate, int channels) = 0;
+
+    // Encode `frames` interleaved frames and append the output to `out`
+    virtual bool encode(const short* pcm, int frames, QByteArray& out) = 0;
+
+    // Flush everything still buffered and end the stream
+    virtual bool finish(QByteArray& out) = 0;
+
+    // Header to write over the start of the output once its total size is
+    // known; empty when the format needs no patching
+    virtual QByteArray finalHeader(qint64 totalBytes) const
+    {
+        Q_UNUSED(totalBytes);
+        return QByteArray();
+    }
+
+    QString lastError() const { return m_lastError; }
+
+protected:
+    QString m_lastError;
+};
+
+// Factory; returns nullptr if the format was not compiled in
+std::unique_ptr<AudioEncoder> createAudioEncoder(AudioFormat format);
+
+bool isAudioFormatAvailable(AudioFormat format);
+QStringList availableAudioFormatNames();
+
+// Name used on the command line ("mp3", "wav", "flac", "opus")
+QString audioFormatName(AudioFormat format);
+bool parseAudioFormat(const QString& name, AudioFormat* format);
+
+// File extension and MIME type understood by the transcription API
+QString audioFormatExtension(AudioFormat format);
+QString audioFormatMimeType(AudioFormat format);
+
+// Path of the recording file for the given format
+QString recordingFilePath(AudioFormat format);
+
+#endif // AUDIOENCODER_H
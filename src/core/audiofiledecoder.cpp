@@ -0,0 +1,146 @@
+#include "audiofiledecoder.h"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QtEndian>
+#include <cstring>
+#include <lame/lame.h>
+
+namespace {
+
+// hip_decode1_headers() returns at most one MPEG frame (1152 samples) per call
+constexpr int HIP_PCM_BUFFER_SAMPLES = 4608;
+constexpr int HIP_FEED_BYTES = 4096;
+
+bool fail(QString* errorMessage, const QString& message)
+{
+    if (errorMessage) {
+        *errorMessage = message;
+    }
+    return false;
+}
+
+void appendMixed(std::vector<short>& out, const short* left, const short* right, int samples, int channels)
+{
+    if (channels < 2) {
+        out.insert(out.end(), left, left + samples);
+        return;
+    }
+    for (int i = 0; i < samples; ++i) {
+        out.push_back(static_cast<short>((static_cast<int>(left[i]) + right[i]) / 2));
+    }
+}
+
+bool decodeMp3(QByteArray& bytes, DecodedAudio& audio, QString* errorMessage)
+{
+    hip_t hip = hip_decode_init();
+    if (!hip) {
+        return fail(errorMessage, "Failed to initialize MP3 decoder");
+    }
+
+    mp3data_struct mp3data;
+    std::memset(&mp3data, 0, sizeof(mp3data));
+    std::vector<short> left(HIP_PCM_BUFFER_SAMPLES);
+    std::vector<short> right(HIP_PCM_BUFFER_SAMPLES);
+
+    auto* data = reinterpret_cast<unsigned char*>(bytes.data());
+    const std::size_t size = static_cast<std::size_t>(bytes.size());
+    std::size_t offset = 0;
+    bool ok = true;
+
+    while (offset < size && ok) {
+        const std::size_t length = std::min<std::size_t>(HIP_FEED_BYTES, size - offset);
+        int decoded = hip_decode1_headers(hip, data + offset, length, left.data(), right.data(), &mp3data);
+        offset += length;
+
+        // Drain every frame that is complete with the data fed so far
+        while (decoded > 0) {
+            appendMixed(audio.samples, left.data(), right.data(), decoded, mp3data.stereo);
+            decoded = hip_decode1_headers(hip, data, 0, left.data(), right.data(), &mp3data);
+        }
+        if (decoded < 0) {
+            ok = fail(errorMessage, "MP3 decoding error");
+        }
+    }
+
+    hip_decode_exit(hip);
+    if (!ok) {
+        return false;
+    }
+    if (!mp3data.header_parsed || mp3data.samplerate <= 0) {
+        return fail(errorMessage, "No MP3 frames found");
+    }
+
+    audio.sampleRate = mp3data.samplerate;
+    return true;
+}
+
+bool decodeWav(const QByteArray& bytes, DecodedAudio& audio, QString* errorMessage)
+{
+    const auto* data = reinterpret_cast<const uchar*>(bytes.constData());
+    const int size = bytes.size();
+    if (size < 12 || std::memcmp(data, "RIFF", 4) != 0 || std::memcmp(data + 8, "WAVE", 4) != 0) {
+        return fail(errorMessage, "Not a RIFF/WAVE file");
+    }
+
+    int channels = 0;
+    int bitsPerSample = 0;
+    int offset = 12;
+    while (offset + 8 <= size) {
+        const char* chunkId = reinterpret_cast<const char*>(data + offset);
+        quint32 chunkSize = qFromLittleEndian<quint32>(data + offset + 4);
+        const int body = offset + 8;
+
+        if (std::memcmp(chunkId, "fmt ", 4) == 0 && body + 16 <= size) {
+            const quint16 format = qFromLittleEndian<quint16>(data + body);
+            channels = qFromLittleEndian<quint16>(data + body + 2);
+            audio.sampleRate = static_cast<int>(qFromLittleEndian<quint32>(data + body + 4));
+            bitsPerSample = qFromLittleEndian<quint16>(data + body + 14);
+            if (format != 1 || bitsPerSample != 16 || channels < 1) {
+                return fail(errorMessage, "Only 16-bit PCM WAV files are supported");
+            }
+        } else if (std::memcmp(chunkId, "data", 4) == 0) {
+            if (channels == 0) {
+                return fail(errorMessage, "WAV data chunk before fmt chunk");
+            }
+            // Streamed WAVs may carry a placeholder size; clamp to what is there
+            chunkSize = qMin<quint32>(chunkSize, static_cast<quint32>(size - body));
+            const int frames = static_cast<int>(chunkSize / (2u * channels));
+            audio.samples.reserve(static_cast<std::size_t>(frames));
+            for (int i = 0; i < frames; ++i) {
+                int mixed = 0;
+                for (int c = 0; c < channels; ++c) {
+                    mixed += qFromLittleEndian<qint16>(data + body + (i * channels + c) * 2);
+                }
+                audio.samples.push_back(static_cast<short>(mixed / channels));
+            }
+            return true;
+        }
+
+        offset = body + static_cast<int>(chunkSize + (chunkSize & 1u));
+    }
+
+    return fail(errorMessage, "WAV file has no data chunk");
+}
+
+} // namespace
+
+bool decodeAudioFile(const QString& path, DecodedAudio& audio, QString* errorMessage)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return fail(errorMessage, "Could not open audio file: " + file.errorString());
+    }
+    QByteArray bytes = file.readAll();
+    file.close();
+
+    audio = DecodedAudio();
+    const QString suffix = QFileInfo(path).suffix().toLower();
+    if (suffix == "wav") {
+        return decodeWav(bytes, audio, errorMessage);
+    }
+    if (suffix == "mp3") {
+        return decodeMp3(bytes, audio, errorMessage);
+    }
+    return fail(errorMessage, "Unsupported audio file type: " + suffix);
+}
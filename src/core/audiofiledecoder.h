@@ -0,0 +1,23 @@
+#ifndef AUDIOFILEDECODER_H
+#define AUDIOFILEDECODER_H
+
+#include <QString>
+#include <vector>
+
+// Mono 16-bit PCM decoded from an audio file
+struct DecodedAudio
+{
+    int                sampleRate = 0;
+    std::vector<short> samples;
+
+    double durationSeconds() const
+    {
+        return sampleRate > 0 ? static_cast<double>(samples.size()) / sampleRate : 0.0;
+    }
+};
+
+// Decode an MP3 (through LAME's hip decoder) or a 16-bit PCM WAV file.
+// Multi-channel input is mixed down to mono.
+bool decodeAudioFile(const QString& path, DecodedAudio& audio, QString* errorMessage = nullptr);
+
+#endif // AUDIOFILEDECODER_H
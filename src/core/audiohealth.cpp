@@ -0,0 +1,66 @@
+#include "audiohealth.h"
+
+namespace {
+
+qint64 bucketUpperUs(int bucket)
+{
+    return bucket == 0 ? 1 : (qint64(1) << bucket);
+}
+
+} // namespace
+
+void DurationHistogram::reset()
+{
+    for (std::atomic<qint64>& bucket : m_buckets) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+    m_totalNs.store(0, std::memory_order_relaxed);
+    m_maxNs.store(0, std::memory_order_relaxed);
+    m_count.store(0, std::memory_order_release);
+}
+
+DurationHistogram::Summary DurationHistogram::summary() const
+{
+    Summary summary;
+    summary.count = m_count.load(std::memory_order_acquire);
+    qint64 total = 0;
+    for (int i = 0; i < BucketCount; ++i) {
+        summary.buckets[i] = m_buckets[i].load(std::memory_order_relaxed);
+        total += summary.buckets[i];
+    }
+    summary.maxUs = m_maxNs.load(std::memory_order_relaxed) / 1000;
+    if (total == 0) {
+        return summary;
+    }
+    summary.meanUs = m_totalNs.load(std::memory_order_relaxed) / total / 1000;
+
+    // Bucket bounds are what we know; that is precise enough to spot outliers
+    qint64 seen = 0;
+    for (int i = 0; i < BucketCount; ++i) {
+        seen += summary.buckets[i];
+        if (summary.p50Us == 0 && seen * 2 >= total) {
+            summary.p50Us = bucketUpperUs(i);
+        }
+        if (seen * 100 >= total * 99) {
+            summary.p99Us = bucketUpperUs(i);
+            break;
+        }
+    }
+    return summary;
+}
+
+QString DurationHistogram::Summary::describe() const
+{
+    if (count == 0) {
+        return "no samples";
+    }
+
+    QString text = QString("n=%1 mean=%2us p50<=%3us p99<=%4us max=%5us |")
+                       .arg(count).arg(meanUs).arg(p50Us).arg(p99Us).arg(maxUs);
+    for (int i = 0; i < BucketCount; ++i) {
+        if (buckets[i] > 0) {
+            text += QString(" <%1us:%2").arg(bucketUpperUs(i)).arg(buckets[i]);
+        }
+    }
+    return text;
+}
@@ -0,0 +1,82 @@
+#ifndef AUDIOHEALTH_H
+#define AUDIOHEALTH_H
+
+#include <QString>
+#include <QtGlobal>
+#include <atomic>
+
+// Lock-free histogram of durations in power-of-two microsecond buckets.
+// One thread records (the audio callback or the encoder worker), any thread
+// may read; readers get a slightly stale but consistent-enough picture.
+class DurationHistogram
+{
+public:
+    // Bucket 0 holds < 1 us, bucket i holds [2^(i-1), 2^i) us, the last one
+    // everything above
+    static constexpr int BucketCount = 24;
+
+    struct Summary
+    {
+        qint64 count = 0;
+        qint64 meanUs = 0;
+        qint64 p50Us = 0;       // Upper bound of the bucket holding the percentile
+        qint64 p99Us = 0;
+        qint64 maxUs = 0;
+        qint64 buckets[BucketCount] = {};
+
+        QString describe() const;
+    };
+
+    DurationHistogram() { reset(); }
+
+    // Writer side; real-time safe
+    void record(qint64 ns)
+    {
+        qint64 us = ns / 1000;
+        int bucket = 0;
+        while (us > 0 && bucket < BucketCount - 1) {
+            us >>= 1;
+            ++bucket;
+        }
+        // Single writer: plain load/store is enough and avoids locked instructions
+        m_buckets[bucket].store(m_buckets[bucket].load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        m_totalNs.store(m_totalNs.load(std::memory_order_relaxed) + ns, std::memory_order_relaxed);
+        if (ns > m_maxNs.load(std::memory_order_relaxed)) {
+            m_maxNs.store(ns, std::memory_order_relaxed);
+        }
+        m_count.store(m_count.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    // Only from the writer thread, or while it is not running
+    void reset();
+
+    Summary summary() const;
+
+private:
+    std::atomic<qint64> m_buckets[BucketCount];
+    std::atomic<qint64> m_count;
+    std::atomic<qint64> m_totalNs;
+    std::atomic<qint64> m_maxNs;
+};
+
+// Health of the capture path for one recording, see AudioRecorder::health()
+struct AudioHealth
+{
+    quint64 callbacks = 0;
+    quint64 inputOverflows = 0;     // paInputOverflow: the device dropped samples before us
+    quint64 inputUnderflows = 0;    // paInputUnderflow: gaps were filled in
+    quint64 droppedFrames = 0;      // PCM ring full: we dropped samples
+    qint64  maxBacklogFrames = 0;   // Deepest the ring got (frames waiting for the encoder)
+    qint64  backlogCapacityFrames = 0;
+
+    // From PaStreamCallbackTimeInfo; -1 when the host API does not report it
+    qint64  inputLatencyMinUs = -1; // currentTime - inputBufferAdcTime
+    qint64  inputLatencyMaxUs = -1;
+    qint64  inputLatencyDriftUs = 0; // Last minus first
+    qint64  clockDriftUs = 0;       // Stream time elapsed minus frames delivered
+
+    DurationHistogram::Summary callbackTime;
+    DurationHistogram::Summary encodeTime;  // Resample + trim + encode per worker batch
+};
+
+#endif // AUDIOHEALTH_H
@@ -1,44 +1,244 @@
 #include "audiorecorder.h"
 #include <QDebug>
-#include <QFileInfo>
 #include <QDateTime>
+#include <QElapsedTimer>
+#include <QThread>
+#include <algorithm>
+#include <chrono>
 
 #include "config/config.h"
+#include "levelmeter.h"
+#include "tracer.h"
 
 AudioRecorder::AudioRecorder(QObject* parent)
     : QObject(parent),
       m_stream(nullptr),
+      m_captureSampleRate(SPEECH_SAMPLE_RATE),
+      m_inputPacing(FileAudioSource::Pacing::RealTime),
+      m_pcmRing(static_cast<std::size_t>(MAX_CAPTURE_SAMPLE_RATE) * NUM_CHANNELS * PCM_RING_BUFFER_MS / 1000),
+      m_encodeBatch(static_cast<std::size_t>(ENCODER_BATCH_FRAMES) * NUM_CHANNELS),
+      m_encoderStopRequested(false),
+      m_droppedFrames(0),
+      m_clippedSamples(0),
+      m_bytesWritten(0),
+      m_recordingGeneration(0),
+      m_peakHold(0.0f),
+      m_callbackFrames(0),
+      m_callbackGeneration(0),
+      m_callbackRecording(false),
+      m_preRollWrite(0),
+      m_preRollFill(0),
+      m_preRollMs(0),
+      m_callbackPushing(false),
+      m_startRequestedNs(0),
+      m_startLatencyUs(-1),
+      m_preRollCoveredUs(-1),
       m_isRecording(false),
       m_audioDeviceInitialized(false),
-      m_currentVolume(0.0f),
-      m_lameGlobal(nullptr),
-      m_mp3Initialized(false)
+      m_audioFormat(AudioFormat::Mp3),
+      m_saveToFile(false),
+      m_saveDurability(AsyncFileWriter::Durability::None),
+      m_arenaOverflowBytes(0),
+      m_encodedFrames(0),
+      m_segmentationEnabled(false),
+      m_trimSilence(true),
+      m_maxPauseMs(DEFAULT_MAX_PAUSE_MS),
+      m_autoStopSilenceMs(0),
+      m_autoStopPosted(false),
+      m_maxDurationMs(DEFAULT_TIMEOUT)
 {
-    // Initialize data buffer for MP3 processing
-    m_encodedData.reserve(1024 * 1024); // Pre-allocate 1MB
-    m_dataBuffer.setBuffer(&m_encodedData);
-    m_dataBuffer.open(QIODevice::ReadWrite);
+    const SpeechSegmenter::Budget budget = {SEGMENT_TARGET_SECONDS, SEGMENT_MAX_SECONDS, SEGMENT_MAX_BYTES,
+                                            SEGMENT_MIN_PAUSE_MS, SEGMENT_SILENCE_RMS};
+    m_segmenter.reset(new SpeechSegmenter(SPEECH_SAMPLE_RATE, budget));
+    m_trimmer.reset(new VoiceActivityTrimmer(SPEECH_SAMPLE_RATE, m_maxPauseMs));
+
+    m_maxDurationTimer.setSingleShot(true);
+    connect(&m_maxDurationTimer, &QTimer::timeout, this, [this]() {
+        if (m_isRecording) {
+            qInfo() << "Recording reached the" << m_maxDurationMs << "ms limit, stopping";
+            stopRecording();
+        }
+    });
 }
 
 AudioRecorder::~AudioRecorder()
 {
     stopRecording();
+    m_sinkFuture.waitForFinished();
+    m_retiredWriter.waitForFinished();
+    stopEncoderWorker();
     finalizePortAudio();
-    finalizeMP3Encoder();
+}
+
+bool AudioRecorder::setAudioFormat(AudioFormat format)
+{
+    if (m_isRecording) {
+        qWarning() << "Cannot change the audio format while recording";
+        return false;
+    }
+    if (!isAudioFormatAvailable(format)) {
+        qWarning() << "Audio format not available in this build:" << audioFormatName(format);
+        return false;
+    }
+
+    m_audioFormat = format;
+    prepareNextSink();
+    return true;
+}
+
+QString AudioRecorder::outputFilePath() const
+{
+    return recordingFilePath(m_audioFormat);
+}
+
+void AudioRecorder::setSaveToFile(bool enabled)
+{
+    m_saveToFile = enabled;
+}
+
+void AudioRecorder::setSaveDurability(AsyncFileWriter::Durability durability)
+{
+    m_saveDurability = durability;
+}
+
+QSharedPointer<const ChunkedArena> AudioRecorder::recordedAudio() const
+{
+    return m_recording;
+}
+
+bool AudioRecorder::hasRecording() const
+{
+    return m_recording && m_recording->size() > 0;
+}
+
+qint64 AudioRecorder::recordedDurationMs() const
+{
+    return m_encodedFrames * 1000 / SPEECH_SAMPLE_RATE;
+}
+
+void AudioRecorder::discardRecording()
+{
+    if (!m_isRecording) {
+        // Let the writer close the file before the caller removes it
+        m_fileWriter.reset();
+        m_recording.reset();
+        m_segments.clear();
+    }
+}
+
+void AudioRecorder::setSegmentationEnabled(bool enabled)
+{
+    if (!m_isRecording) {
+        m_segmentationEnabled = enabled;
+        prepareNextSink();
+    }
+}
+
+void AudioRecorder::setSilenceTrimming(bool enabled, int maxPauseMs)
+{
+    if (!m_isRecording) {
+        m_trimSilence = enabled;
+        if (maxPauseMs != m_maxPauseMs) {
+            m_maxPauseMs = maxPauseMs;
+            m_trimmer.reset(new VoiceActivityTrimmer(SPEECH_SAMPLE_RATE, m_maxPauseMs));
+        }
+    }
+}
+
+void AudioRecorder::setAutoStopSilence(int silenceMs)
+{
+    if (!m_isRecording) {
+        m_autoStopSilenceMs = qMax(silenceMs, 0);
+    }
+}
+
+void AudioRecorder::setMaxDuration(int durationMs)
+{
+    if (!m_isRecording) {
+        m_maxDurationMs = qMax(durationMs, 0);
+    }
+}
+
+void AudioRecorder::setPreRoll(int preRollMs)
+{
+    if (!m_audioDeviceInitialized) {
+        m_preRollMs = qBound(0, preRollMs, PRE_ROLL_MAX_MS);
+    }
+}
+
+void AudioRecorder::setInputFile(const QString& path, FileAudioSource::Pacing pacing)
+{
+    if (!m_audioDeviceInitialized) {
+        m_inputFilePath = path;
+        m_inputPacing = pacing;
+    }
+}
+
+void AudioRecorder::prepareNextSink()
+{
+    // Only after startup; before that the settings are still changing
+    if (!m_audioDeviceInitialized) {
+        return;
+    }
+
+    // A build already running is for the previous settings; it is discarded on
+    // take if it does not match
+    m_sinkFuture.waitForFinished();
+    const AudioFormat format = m_audioFormat;
+    const bool segmented = m_segmentationEnabled;
+    m_sinkFuture = QtConcurrent::run([this, format, segmented]() {
+        QString error;
+        m_preparedSink = createRecordingSink(format, segmented, &error);
+        if (!m_preparedSink) {
+            qWarning() << "Failed to prepare the" << audioFormatName(format) << "encoder:" << error;
+        }
+    });
+}
+
+std::unique_ptr<RecordingSink> AudioRecorder::takePreparedSink()
+{
+    // Normally long finished; a start right after the previous stop waits here
+    m_sinkFuture.waitForFinished();
+    std::unique_ptr<RecordingSink> sink = std::move(m_preparedSink);
+    if (sink && (sink->format != m_audioFormat || sink->isSegmented() != m_segmentationEnabled)) {
+        sink.reset();
+    }
+    return sink;
+}
+
+QList<QSharedPointer<const ChunkedArena>> AudioRecorder::recordedSegments() const
+{
+    QList<QSharedPointer<const ChunkedArena>> segments;
+    if (m_isRecording) {
+        // Owned by the encoder worker until the recording stops
+        return segments;
+    }
+    for (const QSharedPointer<ChunkedArena>& segment : m_segments) {
+        segments.append(segment);
+    }
+    return segments;
 }
 
 bool AudioRecorder::initializeAudioSystem()
 {
     qInfo() << "Initializing audio system";
     
-    // Initialize PortAudio but don't start the stream yet
-    if (!initializePortAudio(false)) {
+    if (hasInputFile()) {
+        if (!initializeFileInput()) {
+            qCritical() << "Failed to open the input file";
+            return false;
+        }
+    } else if (!initializePortAudio(m_preRollMs > 0)) {
+        // Initialize PortAudio; the stream only runs while idle in warm standby
         qCritical() << "Failed to initialize PortAudio";
         return false;
     }
     
+    qInfo() << "Level meter kernel:" << levelMeterKernelName(activeLevelMeterKernel());
+    
     // Mark that the audio device is ready
     m_audioDeviceInitialized = true;
+    prepareNextSink();
     qInfo() << "Audio system initialized successfully";
     emit audioDeviceReady();
     
@@ -47,9 +247,18 @@ bool AudioRecorder::initializeAudioSystem()
 
 bool AudioRecorder::pauseAudioStream()
 {
+    if (m_fileSource) {
+        m_fileSource->stop();
+        return true;
+    }
     if (!m_stream || !m_audioDeviceInitialized) {
         return false;
     }
+
+    // Warm standby keeps listening so the next recording has its pre-roll
+    if (m_preRollMs > 0) {
+        return true;
+    }
     
     PaError err = Pa_StopStream(m_stream);
     if (err != paNoError) {
@@ -63,6 +272,10 @@ bool AudioRecorder::pauseAudioStream()
 
 bool AudioRecorder::resumeAudioStream()
 {
+    // The file is started by startRecording() once the recording is armed
+    if (m_fileSource) {
+        return true;
+    }
     if (!m_stream || !m_audioDeviceInitialized) {
         return false;
     }
@@ -83,6 +296,9 @@ bool AudioRecorder::resumeAudioStream()
 
 bool AudioRecorder::isAudioStreamActive() const
 {
+    if (m_fileSource) {
+        return m_fileSource->isActive();
+    }
     if (!m_stream) {
         return false;
     }
@@ -93,6 +309,14 @@ bool AudioRecorder::isAudioStreamActive() const
 bool AudioRecorder::startRecording()
 {
     qInfo() << "startRecording() called";
+    TraceSpan span("startRecording", "recorder");
+    QElapsedTimer startTimer;
+    startTimer.start();
+    m_startRequestedNs.store(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                 std::chrono::steady_clock::now().time_since_epoch()).count(),
+                             std::memory_order_relaxed);
+    m_startLatencyUs.store(-1, std::memory_order_relaxed);
+    m_preRollCoveredUs.store(-1, std::memory_order_relaxed);
     
     // Check if audio system is initialized
     if (!m_audioDeviceInitialized) {
@@ -100,43 +324,92 @@ bool AudioRecorder::startRecording()
         return false;
     }
 
-    // Make sure the audio stream is active
-    if (!isAudioStreamActive()) {
+    // Make sure the audio stream is active; a replayed file is restarted below
+    if (m_fileSource) {
+        m_fileSource->stop();
+    } else if (!isAudioStreamActive()) {
+        TraceSpan resumeSpan("resume audio stream", "recorder");
         if (!resumeAudioStream()) {
             qCritical() << "Failed to resume audio stream for recording";
             return false;
         }
     }
 
-    // Prepare output file immediately
-    m_outputFile.setFileName(OUTPUT_FILE_PATH);
-    if (!m_outputFile.open(QIODevice::WriteOnly)) {
-        qCritical() << "Unable to open output file for writing:" << OUTPUT_FILE_PATH;
-        return false;
+    // Encoder and arena were started after the previous recording; only a
+    // format or mode change since then builds them here
+    std::unique_ptr<RecordingSink> sink;
+    {
+        TraceSpan sinkSpan("take prepared encoder", "recorder");
+        sink = takePreparedSink();
     }
+    if (!sink) {
+        TraceSpan sinkSpan("create encoder", "recorder");
+        QString error;
+        sink = createRecordingSink(m_audioFormat, m_segmentationEnabled, &error);
+        if (!sink) {
+            qCritical() << "Failed to initialize" << audioFormatName(m_audioFormat) << "encoder:" << error;
+            return false;
+        }
+    }
+    m_encoder = std::move(sink->encoder);
+    m_recording = sink->recording;
+    m_arenaOverflowBytes = 0;
+    m_encodedFrames = 0;
 
-    // Reset data buffer
-    m_encodedData.clear();
-    m_dataBuffer.seek(0);
-    
-    // Initialize MP3 encoder
-    if (!initializeMP3Encoder()) {
-        qCritical() << "Failed to initialize MP3 encoder";
-        m_outputFile.close();
-        return false;
+    // The saved copy follows the arena from its own thread; it opens the file
+    // there, once it has joined the previous copy, which may still be syncing
+    std::unique_ptr<AsyncFileWriter> previousWriter = std::move(m_fileWriter);
+    if (m_saveToFile) {
+        m_fileWriter.reset(new AsyncFileWriter(m_recording, outputFilePath(), m_saveDurability));
+        m_fileWriter->start(std::move(previousWriter));
+    } else if (previousWriter) {
+        // No successor to hand it to; the pool joins it
+        std::shared_ptr<AsyncFileWriter> writer(std::move(previousWriter));
+        m_retiredWriter = QtConcurrent::run([writer]() mutable { writer.reset(); });
     }
 
-    // Start the timer
-    m_elapsedTimer.start();
-    m_isRecording = true;
-    
-    // Make sure volume is reset on new recording (emit zero volume to reset bar)
-    m_currentVolume = 0.0f;
-    emit volumeChanged(m_currentVolume);
+    // Pause-aligned pieces for parallel transcription, encoded alongside
+    m_segments.clear();
+    m_segmentEncoder = std::move(sink->segmentEncoder);
+    if (m_segmentEncoder) {
+        m_segmenter->reset();
+        m_segments.append(sink->firstSegment);
+    }
+
+    // The trimmer sits in front of both the recording and the segments, so
+    // segment cuts fall on the pauses that survive trimming. Auto-stop needs
+    // the voice activity detection even when nothing is trimmed.
+    m_autoStopPosted = false;
+    m_trimmer->reset();
+    m_voiced.reserve(m_resampled.capacity() + static_cast<std::size_t>(SPEECH_SAMPLE_RATE) * m_maxPauseMs / 1000);
+
+    // The callback only pushes while m_isRecording is set, so the ring can be
+    // reset safely here before the worker takes over the consumer side
+    m_pcmRing.reset();
+    if (m_resampler) {
+        m_resampler->reset();
+    }
+    m_droppedFrames.store(0, std::memory_order_relaxed);
+    m_clippedSamples.store(0, std::memory_order_relaxed);
+    m_bytesWritten.store(0, std::memory_order_relaxed);
+    m_encodeTimes.reset();
+    startEncoderWorker();
+
+    // A new generation makes the callback restart its frame counter, and hides
+    // the previous recording's counters from stats() until it has done so
+    m_recordingGeneration.fetch_add(1, std::memory_order_release);
+    m_isRecording.store(true, std::memory_order_release);
+    if (m_maxDurationMs > 0) {
+        m_maxDurationTimer.start(m_maxDurationMs);
+    }
+    if (m_fileSource && !m_fileSource->start()) {
+        qCritical() << "Failed to start replaying" << m_inputFilePath;
+    }
+    const qint64 startUs = startTimer.nsecsElapsed() / 1000;
     
     // Signal that recording has started (UI should reflect this immediately)
     emit recordingStarted();
-    qInfo() << "Recording started, writing to:" << OUTPUT_FILE_PATH;
+    qInfo() << "Recording started in" << startUs << "us, encoding" << audioFormatName(m_audioFormat) << "in memory";
     
     return true;
 }
@@ -147,170 +420,192 @@ void AudioRecorder::stopRecording()
         return;
 
     qDebug() << "stopRecording() called";
+    TraceSpan span("stopRecording", "recorder");
+    m_maxDurationTimer.stop();
     
     // Pause the audio stream first to prevent new data from being processed
     if (isAudioStreamActive()) {
         pauseAudioStream();
     }
     
-    // Use mutex to ensure no audio processing is happening during finalization
-    QMutexLocker locker(&m_dataMutex);
-    m_isRecording = false;
-
-    // Finalize MP3 encoding
-    if (m_mp3Initialized) {
-        try {
-            // Flush encoder with proper error handling
-            QByteArray finalData = encodeToMP3(nullptr, 0);
-            if (!finalData.isEmpty()) {
-                m_outputFile.write(finalData);
+    // Pa_StopStream() returns only after the last callback has finished, so
+    // nothing is pushed into the ring from here on. In warm standby the stream
+    // keeps running, so wait out a callback that saw the recording still on.
+    m_isRecording.store(false);
+    while (m_callbackPushing.load()) {
+        std::this_thread::yield();
+    }
+
+    // Let the worker drain whatever is still buffered, then take over the encoder
+    {
+        TraceSpan drainSpan("drain encoder worker", "recorder");
+        stopEncoderWorker();
+    }
+
+    logHealth();
+
+    quint64 dropped = m_droppedFrames.load(std::memory_order_relaxed);
+    if (dropped > 0) {
+        qWarning() << "PCM ring buffer overflowed, dropped" << dropped << "frames";
+    }
+    quint64 clipped = m_clippedSamples.load(std::memory_order_relaxed);
+    if (clipped > 0) {
+        qWarning() << "Input clipped on" << clipped << "samples - consider lowering the microphone gain";
+    }
+
+    // Finalize encoding
+    if (m_encoder) {
+        TraceSpan finishSpan("finish encoding", "recorder");
+        // Emit the samples still held back by the resampler's filter delay
+        if (m_resampler) {
+            m_resampled.clear();
+            m_resampler->flush(m_resampled);
+            encodeSpeech(m_resampled.data(), m_resampled.size());
+        }
+        flushSpeech();
+        
+        m_encoded.clear();
+        if (!m_encoder->finish(m_encoded)) {
+            qWarning() << "Encoder failed to finish the stream:" << m_encoder->lastError();
+        }
+        writeEncoded();
+
+        // Formats like WAV only know their sizes now
+        const QByteArray header = m_encoder->finalHeader(m_recording->size());
+        if (!header.isEmpty() && !m_recording->overwrite(0, header.constData(), header.size())) {
+            qWarning() << "Failed to update the recording header";
+        }
+        m_encoder.reset();
+        m_recording->finish();
+
+        if (m_segmentEncoder) {
+            finishSegment();
+            m_segmentEncoder.reset();
+            if (m_segments.size() > 1 && m_segmenter->segmentSamples() == 0) {
+                // The last cut fell on the very end
+                m_segments.removeLast();
             }
-            
-            // Clean up encoder
-            finalizeMP3Encoder();
-        } catch (const std::exception& e) {
-            qWarning() << "Exception during MP3 finalization:" << e.what();
+            qInfo() << "Recording split into" << m_segments.size() << "segment(s) for transcription";
+        }
+    }
+
+    if (m_trimSilence && m_trimmer->inputSamples() > 0) {
+        // Saved bytes are estimated at the bitrate the kept audio was encoded at
+        const qint64 savedSamples = m_trimmer->inputSamples() - m_trimmer->keptSamples();
+        const qint64 savedBytes = m_trimmer->keptSamples() > 0
+                                      ? m_recording->size() * savedSamples / m_trimmer->keptSamples()
+                                      : 0;
+        qInfo().noquote() << QString("Silence trimming: kept %1 s of %2 s, saved %3 s (%4%) and about %5 bytes")
+                                 .arg(static_cast<double>(m_trimmer->keptSamples()) / SPEECH_SAMPLE_RATE, 0, 'f', 1)
+                                 .arg(static_cast<double>(m_trimmer->inputSamples()) / SPEECH_SAMPLE_RATE, 0, 'f', 1)
+                                 .arg(static_cast<double>(savedSamples) / SPEECH_SAMPLE_RATE, 0, 'f', 1)
+                                 .arg(100 * savedSamples / m_trimmer->inputSamples())
+                                 .arg(savedBytes);
+        if (!m_trimmer->hasSpeech()) {
+            qWarning() << "No speech detected in the recording";
         }
     }
 
-    // Close output file
-    if (m_outputFile.isOpen()) {
-        m_outputFile.close();
+    const qint64 latencyUs = m_startLatencyUs.load(std::memory_order_acquire);
+    if (latencyUs >= 0) {
+        const qint64 coveredUs = m_preRollCoveredUs.load(std::memory_order_acquire);
+        qInfo().noquote() << QString("Start-to-first-sample latency: %1 ms (pre-roll: %2 ms of audio from before the start)")
+                                 .arg(latencyUs / 1000.0, 0, 'f', 1)
+                                 .arg(qMax<qint64>(coveredUs, 0) / 1000.0, 0, 'f', 1);
     }
 
-    // Reset volume to zero now that recording has stopped
-    m_currentVolume = 0.0f;
-    emit volumeChanged(m_currentVolume);
+    if (m_arenaOverflowBytes > 0) {
+        qWarning() << "Recording exceeded" << m_recording->capacity() << "bytes, dropped" << m_arenaOverflowBytes << "bytes";
+    }
+
+    if (m_fileWriter) {
+        // Writes the tail and the final header, then closes (and syncs) the
+        // file without holding up the transcription
+        m_fileWriter->finish();
+    }
 
-    // Verify file was created and has content
-    QFileInfo fileInfo(OUTPUT_FILE_PATH);
-    if (fileInfo.exists() && fileInfo.size() > 0) {
-        qInfo() << "Recording stopped, file saved successfully to:" << OUTPUT_FILE_PATH 
-                << "Size:" << fileInfo.size() << "bytes";
+    if (!hasRecording()) {
+        qWarning() << "Recording is empty";
+    } else if (m_fileWriter) {
+        qInfo() << "Recording stopped," << m_recording->size() << "bytes in memory, saving to:" << m_fileWriter->path();
     } else {
-        qWarning() << "Output file may be missing or empty:" << OUTPUT_FILE_PATH;
+        qInfo() << "Recording stopped," << m_recording->size() << "bytes in memory";
     }
 
-    emit recordingStopped();
-}
+    // Get the next recording's encoder ready while this one is transcribed
+    prepareNextSink();
 
-float AudioRecorder::currentVolumeLevel() const
-{
-    return m_currentVolume;
+    emit recordingStopped();
 }
 
-qint64 AudioRecorder::fileSize() const
+RecordingStats AudioRecorder::stats() const
 {
-    return m_outputFile.size();
+    RecordingStats snapshot = m_levelStats.load();
+    if (snapshot.generation != m_recordingGeneration.load(std::memory_order_acquire)) {
+        // The callback has not picked up the current recording yet
+        snapshot.framesCaptured = 0;
+    }
+    snapshot.bytesWritten = m_bytesWritten.load(std::memory_order_relaxed);
+    return snapshot;
 }
 
-qint64 AudioRecorder::elapsedMs() const
+float AudioRecorder::currentVolumeLevel() const
 {
-    return m_elapsedTimer.elapsed();
+    return stats().level;
 }
 
-bool AudioRecorder::initializeMP3Encoder()
+AudioHealth AudioRecorder::health() const
 {
-    qDebug() << "Initializing MP3 encoder";
+    AudioHealth health;
+    health.droppedFrames = m_droppedFrames.load(std::memory_order_relaxed);
+    health.backlogCapacityFrames = static_cast<qint64>(m_pcmRing.capacity() / NUM_CHANNELS);
+    health.encodeTime = m_encodeTimes.summary();
 
-    // Clean up any existing encoder
-    finalizeMP3Encoder();
-
-    // Create encoder instance
-    m_lameGlobal = lame_init();
-    if (!m_lameGlobal) {
-        qCritical() << "Failed to initialize LAME MP3 encoder";
-        return false;
+    // Until the callback has seen the current recording its counters are stale
+    const CallbackHealth callback = m_healthStats.load();
+    if (callback.generation != m_recordingGeneration.load(std::memory_order_acquire)) {
+        return health;
     }
-
-    // Set encoder parameters
-    lame_set_num_channels(m_lameGlobal, NUM_CHANNELS);
-    lame_set_in_samplerate(m_lameGlobal, SAMPLE_RATE);
-    lame_set_brate(m_lameGlobal, ENCODER_BITRATE / 1000); // LAME uses kbps
-    lame_set_quality(m_lameGlobal, 2); // 0=best, 9=worst
-    lame_set_mode(m_lameGlobal, NUM_CHANNELS == 1 ? MONO : STEREO);
-    
-    // Initialize the encoder
-    if (lame_init_params(m_lameGlobal) < 0) {
-        qCritical() << "Failed to initialize LAME parameters";
-        lame_close(m_lameGlobal);
-        m_lameGlobal = nullptr;
-        return false;
+    health.callbacks = callback.callbacks;
+    health.inputOverflows = callback.inputOverflows;
+    health.inputUnderflows = callback.inputUnderflows;
+    health.maxBacklogFrames = callback.maxBacklogFrames;
+    health.inputLatencyMinUs = callback.inputLatencyMinUs;
+    health.inputLatencyMaxUs = callback.inputLatencyMaxUs;
+    if (callback.inputLatencyFirstUs >= 0) {
+        health.inputLatencyDriftUs = callback.inputLatencyLastUs - callback.inputLatencyFirstUs;
     }
-
-    m_mp3Initialized = true;
-    qDebug() << "MP3 encoder initialized successfully";
-    return true;
+    health.clockDriftUs = callback.clockDriftUs;
+    health.callbackTime = m_callbackTimes.summary();
+    return health;
 }
 
-void AudioRecorder::finalizeMP3Encoder()
+void AudioRecorder::logHealth() const
 {
-    if (m_lameGlobal) {
-        lame_close(m_lameGlobal);
-        m_lameGlobal = nullptr;
+    const AudioHealth h = health();
+    qInfo().noquote() << QString("Audio health: %1 callbacks, %2 input overflows, %3 input underflows, "
+                                 "%4 frames dropped, ring backlog max %5 of %6 frames")
+                             .arg(h.callbacks).arg(h.inputOverflows).arg(h.inputUnderflows)
+                             .arg(h.droppedFrames).arg(h.maxBacklogFrames).arg(h.backlogCapacityFrames);
+    if (h.inputLatencyMinUs >= 0) {
+        qInfo().noquote() << QString("Audio health: input latency %1..%2 ms (drift %3 ms), stream clock drift %4 ms")
+                                 .arg(h.inputLatencyMinUs / 1000.0, 0, 'f', 2)
+                                 .arg(h.inputLatencyMaxUs / 1000.0, 0, 'f', 2)
+                                 .arg(h.inputLatencyDriftUs / 1000.0, 0, 'f', 2)
+                                 .arg(h.clockDriftUs / 1000.0, 0, 'f', 2);
     }
-    m_mp3Initialized = false;
+    qInfo().noquote() << "Audio health: callback time" << h.callbackTime.describe();
+    qInfo().noquote() << "Audio health: encode time" << h.encodeTime.describe();
 }
 
-QByteArray AudioRecorder::encodeToMP3(const short* inputBuffer, int inputSize)
+qint64 AudioRecorder::fileSize() const
 {
-    if (!m_mp3Initialized || !m_lameGlobal) {
-        return QByteArray();
-    }
-
-    QByteArray result;
-    int numSamples = 0;
-    
-    if (inputBuffer) {
-        // Regular encoding
-        numSamples = inputSize / sizeof(short);
-    } else {
-        // Flush encoder (end of stream)
-        numSamples = 0;
-    }
+    return m_bytesWritten.load(std::memory_order_relaxed);
+}
 
-    // MP3 buffer needs to be 1.25x + 7200 bytes larger than the PCM data
-    int mp3BufferSize = numSamples * 1.25 + 7200;
-    result.resize(mp3BufferSize);
-    
-    int bytesEncoded = 0;
-    
-    if (numSamples > 0) {
-        // Encode audio samples
-        bytesEncoded = lame_encode_buffer(
-            m_lameGlobal,
-            inputBuffer,      // left channel (mono = only channel)
-            nullptr,          // right channel (unused for mono)
-            numSamples,
-            reinterpret_cast<unsigned char*>(result.data()),
-            result.size()
-        );
-    } else {
-        // Flush remaining MP3 data - use safer flush_nogap instead of regular flush
-        bytesEncoded = lame_encode_flush_nogap(
-            m_lameGlobal,
-            reinterpret_cast<unsigned char*>(result.data()),
-            result.size()
-        );
-    }
-    
-    if (bytesEncoded < 0) {
-        qWarning() << "MP3 encoding error:" << bytesEncoded;
-        return QByteArray();
-    } else if (bytesEncoded == 0) {
-        // No bytes to encode, return empty array
-        return QByteArray();
-    }
-    
-    // Safety check before resizing
-    if (bytesEncoded > mp3BufferSize) {
-        qWarning() << "MP3 encoding buffer overflow, limiting output";
-        bytesEncoded = mp3BufferSize;
-    }
-    
-    // Resize to actual encoded size
-    result.resize(bytesEncoded);
-    return result;
+qint64 AudioRecorder::elapsedMs() const
+{
+    return stats().elapsedMs(m_captureSampleRate);
 }
 
 bool AudioRecorder::initializePortAudio(bool startStreamImmediately)
@@ -349,14 +644,17 @@ bool AudioRecorder::initializePortAudio(bool startStreamImmediately)
         qInfo() << "Using input device:" << deviceInfo->name 
                 << "with" << deviceInfo->maxInputChannels << "channels";
     }
+    
+    // Capture at speech rate directly if possible, otherwise resample before encoding
+    configureCapture(chooseCaptureSampleRate(defaultInputDevice));
 
     // Open default stream with input channels, no output channels
     err = Pa_OpenDefaultStream(&m_stream,
                                NUM_CHANNELS,
                                0,
                                paInt16,
-                               SAMPLE_RATE,
-                               256,
+                               m_captureSampleRate,
+                               FRAMES_PER_BUFFER,
                                &AudioRecorder::audioCallback,
                                this);
     if (err != paNoError) {
@@ -383,8 +681,92 @@ bool AudioRecorder::initializePortAudio(bool startStreamImmediately)
     return true;
 }
 
+bool AudioRecorder::initializeFileInput()
+{
+    m_fileSource.reset(new FileAudioSource());
+    QString error;
+    if (!m_fileSource->open(m_inputFilePath, m_inputPacing, &error)) {
+        qCritical() << "Cannot replay" << m_inputFilePath << ":" << error;
+        m_fileSource.reset();
+        return false;
+    }
+    qInfo().noquote() << QString("Using input file %1 (%2 s, %3)")
+                             .arg(m_inputFilePath)
+                             .arg(m_fileSource->durationSeconds(), 0, 'f', 2)
+                             .arg(m_inputPacing == FileAudioSource::Pacing::Fast ? "as fast as possible" : "real time");
+
+    m_fileSource->setCallbacks(
+        [this](const short* samples, unsigned long frames, const PaStreamCallbackTimeInfo* timeInfo,
+               PaStreamCallbackFlags statusFlags) {
+            // Fast replay waits for the encoder worker instead of overrunning the ring
+            if (m_inputPacing == FileAudioSource::Pacing::Fast && m_isRecording.load(std::memory_order_acquire)
+                && m_pcmRing.writeAvailable() < frames * NUM_CHANNELS) {
+                return false;
+            }
+            handleAudioData(samples, frames, timeInfo, statusFlags);
+            return true;
+        },
+        [this]() {
+            // Same hand-off as the auto-stop: stopRecording() joins the source thread
+            const quint32 generation = m_recordingGeneration.load(std::memory_order_acquire);
+            QMetaObject::invokeMethod(this, [this, generation]() {
+                if (m_isRecording && m_recordingGeneration.load(std::memory_order_acquire) == generation) {
+                    qInfo() << "End of the input file, stopping";
+                    stopRecording();
+                }
+            }, Qt::QueuedConnection);
+        });
+
+    configureCapture(m_fileSource->sampleRate());
+    return true;
+}
+
+void AudioRecorder::configureCapture(int sampleRate)
+{
+    m_captureSampleRate = sampleRate;
+    m_resampler.reset(new PolyphaseResampler(m_captureSampleRate, SPEECH_SAMPLE_RATE, RESAMPLER_TAPS_PER_PHASE));
+    m_resampled.reserve(m_resampler->maxOutputFrames(m_encodeBatch.size()));
+
+    // Filled by the callback while idle, so allocated before the stream opens
+    m_preRollRing.assign(static_cast<std::size_t>(m_captureSampleRate) * NUM_CHANNELS * m_preRollMs / 1000, 0);
+    m_preRollWrite = 0;
+    m_preRollFill = 0;
+    if (m_resampler->isPassthrough()) {
+        qInfo() << "Capturing at" << m_captureSampleRate << "Hz, no resampling needed";
+    } else {
+        qInfo() << "Capturing at" << m_captureSampleRate << "Hz, resampling to" << SPEECH_SAMPLE_RATE << "Hz";
+    }
+}
+
+int AudioRecorder::chooseCaptureSampleRate(PaDeviceIndex device) const
+{
+    const PaDeviceInfo* deviceInfo = Pa_GetDeviceInfo(device);
+
+    PaStreamParameters parameters;
+    parameters.device = device;
+    parameters.channelCount = NUM_CHANNELS;
+    parameters.sampleFormat = paInt16;
+    parameters.suggestedLatency = deviceInfo ? deviceInfo->defaultLowInputLatency : 0.0;
+    parameters.hostApiSpecificStreamInfo = nullptr;
+
+    if (Pa_IsFormatSupported(&parameters, nullptr, SPEECH_SAMPLE_RATE) == paFormatIsSupported) {
+        return SPEECH_SAMPLE_RATE;
+    }
+
+    // Fall back to the device's native rate so the host API doesn't resample twice
+    if (deviceInfo && deviceInfo->defaultSampleRate > 0 && deviceInfo->defaultSampleRate <= MAX_CAPTURE_SAMPLE_RATE) {
+        return qRound(deviceInfo->defaultSampleRate);
+    }
+    return FALLBACK_SAMPLE_RATE;
+}
+
 void AudioRecorder::finalizePortAudio()
 {
+    if (m_fileSource) {
+        m_fileSource->stop();
+        m_fileSource.reset();
+        return;
+    }
     // In case something is still open, ensure it's properly closed.
     if (m_stream) {
         Pa_StopStream(m_stream);
@@ -397,64 +779,356 @@ void AudioRecorder::finalizePortAudio()
 int AudioRecorder::audioCallback( const void *inputBuffer,
                                   void * /*outputBuffer*/,
                                   unsigned long framesPerBuffer,
-                                  const PaStreamCallbackTimeInfo* /*timeInfo*/,
-                                  PaStreamCallbackFlags /*statusFlags*/,
+                                  const PaStreamCallbackTimeInfo* timeInfo,
+                                  PaStreamCallbackFlags statusFlags,
                                   void *userData )
 {
     AudioRecorder* recorder = reinterpret_cast<AudioRecorder*>(userData);
-    recorder->handleAudioData(inputBuffer, framesPerBuffer);
+    recorder->handleAudioData(inputBuffer, framesPerBuffer, timeInfo, statusFlags);
     return paContinue;
 }
 
-void AudioRecorder::handleAudioData(const void* inputBuffer, unsigned long frames)
+void AudioRecorder::handleAudioData(const void* inputBuffer, unsigned long frames,
+                                    const PaStreamCallbackTimeInfo* timeInfo, PaStreamCallbackFlags statusFlags)
 {
-    QMutexLocker locker(&m_dataMutex);
-    
     // Just return if we don't have valid input buffer (no audio data)
     if (!inputBuffer) {
         return;
     }
     
-    // Calculate volume level from audio data
-    const short* buffer = reinterpret_cast<const short*>(inputBuffer);
-    long sum = 0;
-    for (unsigned long i = 0; i < frames; ++i) {
-        sum += qAbs(buffer[i]);
-    }
-    float average = static_cast<float>(sum) / frames;
+    // Raised before m_isRecording is read so stopRecording() can wait for the
+    // push to finish (both sides sequentially consistent)
+    m_callbackPushing.store(true);
+    const bool recording = m_isRecording.load() && (m_stream || m_fileSource);
+    processCapturedAudio(reinterpret_cast<const short*>(inputBuffer), frames, recording, timeInfo, statusFlags);
+    m_callbackPushing.store(false);
+}
+
+void AudioRecorder::processCapturedAudio(const short* buffer, unsigned long frames, bool recording,
+                                         const PaStreamCallbackTimeInfo* timeInfo, PaStreamCallbackFlags statusFlags)
+{
+    // Runs on the real-time audio thread: no locks, no allocation, no I/O
+    const auto callbackStart = std::chrono::steady_clock::now();
     
-    // Scale the volume using the config scaling factor
-    float normalizedVolume = average / 32767.0f;  // normalize to ~0..1
-    m_currentVolume = qMin(normalizedVolume * VOLUME_SCALING_FACTOR, 1.0f);  // Apply scaling with 1.0 max
+    // Peak, RMS and clipping in a single vectorized pass
+    const LevelStats level = measureLevel(buffer, frames * NUM_CHANNELS);
     
-    // Only emit volume changes if we're recording
-    if (m_isRecording) {
-        emit volumeChanged(m_currentVolume);
-        
-        // Log volume levels periodically for debugging
-        static QElapsedTimer logTimer;
-        if (!logTimer.isValid() || logTimer.elapsed() > 5000) { // Log every 5 seconds
-            qDebug() << "Raw volume:" << normalizedVolume << "Scaled volume:" << m_currentVolume;
-            logTimer.start();
+    // A new recording, even if no idle callback ran since the last one ended
+    // (the stream is paused before stopRecording() clears m_isRecording)
+    const quint32 generation = m_recordingGeneration.load(std::memory_order_acquire);
+    if (generation != m_callbackGeneration) {
+        m_callbackGeneration = generation;
+        m_callbackRecording = false;
+        m_callbackFrames = 0;
+        m_peakHold = 0.0f;
+        m_callbackHealth = CallbackHealth();
+        m_callbackHealth.generation = generation;
+        m_callbackTimes.reset();
+    }
+    
+    // Hand the PCM over to the encoder worker; if it fell behind, drop rather than block
+    const std::size_t samples = frames * NUM_CHANNELS;
+    if (recording) {
+        if (!m_callbackRecording) {
+            // First block of this recording: the pre-roll goes in ahead of it
+            m_callbackRecording = true;
+            const std::size_t preRollFrames = pushPreRoll() / NUM_CHANNELS;
+            m_callbackFrames += static_cast<qint64>(preRollFrames);
+
+            const qint64 nowNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                     std::chrono::steady_clock::now().time_since_epoch()).count();
+            m_preRollCoveredUs.store(static_cast<qint64>(preRollFrames) * 1000000 / m_captureSampleRate,
+                                     std::memory_order_relaxed);
+            m_startLatencyUs.store((nowNs - m_startRequestedNs.load(std::memory_order_relaxed)) / 1000,
+                                   std::memory_order_release);
+        }
+        const std::size_t pushed = m_pcmRing.push(buffer, samples);
+        if (pushed < samples) {
+            m_droppedFrames.fetch_add((samples - pushed) / NUM_CHANNELS, std::memory_order_relaxed);
         }
+        if (level.clippedSamples > 0) {
+            m_clippedSamples.fetch_add(static_cast<quint64>(level.clippedSamples), std::memory_order_relaxed);
+        }
+        m_callbackFrames += static_cast<qint64>(frames);
+        updateCallbackHealth(frames, timeInfo, statusFlags);
+    } else {
+        m_callbackRecording = false;
+        storePreRoll(buffer, samples);
     }
     
-    // Only process for recording if we're actually recording and stream is ready
-    if (!m_isRecording || !m_stream) {
+    // Publish the level snapshot; the UI samples it at its own frame rate
+    const float decay = PEAK_HOLD_DECAY_PER_SECOND * static_cast<float>(frames) / m_captureSampleRate;
+    m_peakHold = qMax(level.peakNormalized(), m_peakHold - decay);
+    
+    RecordingStats published;
+    published.level = qMin(level.rms * VOLUME_SCALING_FACTOR, 1.0f);  // Apply scaling with 1.0 max
+    published.peakHold = m_peakHold;
+    published.framesCaptured = m_callbackFrames;
+    published.generation = m_callbackGeneration;
+    m_levelStats.store(published);
+
+    if (recording) {
+        m_callbackTimes.record(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                   std::chrono::steady_clock::now() - callbackStart).count());
+    }
+}
+
+void AudioRecorder::updateCallbackHealth(unsigned long frames, const PaStreamCallbackTimeInfo* timeInfo,
+                                         PaStreamCallbackFlags statusFlags)
+{
+    CallbackHealth& health = m_callbackHealth;
+    ++health.callbacks;
+    if (statusFlags & paInputOverflow) {
+        ++health.inputOverflows;
+    }
+    if (statusFlags & paInputUnderflow) {
+        ++health.inputUnderflows;
+    }
+    health.maxBacklogFrames = qMax(health.maxBacklogFrames,
+                                   static_cast<qint64>(m_pcmRing.readAvailable() / NUM_CHANNELS));
+
+    // Some host APIs leave the times at zero; then there is nothing to track
+    if (timeInfo && timeInfo->inputBufferAdcTime > 0.0) {
+        const qint64 latencyUs = static_cast<qint64>((timeInfo->currentTime - timeInfo->inputBufferAdcTime) * 1e6);
+        if (health.inputLatencyFirstUs < 0) {
+            health.inputLatencyFirstUs = latencyUs;
+            health.inputLatencyMinUs = latencyUs;
+            health.inputLatencyMaxUs = latencyUs;
+            health.streamStartTime = timeInfo->inputBufferAdcTime;
+        }
+        health.inputLatencyLastUs = latencyUs;
+        health.inputLatencyMinUs = qMin(health.inputLatencyMinUs, latencyUs);
+        health.inputLatencyMaxUs = qMax(health.inputLatencyMaxUs, latencyUs);
+
+        // Positive when the stream clock ran ahead of the samples we got
+        const double streamElapsed = timeInfo->inputBufferAdcTime - health.streamStartTime;
+        const double deliveredSeconds = static_cast<double>(health.liveFrames) / m_captureSampleRate;
+        health.clockDriftUs = static_cast<qint64>((streamElapsed - deliveredSeconds) * 1e6);
+        health.liveFrames += static_cast<qint64>(frames);
+    }
+
+    m_healthStats.store(health);
+}
+
+void AudioRecorder::storePreRoll(const short* samples, std::size_t count)
+{
+    const std::size_t capacity = m_preRollRing.size();
+    if (capacity == 0) {
         return;
     }
+    if (count > capacity) {
+        samples += count - capacity;
+        count = capacity;
+    }
 
-    // Encode and write audio data if encoder is ready
-    if (m_mp3Initialized) {
-        try {
-            QByteArray encodedData = encodeToMP3(buffer, frames * sizeof(short));
-            if (!encodedData.isEmpty()) {
-                if (!m_outputFile.write(encodedData)) {
-                    qWarning() << "Failed to write MP3 data to file:" << m_outputFile.errorString();
-                }
-            }
-        } catch (const std::exception& e) {
-            qWarning() << "Exception during MP3 encoding:" << e.what();
+    const std::size_t first = qMin(count, capacity - m_preRollWrite);
+    std::copy(samples, samples + first, m_preRollRing.begin() + static_cast<std::ptrdiff_t>(m_preRollWrite));
+    std::copy(samples + first, samples + count, m_preRollRing.begin());
+    m_preRollWrite = (m_preRollWrite + count) % capacity;
+    m_preRollFill = qMin(m_preRollFill + count, capacity);
+}
+
+std::size_t AudioRecorder::pushPreRoll()
+{
+    // Oldest sample first; the ring starts empty again for the next idle stretch
+    const std::size_t capacity = m_preRollRing.size();
+    const std::size_t fill = m_preRollFill;
+    m_preRollFill = 0;
+    if (fill == 0) {
+        return 0;
+    }
+
+    const std::size_t start = (m_preRollWrite + capacity - fill) % capacity;
+    const std::size_t first = qMin(fill, capacity - start);
+    std::size_t pushed = m_pcmRing.push(m_preRollRing.data() + start, first);
+    pushed += m_pcmRing.push(m_preRollRing.data(), fill - first);
+    return pushed;
+}
+
+void AudioRecorder::startEncoderWorker()
+{
+    stopEncoderWorker();
+
+    m_encoderStopRequested.store(false, std::memory_order_release);
+    m_encoderThread = std::thread(&AudioRecorder::encoderLoop, this);
+}
+
+void AudioRecorder::stopEncoderWorker()
+{
+    if (!m_encoderThread.joinable()) {
+        return;
+    }
+
+    m_encoderStopRequested.store(true, std::memory_order_release);
+    m_encoderThread.join();
+}
+
+void AudioRecorder::encoderLoop()
+{
+    Tracer::instance().setThreadName("encoder");
+    bool firstBatch = true;
+    while (!m_encoderStopRequested.load(std::memory_order_acquire)) {
+        if (drainPcmRing() == 0) {
+            QThread::msleep(ENCODER_POLL_INTERVAL_MS);
+        } else if (firstBatch) {
+            firstBatch = false;
+            Tracer::instance().instant("first samples encoded", "recorder");
         }
     }
+
+    // Stop was requested after the stream stopped: flush everything that is left
+    while (drainPcmRing() > 0) {
+    }
+}
+
+std::size_t AudioRecorder::drainPcmRing()
+{
+    const std::size_t samples = m_pcmRing.pop(m_encodeBatch.data(), m_encodeBatch.size());
+    if (samples == 0 || !m_encoder || !m_resampler) {
+        return samples;
+    }
+
+    TraceSpan span("encode batch", "recorder");
+    const auto encodeStart = std::chrono::steady_clock::now();
+    m_resampled.clear();
+    m_resampler->process(m_encodeBatch.data(), samples, m_resampled);
+    encodeSpeech(m_resampled.data(), m_resampled.size());
+    m_encodeTimes.record(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                             std::chrono::steady_clock::now() - encodeStart).count());
+
+    return samples;
+}
+
+void AudioRecorder::encodeSpeech(const short* samples, std::size_t count)
+{
+    if (!m_trimSilence && m_autoStopSilenceMs <= 0) {
+        encodeAndWrite(samples, count);
+        encodeSegments(samples, count);
+        return;
+    }
+
+    m_voiced.clear();
+    m_trimmer->process(samples, count, m_voiced);
+    if (m_trimSilence) {
+        encodeAndWrite(m_voiced.data(), m_voiced.size());
+        encodeSegments(m_voiced.data(), m_voiced.size());
+    } else {
+        encodeAndWrite(samples, count);
+        encodeSegments(samples, count);
+    }
+    checkEndOfSpeech();
+}
+
+void AudioRecorder::flushSpeech()
+{
+    if (!m_trimSilence) {
+        return;
+    }
+
+    m_voiced.clear();
+    m_trimmer->flush(m_voiced);
+    encodeAndWrite(m_voiced.data(), m_voiced.size());
+    encodeSegments(m_voiced.data(), m_voiced.size());
+}
+
+void AudioRecorder::encodeAndWrite(const short* samples, std::size_t count)
+{
+    if (count == 0) {
+        return;
+    }
+
+    m_encoded.clear();
+    if (!m_encoder->encode(samples, static_cast<int>(count / NUM_CHANNELS), m_encoded)) {
+        qWarning() << "Audio encoding error:" << m_encoder->lastError();
+        return;
+    }
+    m_encodedFrames += static_cast<qint64>(count / NUM_CHANNELS);
+    writeEncoded();
+}
+
+void AudioRecorder::writeEncoded()
+{
+    if (m_encoded.isEmpty()) {
+        return;
+    }
+
+    const qint64 stored = m_recording->append(m_encoded.constData(), m_encoded.size());
+    m_arenaOverflowBytes += m_encoded.size() - stored;
+    m_bytesWritten.fetch_add(stored, std::memory_order_relaxed);
+}
+
+void AudioRecorder::encodeSegments(const short* samples, std::size_t count)
+{
+    if (!m_segmentEncoder) {
+        return;
+    }
+
+    std::size_t offset = 0;
+    while (offset < count) {
+        const qint64 cut = m_segmenter->findCut(samples + offset, count - offset, m_segments.last()->size());
+        const std::size_t take = cut < 0 ? count - offset : static_cast<std::size_t>(cut);
+
+        m_segmentEncoded.clear();
+        if (take > 0 && !m_segmentEncoder->encode(samples + offset, static_cast<int>(take / NUM_CHANNELS), m_segmentEncoded)) {
+            qWarning() << "Segment encoding error:" << m_segmentEncoder->lastError();
+        }
+        m_segments.last()->append(m_segmentEncoded.constData(), m_segmentEncoded.size());
+        offset += take;
+
+        if (cut >= 0) {
+            finishSegment();
+            beginSegment();
+            m_segmenter->startSegment();
+        }
+    }
+}
+
+void AudioRecorder::beginSegment()
+{
+    m_segments.append(createSegmentArena());
+    if (!m_segmentEncoder->begin(SPEECH_SAMPLE_RATE, NUM_CHANNELS)) {
+        qWarning() << "Failed to start segment encoder:" << m_segmentEncoder->lastError();
+    }
+}
+
+void AudioRecorder::finishSegment()
+{
+    ChunkedArena* segment = m_segments.last().data();
+
+    m_segmentEncoded.clear();
+    if (!m_segmentEncoder->finish(m_segmentEncoded)) {
+        qWarning() << "Segment encoder failed to finish:" << m_segmentEncoder->lastError();
+    }
+    segment->append(m_segmentEncoded.constData(), m_segmentEncoded.size());
+
+    const QByteArray header = m_segmentEncoder->finalHeader(segment->size());
+    if (!header.isEmpty()) {
+        segment->overwrite(0, header.constData(), header.size());
+    }
+    segment->finish();
+}
+
+void AudioRecorder::checkEndOfSpeech()
+{
+    if (m_autoStopSilenceMs <= 0 || m_autoStopPosted) {
+        return;
+    }
+
+    // A click or a cough is not enough speech to end on
+    const qint64 minSpeech = static_cast<qint64>(AUTO_STOP_MIN_SPEECH_MS) * SPEECH_SAMPLE_RATE / 1000;
+    const qint64 silence = static_cast<qint64>(m_autoStopSilenceMs) * SPEECH_SAMPLE_RATE / 1000;
+    if (m_trimmer->speechSamples() < minSpeech || m_trimmer->silenceSamples() < silence) {
+        return;
+    }
+
+    // stopRecording() joins this thread, so it runs on the recorder's thread.
+    // The generation keeps a late stop from hitting the next recording.
+    m_autoStopPosted = true;
+    const quint32 generation = m_recordingGeneration.load(std::memory_order_acquire);
+    QMetaObject::invokeMethod(this, [this, generation]() {
+        if (m_isRecording && m_recordingGeneration.load(std::memory_order_acquire) == generation) {
+            qInfo() << "End of speech detected after" << m_autoStopSilenceMs << "ms of silence, stopping";
+            stopRecording();
+        }
+    }, Qt::QueuedConnection);
 }
@@ -2,18 +2,34 @@
 #define AUDIORECORDER_H
 
 #include <QObject>
-#include <QFile>
-#include <QElapsedTimer>
-#include <QMutex>
+#include <QList>
+#include <QSharedPointer>
+#include <QTimer>
 #include <QFuture>
 #include <QtConcurrent>
-#include <QBuffer>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
 #include <portaudio.h>
-#include <lame/lame.h>
+
+#include "spscringbuffer.h"
+#include "recordingstats.h"
+#include "polyphaseresampler.h"
+#include "audioencoder.h"
+#include "asyncfilewriter.h"
+#include "audiohealth.h"
+#include "chunkedarena.h"
+#include "fileaudiosource.h"
+#include "recordingsink.h"
+#include "speechsegmenter.h"
+#include "voiceactivitytrimmer.h"
 
 class AudioRecorder : public QObject
 {
     Q_OBJECT
+    friend class VoiceInputBenchmarks;  // Drives processCapturedAudio() without a stream
+    friend class AudioRecorderTest;     // Likewise, through consecutive recordings
 public:
     explicit AudioRecorder(QObject* parent = nullptr);
     ~AudioRecorder();
@@ -21,7 +37,7 @@ public:
     // Initialize audio system - called once at startup
     bool initializeAudioSystem();
     
-    // Start/stop recording to file
+    // Start/stop recording; the encoded audio is kept in memory
     bool startRecording();
     void stopRecording();
     
@@ -29,32 +45,123 @@ public:
     bool pauseAudioStream();
     bool resumeAudioStream();
 
+    // Consistent snapshot of level, peak hold, frames and bytes; safe to poll
+    // from the GUI thread at any rate
+    RecordingStats stats() const;
+
+    // Xruns, callback/encode timing, latency drift and ring backlog of the
+    // current or last recording; safe to poll from any thread
+    AudioHealth health() const;
+
     // For UI: volume level, file size, etc.
     float currentVolumeLevel() const;
     qint64 fileSize() const;
     qint64 elapsedMs() const;
     
     // Check if recording is active
-    bool isRecording() const { return m_isRecording; }
+    bool isRecording() const { return m_isRecording.load(std::memory_order_acquire); }
     
     // Check if audio system is initialized
     bool isAudioSystemInitialized() const { return m_audioDeviceInitialized; }
     
     // Check if audio stream is active
     bool isAudioStreamActive() const;
+    
+    // Rate the device delivers; the encoder always receives SPEECH_SAMPLE_RATE
+    int captureSampleRate() const { return m_captureSampleRate; }
+
+    // Format used for the next recording; the file extension follows it
+    bool setAudioFormat(AudioFormat format);
+    AudioFormat audioFormat() const { return m_audioFormat; }
+    QString outputFilePath() const;
+
+    // Also write each recording to outputFilePath() (archiving/debugging).
+    // The file is written in the background while recording.
+    void setSaveToFile(bool enabled);
+    bool saveToFile() const { return m_saveToFile; }
+    void setSaveDurability(AsyncFileWriter::Durability durability);
+    AsyncFileWriter::Durability saveDurability() const { return m_saveDurability; }
+
+    // Encoded bytes of the current or last recording. Safe to read while the
+    // recording is still in progress; isFinished() is set once it stopped.
+    QSharedPointer<const ChunkedArena> recordedAudio() const;
+    bool hasRecording() const;
+    void discardRecording();
+
+    // Length of the audio in recordedAudio() after silence trimming; valid
+    // once the recording stopped
+    qint64 recordedDurationMs() const;
+
+    // Also split each recording at pauses into separately encoded segments
+    // that fit the transcription size/duration budget
+    void setSegmentationEnabled(bool enabled);
+    bool isSegmentationEnabled() const { return m_segmentationEnabled; }
+
+    // Segments of the last recording, in order; empty while recording or when
+    // segmentation is off
+    QList<QSharedPointer<const ChunkedArena>> recordedSegments() const;
+
+    // Drop leading/trailing silence and shorten pauses longer than maxPauseMs
+    // before encoding (on by default)
+    void setSilenceTrimming(bool enabled, int maxPauseMs);
+    bool isSilenceTrimmingEnabled() const { return m_trimSilence; }
+
+    // Stop by itself once speech is followed by silenceMs of silence (0 = off)
+    void setAutoStopSilence(int silenceMs);
+    int autoStopSilence() const { return m_autoStopSilenceMs; }
+
+    // Hard limit on the recording length, whatever is being said (0 = none)
+    void setMaxDuration(int durationMs);
+    int maxDuration() const { return m_maxDurationMs; }
+
+    // Warm standby: keep the stream running while idle and start each
+    // recording with the last preRollMs of audio (0 = off). Set before
+    // initializeAudioSystem().
+    void setPreRoll(int preRollMs);
+    int preRoll() const { return m_preRollMs; }
+
+    // Replay an audio file (MP3 or WAV) instead of opening the microphone.
+    // It goes through the same callback path, starts over with every
+    // recording and stops the recording at its end. Pre-roll does not apply.
+    // Set before initializeAudioSystem().
+    void setInputFile(const QString& path, FileAudioSource::Pacing pacing);
+    bool hasInputFile() const { return !m_inputFilePath.isEmpty(); }
+
+    // From startRecording() until the first samples were handed to the
+    // encoder worker in the last recording, and how much audio from before
+    // the start the pre-roll contributed (-1 until measured)
+    qint64 startLatencyUs() const { return m_startLatencyUs.load(std::memory_order_acquire); }
+    qint64 preRollCoveredUs() const { return m_preRollCoveredUs.load(std::memory_order_acquire); }
 
 signals:
-    void volumeChanged(float newVolume);
     void recordingStopped();
     void recordingStarted();
     void audioDeviceReady();
 
 private:
     bool initializePortAudio(bool startStreamImmediately = true);
+    bool initializeFileInput();
+    void configureCapture(int sampleRate);
+    int chooseCaptureSampleRate(PaDeviceIndex device) const;
     void finalizePortAudio();
-    bool initializeMP3Encoder();
-    void finalizeMP3Encoder();
-    QByteArray encodeToMP3(const short* inputBuffer, int inputSize);
+
+    // Encoder worker: drains the PCM ring, encodes and writes to the output file
+    void startEncoderWorker();
+    void stopEncoderWorker();
+    void encoderLoop();
+    std::size_t drainPcmRing();
+    void encodeSpeech(const short* samples, std::size_t count);
+    void flushSpeech();
+    void checkEndOfSpeech();
+
+    // Build the next recording's encoder and arena in the background
+    void prepareNextSink();
+    std::unique_ptr<RecordingSink> takePreparedSink();
+    void encodeAndWrite(const short* samples, std::size_t count);
+    void writeEncoded();
+    void encodeSegments(const short* samples, std::size_t count);
+    void beginSegment();
+    void finishSegment();
 
     static int audioCallback( const void *inputBuffer,
                               void *outputBuffer,
@@ -63,28 +170,123 @@ private:
                               PaStreamCallbackFlags statusFlags,
                               void *userData );
 
-    void handleAudioData(const void* inputBuffer, unsigned long frames);
+    void handleAudioData(const void* inputBuffer, unsigned long frames,
+                         const PaStreamCallbackTimeInfo* timeInfo, PaStreamCallbackFlags statusFlags);
+    // Everything the callback does with one buffer: metering, the hand-over
+    // to the encoder worker while `recording` (the pre-roll otherwise),
+    // health and the published level. Needs no stream, so benchmarks can
+    // call it directly.
+    void processCapturedAudio(const short* buffer, unsigned long frames, bool recording,
+                              const PaStreamCallbackTimeInfo* timeInfo, PaStreamCallbackFlags statusFlags);
+    void updateCallbackHealth(unsigned long frames, const PaStreamCallbackTimeInfo* timeInfo,
+                              PaStreamCallbackFlags statusFlags);
+    void logHealth() const;
+    void storePreRoll(const short* samples, std::size_t count);
+    std::size_t pushPreRoll();
 
 private:
-    // PortAudio
+    // PortAudio, or the file replayed in its place
     PaStream*       m_stream;
+    int             m_captureSampleRate;
+    QString                          m_inputFilePath;
+    FileAudioSource::Pacing          m_inputPacing;
+    std::unique_ptr<FileAudioSource> m_fileSource;
+    
+    // Callback -> encoder worker hand-off
+    SpscRingBuffer<short>   m_pcmRing;
+    std::vector<short>      m_encodeBatch;
+    
+    // Capture rate -> SPEECH_SAMPLE_RATE conversion, run by the encoder worker
+    std::unique_ptr<PolyphaseResampler> m_resampler;
+    std::vector<short>      m_resampled;
+    std::thread             m_encoderThread;
+    std::atomic<bool>       m_encoderStopRequested;
+    std::atomic<quint64>    m_droppedFrames;
+    std::atomic<quint64>    m_clippedSamples;
+    
+    // Live stats: level fields published by the callback, bytes by the worker
+    SeqLock<RecordingStats> m_levelStats;
+
+    // Capture path health, owned by the callback and published like the level
+    struct CallbackHealth
+    {
+        quint64 callbacks = 0;
+        quint64 inputOverflows = 0;
+        quint64 inputUnderflows = 0;
+        qint64  maxBacklogFrames = 0;
+        qint64  inputLatencyMinUs = -1;
+        qint64  inputLatencyMaxUs = -1;
+        qint64  inputLatencyFirstUs = -1;
+        qint64  inputLatencyLastUs = -1;
+        qint64  clockDriftUs = 0;
+        double  streamStartTime = 0.0;  // Stream time of the first live block
+        qint64  liveFrames = 0;         // Frames delivered since then
+        quint32 generation = 0;
+    };
+    CallbackHealth          m_callbackHealth;
+    SeqLock<CallbackHealth> m_healthStats;
+    DurationHistogram       m_callbackTimes;    // Written by the callback
+    DurationHistogram       m_encodeTimes;      // Written by the encoder worker
+    std::atomic<qint64>     m_bytesWritten;
+    std::atomic<quint32>    m_recordingGeneration;
     
-    // File output
-    QFile           m_outputFile;
-    QElapsedTimer   m_elapsedTimer;
-    QMutex          m_dataMutex;
+    // Owned by the audio callback thread
+    float                   m_peakHold;
+    qint64                  m_callbackFrames;
+    quint32                 m_callbackGeneration;
+    bool                    m_callbackRecording;    // Recording seen by the last callback
+    std::vector<short>      m_preRollRing;          // Last preRollMs of PCM while idle
+    std::size_t             m_preRollWrite;
+    std::size_t             m_preRollFill;
+
+    // Warm standby
+    int                     m_preRollMs;
+    std::atomic<bool>       m_callbackPushing;      // Callback may be pushing into m_pcmRing
+    std::atomic<qint64>     m_startRequestedNs;     // steady_clock time of startRecording()
+    std::atomic<qint64>     m_startLatencyUs;
+    std::atomic<qint64>     m_preRollCoveredUs;
     
     // State
-    bool            m_isRecording;
+    std::atomic<bool> m_isRecording;
     bool            m_audioDeviceInitialized;
-    float           m_currentVolume;
     QFuture<void>   m_initFuture;
     
-    // MP3 encoding
-    lame_global_flags* m_lameGlobal;
-    bool               m_mp3Initialized;
-    QByteArray         m_encodedData;
-    QBuffer            m_dataBuffer; // For intermediate processing
+    // Encoding (used by the encoder worker while recording)
+    AudioFormat                   m_audioFormat;
+    std::unique_ptr<AudioEncoder> m_encoder;
+    QByteArray                    m_encoded;
+    
+    // Encoded output, appended by the encoder worker while recording
+    QSharedPointer<ChunkedArena>  m_recording;
+    bool                          m_saveToFile;
+    AsyncFileWriter::Durability   m_saveDurability;
+    std::unique_ptr<AsyncFileWriter> m_fileWriter;   // Copy of the current or last recording
+    QFuture<void>                 m_retiredWriter;    // Joins the last copy once saving is off
+    qint64                        m_arenaOverflowBytes;
+    qint64                        m_encodedFrames;    // Frames handed to m_encoder in this recording
+    
+    // Segmentation (used by the encoder worker while recording)
+    bool                                m_segmentationEnabled;
+    std::unique_ptr<SpeechSegmenter>    m_segmenter;
+    std::unique_ptr<AudioEncoder>       m_segmentEncoder;
+    QByteArray                          m_segmentEncoded;
+    QList<QSharedPointer<ChunkedArena>> m_segments;
+
+    // Ready for the next startRecording(); written by m_sinkFuture
+    std::unique_ptr<RecordingSink>      m_preparedSink;
+    QFuture<void>                       m_sinkFuture;
+
+    // Silence trimming between resampler and encoders (used by the encoder worker)
+    bool                                    m_trimSilence;
+    int                                     m_maxPauseMs;
+    std::unique_ptr<VoiceActivityTrimmer>   m_trimmer;
+    std::vector<short>                      m_voiced;
+
+    // Automatic stop
+    int                 m_autoStopSilenceMs;
+    bool                m_autoStopPosted;       // Encoder worker only
+    int                 m_maxDurationMs;
+    QTimer              m_maxDurationTimer;
 };
 
 #endif // AUDIORECORDER_H
@@ -0,0 +1,126 @@
+#include "chunkedarena.h"
+
+#include <QFile>
+#include <cstring>
+
+ChunkedArena::ChunkedArena(std::size_t chunkBytes, std::size_t maxChunks)
+    : m_chunkBytes(chunkBytes),
+      m_maxChunks(maxChunks),
+      m_chunks(new char*[maxChunks]()),
+      m_allocatedChunks(0),
+      m_size(0),
+      m_finished(false)
+{
+}
+
+ChunkedArena::~ChunkedArena()
+{
+    for (std::size_t i = 0; i < m_allocatedChunks; ++i) {
+        delete[] m_chunks[i];
+    }
+}
+
+qint64 ChunkedArena::append(const char* data, qint64 length)
+{
+    // Only the writer modifies the size, so a relaxed load sees its own stores
+    const qint64 start = m_size.load(std::memory_order_relaxed);
+    qint64 written = 0;
+
+    while (written < length) {
+        const qint64 position = start + written;
+        const std::size_t chunk = static_cast<std::size_t>(position) / m_chunkBytes;
+        const std::size_t offset = static_cast<std::size_t>(position) % m_chunkBytes;
+        if (chunk >= m_maxChunks) {
+            break;
+        }
+        if (chunk >= m_allocatedChunks) {
+            m_chunks[chunk] = new char[m_chunkBytes];
+            ++m_allocatedChunks;
+        }
+
+        const qint64 count = qMin<qint64>(length - written, static_cast<qint64>(m_chunkBytes - offset));
+        std::memcpy(m_chunks[chunk] + offset, data + written, static_cast<std::size_t>(count));
+        written += count;
+    }
+
+    // Publish the bytes (and any new chunk pointers) to readers
+    m_size.store(start + written, std::memory_order_release);
+    return written;
+}
+
+bool ChunkedArena::overwrite(qint64 offset, const char* data, qint64 length)
+{
+    if (offset < 0 || offset + length > m_size.load(std::memory_order_relaxed)) {
+        return false;
+    }
+
+    qint64 done = 0;
+    while (done < length) {
+        const qint64 position = offset + done;
+        const std::size_t chunk = static_cast<std::size_t>(position) / m_chunkBytes;
+        const std::size_t chunkOffset = static_cast<std::size_t>(position) % m_chunkBytes;
+        const qint64 count = qMin<qint64>(length - done, static_cast<qint64>(m_chunkBytes - chunkOffset));
+        std::memcpy(m_chunks[chunk] + chunkOffset, data + done, static_cast<std::size_t>(count));
+        done += count;
+    }
+    return true;
+}
+
+void ChunkedArena::finish()
+{
+    m_finished.store(true, std::memory_order_release);
+}
+
+const char* ChunkedArena::span(qint64 offset, qint64* length) const
+{
+    const qint64 published = size();
+    if (offset < 0 || offset >= published) {
+        *length = 0;
+        return nullptr;
+    }
+
+    const std::size_t chunk = static_cast<std::size_t>(offset) / m_chunkBytes;
+    const std::size_t chunkOffset = static_cast<std::size_t>(offset) % m_chunkBytes;
+    *length = qMin<qint64>(published - offset, static_cast<qint64>(m_chunkBytes - chunkOffset));
+    return m_chunks[chunk] + chunkOffset;
+}
+
+qint64 ChunkedArena::read(qint64 offset, char* dest, qint64 maxLength) const
+{
+    qint64 copied = 0;
+    while (copied < maxLength) {
+        qint64 available = 0;
+        const char* source = span(offset + copied, &available);
+        if (!source) {
+            break;
+        }
+        const qint64 count = qMin(available, maxLength - copied);
+        std::memcpy(dest + copied, source, static_cast<std::size_t>(count));
+        copied += count;
+    }
+    return copied;
+}
+
+bool ChunkedArena::writeToFile(const QString& path, QString* errorMessage) const
+{
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        if (errorMessage) {
+            *errorMessage = file.errorString();
+        }
+        return false;
+    }
+
+    qint64 offset = 0;
+    qint64 length = 0;
+    while (const char* data = span(offset, &length)) {
+        if (file.write(data, length) != length) {
+            if (errorMessage) {
+                *errorMessage = file.errorString();
+            }
+            return false;
+        }
+        offset += length;
+    }
+    return true;
+}
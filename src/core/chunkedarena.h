@@ -0,0 +1,59 @@
+#ifndef CHUNKEDARENA_H
+#define CHUNKEDARENA_H
+
+#include <QString>
+#include <QtGlobal>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+// Append-only byte store made of fixed-size chunks. Chunks are allocated on
+// demand and never moved, so appending never reallocates or copies what is
+// already stored. The chunk table is sized up front, which lets readers on
+// other threads walk the data while a single writer keeps appending: the
+// writer publishes the new size only after the bytes are in place.
+class ChunkedArena
+{
+public:
+    ChunkedArena(std::size_t chunkBytes, std::size_t maxChunks);
+    ~ChunkedArena();
+
+    ChunkedArena(const ChunkedArena&) = delete;
+    ChunkedArena& operator=(const ChunkedArena&) = delete;
+
+    // Writer side (one thread at a time). Returns the number of bytes stored,
+    // which is less than `length` once the capacity is exhausted.
+    qint64 append(const char* data, qint64 length);
+
+    // Replace bytes that were already appended, e.g. to patch a file header.
+    // Readers that already consumed the range keep the old bytes.
+    bool overwrite(qint64 offset, const char* data, qint64 length);
+
+    // Mark the content complete; no more appends follow
+    void finish();
+
+    // Reader side (any thread)
+    qint64 size() const { return m_size.load(std::memory_order_acquire); }
+    bool isFinished() const { return m_finished.load(std::memory_order_acquire); }
+    qint64 capacity() const { return static_cast<qint64>(m_chunkBytes * m_maxChunks); }
+
+    // Copy up to `maxLength` bytes starting at `offset` into `dest`
+    qint64 read(qint64 offset, char* dest, qint64 maxLength) const;
+
+    // Contiguous run of published bytes starting at `offset`, valid for the
+    // lifetime of the arena. `length` receives the run size (0 at the end).
+    const char* span(qint64 offset, qint64* length) const;
+
+    // Write the published content to disk, for archiving or debugging
+    bool writeToFile(const QString& path, QString* errorMessage = nullptr) const;
+
+private:
+    const std::size_t        m_chunkBytes;
+    const std::size_t        m_maxChunks;
+    std::unique_ptr<char*[]> m_chunks;      // Fixed table, entries filled by the writer
+    std::size_t              m_allocatedChunks;
+    std::atomic<qint64>      m_size;
+    std::atomic<bool>        m_finished;
+};
+
+#endif // CHUNKEDARENA_H
@@ -0,0 +1,121 @@
+#include "fileaudiosource.h"
+
+#include <QDebug>
+#include <chrono>
+
+#include "config/config.h"
+
+FileAudioSource::FileAudioSource()
+    : m_pacing(Pacing::RealTime),
+      m_stopRequested(false),
+      m_active(false)
+{
+}
+
+FileAudioSource::~FileAudioSource()
+{
+    stop();
+}
+
+bool FileAudioSource::open(const QString& path, Pacing pacing, QString* error)
+{
+    stop();
+    if (!decodeAudioFile(path, m_audio, error)) {
+        return false;
+    }
+    if (m_audio.sampleRate <= 0 || m_audio.sampleRate > MAX_CAPTURE_SAMPLE_RATE) {
+        *error = QString("Unsupported sample rate %1 Hz (at most %2 Hz)").arg(m_audio.sampleRate).arg(MAX_CAPTURE_SAMPLE_RATE);
+        return false;
+    }
+    if (m_audio.samples.empty()) {
+        *error = QString("No audio in %1").arg(path);
+        return false;
+    }
+    m_pacing = pacing;
+    return true;
+}
+
+void FileAudioSource::setCallbacks(BlockCallback block, FinishedCallback finished)
+{
+    m_blockCallback = std::move(block);
+    m_finishedCallback = std::move(finished);
+}
+
+bool FileAudioSource::start()
+{
+    if (m_audio.samples.empty() || !m_blockCallback) {
+        return false;
+    }
+    stop();
+    m_stopRequested.store(false, std::memory_order_relaxed);
+    m_active.store(true, std::memory_order_release);
+    m_thread = std::thread(&FileAudioSource::run, this);
+    return true;
+}
+
+void FileAudioSource::stop()
+{
+    m_stopRequested.store(true, std::memory_order_release);
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+    m_active.store(false, std::memory_order_release);
+}
+
+bool FileAudioSource::parsePacing(const QString& name, Pacing* pacing)
+{
+    const QString key = name.trimmed().toLower();
+    if (key == "realtime") {
+        *pacing = Pacing::RealTime;
+    } else if (key == "fast") {
+        *pacing = Pacing::Fast;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+void FileAudioSource::run()
+{
+    using Clock = std::chrono::steady_clock;
+
+    // PortAudio's stream time has an arbitrary origin, and 0 means "not
+    // reported" to the recorder's health tracking, so start at one second
+    constexpr double STREAM_TIME_ORIGIN = 1.0;
+
+    const std::size_t total = m_audio.samples.size();
+    const double rate = m_audio.sampleRate;
+    const Clock::time_point startTime = Clock::now();
+    std::size_t position = 0;
+
+    while (position < total && !m_stopRequested.load(std::memory_order_acquire)) {
+        const std::size_t frames = qMin<std::size_t>(FRAMES_PER_BUFFER, total - position);
+
+        if (m_pacing == Pacing::RealTime) {
+            // A block is ready once its last frame would have been captured
+            const auto due = startTime + std::chrono::duration_cast<Clock::duration>(
+                                             std::chrono::duration<double>((position + frames) / rate));
+            std::this_thread::sleep_until(due);
+        }
+
+        PaStreamCallbackTimeInfo timeInfo;
+        timeInfo.inputBufferAdcTime = STREAM_TIME_ORIGIN + position / rate;
+        timeInfo.outputBufferDacTime = 0.0;
+        timeInfo.currentTime = m_pacing == Pacing::RealTime
+                                   ? STREAM_TIME_ORIGIN + std::chrono::duration<double>(Clock::now() - startTime).count()
+                                   : timeInfo.inputBufferAdcTime + frames / rate;
+
+        if (!m_blockCallback(m_audio.samples.data() + position, static_cast<unsigned long>(frames), &timeInfo, 0)) {
+            // The consumer is full; wait for it instead of dropping audio
+            std::this_thread::sleep_for(std::chrono::milliseconds(FILE_INPUT_RETRY_INTERVAL_MS));
+            continue;
+        }
+        position += frames;
+    }
+
+    const bool completed = position >= total;
+    m_active.store(false, std::memory_order_release);
+    if (completed && m_finishedCallback) {
+        m_finishedCallback();
+    }
+}
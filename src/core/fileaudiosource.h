@@ -0,0 +1,68 @@
+#ifndef FILEAUDIOSOURCE_H
+#define FILEAUDIOSOURCE_H
+
+#include <QString>
+#include <QtGlobal>
+#include <atomic>
+#include <functional>
+#include <thread>
+#include <vector>
+#include <portaudio.h>
+
+#include "audiofiledecoder.h"
+
+// Virtual input device: replays a decoded audio file (MP3 or WAV) in
+// callback-sized blocks from its own thread, with the same arguments a
+// PortAudio input callback gets. Runs in real time or as fast as the
+// consumer accepts the blocks, so whole recordings can be run and profiled
+// without a microphone and with identical input every time.
+class FileAudioSource
+{
+public:
+    enum class Pacing
+    {
+        RealTime,   // One block per block duration, like a sound card
+        Fast        // Back to back; a refused block is offered again
+    };
+
+    // Returns false to refuse a block (Fast only: it is offered again shortly)
+    using BlockCallback = std::function<bool(const short* samples, unsigned long frames,
+                                             const PaStreamCallbackTimeInfo* timeInfo,
+                                             PaStreamCallbackFlags statusFlags)>;
+    using FinishedCallback = std::function<void()>;
+
+    FileAudioSource();
+    ~FileAudioSource();
+
+    FileAudioSource(const FileAudioSource&) = delete;
+    FileAudioSource& operator=(const FileAudioSource&) = delete;
+
+    bool open(const QString& path, Pacing pacing, QString* error);
+    int sampleRate() const { return m_audio.sampleRate; }
+    double durationSeconds() const { return m_audio.durationSeconds(); }
+    Pacing pacing() const { return m_pacing; }
+
+    // Both run on the source thread; `finished` once the last block was delivered
+    void setCallbacks(BlockCallback block, FinishedCallback finished);
+
+    // Replays from the beginning of the file
+    bool start();
+    void stop();
+    bool isActive() const { return m_active.load(std::memory_order_acquire); }
+
+    static bool parsePacing(const QString& name, Pacing* pacing);
+
+private:
+    void run();
+
+private:
+    DecodedAudio        m_audio;
+    Pacing              m_pacing;
+    BlockCallback       m_blockCallback;
+    FinishedCallback    m_finishedCallback;
+    std::thread         m_thread;
+    std::atomic<bool>   m_stopRequested;
+    std::atomic<bool>   m_active;
+};
+
+#endif // FILEAUDIOSOURCE_H
@@ -0,0 +1,100 @@
+#include "flacencoder.h"
+
+FlacEncoder::FlacEncoder(int compressionLevel)
+    : m_compressionLevel(compressionLevel),
+      m_channels(1),
+      m_encoder(nullptr)
+{
+}
+
+FlacEncoder::~FlacEncoder()
+{
+    close();
+}
+
+void FlacEncoder::close()
+{
+    if (m_encoder) {
+        FLAC__stream_encoder_delete(m_encoder);
+        m_encoder = nullptr;
+    }
+}
+
+bool FlacEncoder::begin(int sampleRate, int channels)
+{
+    close();
+    m_pending.clear();
+    m_channels = channels;
+
+    m_encoder = FLAC__stream_encoder_new();
+    if (!m_encoder) {
+        m_lastError = "Failed to create FLAC encoder";
+        return false;
+    }
+
+    FLAC__stream_encoder_set_channels(m_encoder, static_cast<unsigned>(channels));
+    FLAC__stream_encoder_set_bits_per_sample(m_encoder, 16);
+    FLAC__stream_encoder_set_sample_rate(m_encoder, static_cast<unsigned>(sampleRate));
+    FLAC__stream_encoder_set_compression_level(m_encoder, static_cast<unsigned>(m_compressionLevel));
+    FLAC__stream_encoder_set_streamable_subset(m_encoder, true);
+
+    // No seek/tell callbacks: output may go to a pipe or the network
+    FLAC__StreamEncoderInitStatus status = FLAC__stream_encoder_init_stream(
+        m_encoder, &FlacEncoder::writeCallback, nullptr, nullptr, nullptr, this);
+    if (status != FLAC__STREAM_ENCODER_INIT_STATUS_OK) {
+        m_lastError = QString("Failed to initialize FLAC encoder: %1")
+                          .arg(FLAC__StreamEncoderInitStatusString[status]);
+        close();
+        return false;
+    }
+    return true;
+}
+
+FLAC__StreamEncoderWriteStatus FlacEncoder::writeCallback(const FLAC__StreamEncoder* /*encoder*/,
+                                                          const FLAC__byte buffer[],
+                                                          size_t bytes,
+                                                          unsigned /*samples*/,
+                                                          unsigned /*currentFrame*/,
+                                                          void* clientData)
+{
+    FlacEncoder* self = static_cast<FlacEncoder*>(clientData);
+    self->m_pending.append(reinterpret_cast<const char*>(buffer), static_cast<int>(bytes));
+    return FLAC__STREAM_ENCODER_WRITE_STATUS_OK;
+}
+
+bool FlacEncoder::encode(const short* pcm, int frames, QByteArray& out)
+{
+    if (!m_encoder) {
+        m_lastError = "FLAC encoder not initialized";
+        return false;
+    }
+
+    const std::size_t samples = static_cast<std::size_t>(frames) * m_channels;
+    m_samples.assign(pcm, pcm + samples);
+    if (frames > 0 && !FLAC__stream_encoder_process_interleaved(m_encoder, m_samples.data(), static_cast<unsigned>(frames))) {
+        m_lastError = QString("FLAC encoding error: %1")
+                          .arg(FLAC__stream_encoder_get_resolved_state_string(m_encoder));
+        return false;
+    }
+
+    out.append(m_pending);
+    m_pending.clear();
+    return true;
+}
+
+bool FlacEncoder::finish(QByteArray& out)
+{
+    if (!m_encoder) {
+        return true;
+    }
+
+    const bool ok = FLAC__stream_encoder_finish(m_encoder);
+    if (!ok) {
+        m_lastError = "FLAC encoder failed to finish the stream";
+    }
+    close();
+
+    out.append(m_pending);
+    m_pending.clear();
+    return ok;
+}
@@ -0,0 +1,39 @@
+#ifndef FLACENCODER_H
+#define FLACENCODER_H
+
+#include <FLAC/stream_encoder.h>
+#include <vector>
+
+#include "audioencoder.h"
+
+// Lossless FLAC through libFLAC's stream encoder. The stream is written
+// strictly sequentially, so STREAMINFO keeps "unknown" totals.
+class FlacEncoder : public AudioEncoder
+{
+public:
+    explicit FlacEncoder(int compressionLevel);
+    ~FlacEncoder() override;
+
+    AudioFormat format() const override { return AudioFormat::Flac; }
+    bool begin(int sampleRate, int channels) override;
+    bool encode(const short* pcm, int frames, QByteArray& out) override;
+    bool finish(QByteArray& out) override;
+
+private:
+    static FLAC__StreamEncoderWriteStatus writeCallback(const FLAC__StreamEncoder* encoder,
+                                                        const FLAC__byte buffer[],
+                                                        size_t bytes,
+                                                        unsigned samples,
+                                                        unsigned currentFrame,
+                                                        void* clientData);
+    void close();
+
+private:
+    int                  m_compressionLevel;
+    int                  m_channels;
+    FLAC__StreamEncoder* m_encoder;
+    std::vector<FLAC__int32> m_samples;  // libFLAC wants 32-bit input
+    QByteArray           m_pending;      // Output produced by libFLAC callbacks
+};
+
+#endif // FLACENCODER_H
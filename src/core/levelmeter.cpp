@@ -0,0 +1,234 @@
+#include "levelmeter.h"
+
+#include <cmath>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define LEVELMETER_HAVE_X86 1
+#endif
+
+#include "config/config.h"
+
+namespace {
+
+// Raw accumulators shared by all kernels, converted to LevelStats at the end
+struct RawLevel
+{
+    int           maxValue = -32768;
+    int           minValue = 32767;
+    std::uint64_t sumSquares = 0;
+    std::uint32_t clipped = 0;
+};
+
+inline void accumulateScalar(RawLevel& raw, const short* samples, std::size_t count)
+{
+    for (std::size_t i = 0; i < count; ++i) {
+        const int s = samples[i];
+        if (s > raw.maxValue) raw.maxValue = s;
+        if (s < raw.minValue) raw.minValue = s;
+        raw.sumSquares += static_cast<std::uint64_t>(s * s);
+        raw.clipped += (s >= LEVEL_CLIP_THRESHOLD || s <= -LEVEL_CLIP_THRESHOLD) ? 1 : 0;
+    }
+}
+
+RawLevel measureScalar(const short* samples, std::size_t count)
+{
+    RawLevel raw;
+    accumulateScalar(raw, samples, count);
+    return raw;
+}
+
+#ifdef LEVELMETER_HAVE_X86
+
+// _mm_madd_epi16(v, v) yields sums of two squares per 32-bit lane. Those are at
+// most 2 * 32768^2 = 2^31, which only fits when treated as unsigned, so the
+// lanes are zero-extended into 64-bit accumulators on every iteration.
+
+__attribute__((target("sse2")))
+RawLevel measureSse2(const short* samples, std::size_t count)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i clipHigh = _mm_set1_epi16(static_cast<short>(LEVEL_CLIP_THRESHOLD - 1));
+    const __m128i clipLow = _mm_set1_epi16(static_cast<short>(-LEVEL_CLIP_THRESHOLD + 1));
+
+    __m128i vmax = _mm_set1_epi16(-32768);
+    __m128i vmin = _mm_set1_epi16(32767);
+    __m128i acc = zero;
+    std::uint32_t clipped = 0;
+
+    std::size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(samples + i));
+        vmax = _mm_max_epi16(vmax, v);
+        vmin = _mm_min_epi16(vmin, v);
+
+        const __m128i squares = _mm_madd_epi16(v, v);
+        acc = _mm_add_epi64(acc, _mm_unpacklo_epi32(squares, zero));
+        acc = _mm_add_epi64(acc, _mm_unpackhi_epi32(squares, zero));
+
+        const __m128i clipMask = _mm_or_si128(_mm_cmpgt_epi16(v, clipHigh), _mm_cmplt_epi16(v, clipLow));
+        clipped += static_cast<std::uint32_t>(__builtin_popcount(_mm_movemask_epi8(clipMask))) / 2;
+    }
+
+    alignas(16) short maxLanes[8];
+    alignas(16) short minLanes[8];
+    alignas(16) std::uint64_t sumLanes[2];
+    _mm_store_si128(reinterpret_cast<__m128i*>(maxLanes), vmax);
+    _mm_store_si128(reinterpret_cast<__m128i*>(minLanes), vmin);
+    _mm_store_si128(reinterpret_cast<__m128i*>(sumLanes), acc);
+
+    RawLevel raw;
+    for (int lane = 0; lane < 8; ++lane) {
+        if (maxLanes[lane] > raw.maxValue) raw.maxValue = maxLanes[lane];
+        if (minLanes[lane] < raw.minValue) raw.minValue = minLanes[lane];
+    }
+    raw.sumSquares = sumLanes[0] + sumLanes[1];
+    raw.clipped = clipped;
+
+    accumulateScalar(raw, samples + i, count - i);
+    return raw;
+}
+
+__attribute__((target("avx2")))
+RawLevel measureAvx2(const short* samples, std::size_t count)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i clipHigh = _mm256_set1_epi16(static_cast<short>(LEVEL_CLIP_THRESHOLD - 1));
+    const __m256i clipLow = _mm256_set1_epi16(static_cast<short>(-LEVEL_CLIP_THRESHOLD + 1));
+
+    __m256i vmax = _mm256_set1_epi16(-32768);
+    __m256i vmin = _mm256_set1_epi16(32767);
+    __m256i acc = zero;
+    std::uint32_t clipped = 0;
+
+    std::size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(samples + i));
+        vmax = _mm256_max_epi16(vmax, v);
+        vmin = _mm256_min_epi16(vmin, v);
+
+        const __m256i squares = _mm256_madd_epi16(v, v);
+        acc = _mm256_add_epi64(acc, _mm256_unpacklo_epi32(squares, zero));
+        acc = _mm256_add_epi64(acc, _mm256_unpackhi_epi32(squares, zero));
+
+        const __m256i clipMask = _mm256_or_si256(_mm256_cmpgt_epi16(v, clipHigh), _mm256_cmpgt_epi16(clipLow, v));
+        clipped += static_cast<std::uint32_t>(__builtin_popcount(static_cast<unsigned>(_mm256_movemask_epi8(clipMask)))) / 2;
+    }
+
+    alignas(32) short maxLanes[16];
+    alignas(32) short minLanes[16];
+    alignas(32) std::uint64_t sumLanes[4];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(maxLanes), vmax);
+    _mm256_store_si256(reinterpret_cast<__m256i*>(minLanes), vmin);
+    _mm256_store_si256(reinterpret_cast<__m256i*>(sumLanes), acc);
+
+    RawLevel raw;
+    for (int lane = 0; lane < 16; ++lane) {
+        if (maxLanes[lane] > raw.maxValue) raw.maxValue = maxLanes[lane];
+        if (minLanes[lane] < raw.minValue) raw.minValue = minLanes[lane];
+    }
+    raw.sumSquares = sumLanes[0] + sumLanes[1] + sumLanes[2] + sumLanes[3];
+    raw.clipped = clipped;
+
+    accumulateScalar(raw, samples + i, count - i);
+    return raw;
+}
+
+#endif // LEVELMETER_HAVE_X86
+
+using KernelFunction = RawLevel (*)(const short*, std::size_t);
+
+KernelFunction kernelFunction(LevelMeterKernel kernel)
+{
+    switch (kernel) {
+#ifdef LEVELMETER_HAVE_X86
+    case LevelMeterKernel::Avx2:
+        return &measureAvx2;
+    case LevelMeterKernel::Sse2:
+        return &measureSse2;
+#endif
+    default:
+        return &measureScalar;
+    }
+}
+
+LevelMeterKernel selectBestKernel()
+{
+#ifdef LEVELMETER_HAVE_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return LevelMeterKernel::Avx2;
+    }
+    if (__builtin_cpu_supports("sse2")) {
+        return LevelMeterKernel::Sse2;
+    }
+#endif
+    return LevelMeterKernel::Scalar;
+}
+
+// Resolved during static initialization so the audio callback never hits a
+// function-local static guard
+const LevelMeterKernel s_activeKernel = selectBestKernel();
+const KernelFunction s_activeFunction = kernelFunction(s_activeKernel);
+
+LevelStats toLevelStats(const RawLevel& raw, std::size_t count)
+{
+    LevelStats stats;
+    if (count == 0) {
+        return stats;
+    }
+
+    stats.peak = raw.maxValue > -raw.minValue ? raw.maxValue : -raw.minValue;
+    stats.rms = static_cast<float>(std::sqrt(static_cast<double>(raw.sumSquares) / count) / 32768.0);
+    stats.clippedSamples = static_cast<int>(raw.clipped);
+    return stats;
+}
+
+} // namespace
+
+LevelStats measureLevel(const short* samples, std::size_t count)
+{
+    return toLevelStats(s_activeFunction(samples, count), count);
+}
+
+LevelStats measureLevelWith(LevelMeterKernel kernel, const short* samples, std::size_t count)
+{
+    if (!isLevelMeterKernelSupported(kernel)) {
+        kernel = LevelMeterKernel::Scalar;
+    }
+    return toLevelStats(kernelFunction(kernel)(samples, count), count);
+}
+
+bool isLevelMeterKernelSupported(LevelMeterKernel kernel)
+{
+    switch (kernel) {
+    case LevelMeterKernel::Scalar:
+        return true;
+#ifdef LEVELMETER_HAVE_X86
+    case LevelMeterKernel::Sse2:
+        return __builtin_cpu_supports("sse2");
+    case LevelMeterKernel::Avx2:
+        return __builtin_cpu_supports("avx2");
+#endif
+    default:
+        return false;
+    }
+}
+
+LevelMeterKernel activeLevelMeterKernel()
+{
+    return s_activeKernel;
+}
+
+const char* levelMeterKernelName(LevelMeterKernel kernel)
+{
+    switch (kernel) {
+    case LevelMeterKernel::Sse2:
+        return "sse2";
+    case LevelMeterKernel::Avx2:
+        return "avx2";
+    default:
+        return "scalar";
+    }
+}
@@ -0,0 +1,36 @@
+#ifndef LEVELMETER_H
+#define LEVELMETER_H
+
+#include <cstddef>
+
+// Result of a single metering pass over a block of int16 PCM
+struct LevelStats
+{
+    int   peak = 0;             // Largest absolute sample value (0..32768)
+    float rms = 0.0f;           // Root-mean-square level normalized to 0..1
+    int   clippedSamples = 0;   // Samples at or beyond LEVEL_CLIP_THRESHOLD
+
+    float peakNormalized() const { return peak / 32768.0f; }
+};
+
+// Available implementations of the metering kernel
+enum class LevelMeterKernel
+{
+    Scalar,
+    Sse2,
+    Avx2
+};
+
+// Measure peak, RMS and clipping in one pass using the fastest kernel the
+// CPU supports. Selection happens once at load time, so this is safe to call
+// from the real-time audio callback.
+LevelStats measureLevel(const short* samples, std::size_t count);
+
+// Same as measureLevel() but forces a specific kernel (used by benchmarks)
+LevelStats measureLevelWith(LevelMeterKernel kernel, const short* samples, std::size_t count);
+
+bool isLevelMeterKernelSupported(LevelMeterKernel kernel);
+LevelMeterKernel activeLevelMeterKernel();
+const char* levelMeterKernelName(LevelMeterKernel kernel);
+
+#endif // LEVELMETER_H
@@ -0,0 +1,125 @@
+#include "mp3encoder.h"
+
+Mp3Encoder::Mp3Encoder(int bitrate)
+    : m_bitrate(bitrate),
+      m_channels(1),
+      m_lameGlobal(nullptr)
+{
+}
+
+Mp3Encoder::~Mp3Encoder()
+{
+    close();
+}
+
+void Mp3Encoder::close()
+{
+    if (m_lameGlobal) {
+        lame_close(m_lameGlobal);
+        m_lameGlobal = nullptr;
+    }
+}
+
+bool Mp3Encoder::begin(int sampleRate, int channels)
+{
+    // Clean up any existing encoder
+    close();
+    m_channels = channels;
+
+    // Create encoder instance
+    m_lameGlobal = lame_init();
+    if (!m_lameGlobal) {
+        m_lastError = "Failed to initialize LAME MP3 encoder";
+        return false;
+    }
+
+    // Set encoder parameters
+    lame_set_num_channels(m_lameGlobal, channels);
+    lame_set_in_samplerate(m_lameGlobal, sampleRate);
+    lame_set_brate(m_lameGlobal, m_bitrate / 1000); // LAME uses kbps
+    lame_set_quality(m_lameGlobal, 2); // 0=best, 9=worst
+    lame_set_mode(m_lameGlobal, channels == 1 ? MONO : STEREO);
+
+    // Initialize the encoder
+    if (lame_init_params(m_lameGlobal) < 0) {
+        m_lastError = "Failed to initialize LAME parameters";
+        close();
+        return false;
+    }
+
+    return true;
+}
+
+bool Mp3Encoder::encode(const short* pcm, int frames, QByteArray& out)
+{
+    if (!m_lameGlobal) {
+        m_lastError = "MP3 encoder not initialized";
+        return false;
+    }
+    if (frames <= 0) {
+        return true;
+    }
+
+    // MP3 buffer needs to be 1.25x + 7200 bytes larger than the PCM data
+    const int mp3BufferSize = static_cast<int>(frames * 1.25) + 7200;
+    const int offset = out.size();
+    out.resize(offset + mp3BufferSize);
+
+    int bytesEncoded = 0;
+    if (m_channels == 1) {
+        bytesEncoded = lame_encode_buffer(
+            m_lameGlobal,
+            pcm,              // left channel (mono = only channel)
+            nullptr,          // right channel (unused for mono)
+            frames,
+            reinterpret_cast<unsigned char*>(out.data() + offset),
+            mp3BufferSize
+        );
+    } else {
+        bytesEncoded = lame_encode_buffer_interleaved(
+            m_lameGlobal,
+            const_cast<short*>(pcm),
+            frames,
+            reinterpret_cast<unsigned char*>(out.data() + offset),
+            mp3BufferSize
+        );
+    }
+
+    if (bytesEncoded < 0) {
+        out.resize(offset);
+        m_lastError = QString("MP3 encoding error: %1").arg(bytesEncoded);
+        return false;
+    }
+
+    // Resize to actual encoded size
+    out.resize(offset + bytesEncoded);
+    return true;
+}
+
+bool Mp3Encoder::finish(QByteArray& out)
+{
+    if (!m_lameGlobal) {
+        return true;
+    }
+
+    const int mp3BufferSize = 7200;
+    const int offset = out.size();
+    out.resize(offset + mp3BufferSize);
+
+    // Flush remaining MP3 data - use safer flush_nogap instead of regular flush
+    int bytesEncoded = lame_encode_flush_nogap(
+        m_lameGlobal,
+        reinterpret_cast<unsigned char*>(out.data() + offset),
+        mp3BufferSize
+    );
+    close();
+
+    if (bytesEncoded < 0) {
+        out.resize(offset);
+        m_lastError = QString("MP3 flush error: %1").arg(bytesEncoded);
+        return false;
+    }
+
+    out.resize(offset + bytesEncoded);
+    return true;
+}
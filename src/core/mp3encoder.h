@@ -0,0 +1,29 @@
+#ifndef MP3ENCODER_H
+#define MP3ENCODER_H
+
+#include <lame/lame.h>
+
+#include "audioencoder.h"
+
+// CBR MP3 through LAME
+class Mp3Encoder : public AudioEncoder
+{
+public:
+    explicit Mp3Encoder(int bitrate);
+    ~Mp3Encoder() override;
+
+    AudioFormat format() const override { return AudioFormat::Mp3; }
+    bool begin(int sampleRate, int channels) override;
+    bool encode(const short* pcm, int frames, QByteArray& out) override;
+    bool finish(QByteArray& out) override;
+
+private:
+    void close();
+
+private:
+    int                m_bitrate;
+    int                m_channels;
+    lame_global_flags* m_lameGlobal;
+};
+
+#endif // MP3ENCODER_H
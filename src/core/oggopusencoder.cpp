@@ -0,0 +1,211 @@
+#include "oggopusencoder.h"
+
+#include <QRandomGenerator>
+#include <QtEndian>
+#include <cstring>
+
+namespace {
+
+constexpr int OPUS_FRAME_MS = 20;
+constexpr int OPUS_MAX_PACKET_BYTES = 4000;
+constexpr int OPUS_GRANULE_RATE = 48000;   // Ogg Opus granule positions are always 48 kHz
+constexpr char OPUS_VENDOR[] = "voice_input";
+
+bool isNativeOpusRate(int sampleRate)
+{
+    return sampleRate == 8000 || sampleRate == 12000 || sampleRate == 16000
+        || sampleRate == 24000 || sampleRate == 48000;
+}
+
+} // namespace
+
+OggOpusEncoder::OggOpusEncoder(int bitrate)
+    : m_bitrate(bitrate),
+      m_sampleRate(0),
+      m_channels(1),
+      m_frameSize(0),
+      m_granuleScale(1),
+      m_preSkip(0),
+      m_encoder(nullptr),
+      m_streamOpen(false),
+      m_packetNumber(0),
+      m_samplesEncoded(0),
+      m_packet(OPUS_MAX_PACKET_BYTES)
+{
+    std::memset(&m_stream, 0, sizeof(m_stream));
+}
+
+OggOpusEncoder::~OggOpusEncoder()
+{
+    close();
+}
+
+void OggOpusEncoder::close()
+{
+    if (m_encoder) {
+        opus_encoder_destroy(m_encoder);
+        m_encoder = nullptr;
+    }
+    if (m_streamOpen) {
+        ogg_stream_clear(&m_stream);
+        m_streamOpen = false;
+    }
+}
+
+bool OggOpusEncoder::begin(int sampleRate, int channels)
+{
+    close();
+    m_pendingPcm.clear();
+    m_headerPages.clear();
+
+    if (!isNativeOpusRate(sampleRate)) {
+        m_lastError = QString("Opus does not support %1 Hz input").arg(sampleRate);
+        return false;
+    }
+
+    int error = OPUS_OK;
+    m_encoder = opus_encoder_create(sampleRate, channels, OPUS_APPLICATION_VOIP, &error);
+    if (error != OPUS_OK || !m_encoder) {
+        m_lastError = QString("Failed to create Opus encoder: %1").arg(opus_strerror(error));
+        m_encoder = nullptr;
+        return false;
+    }
+    opus_encoder_ctl(m_encoder, OPUS_SET_BITRATE(m_bitrate));
+    opus_encoder_ctl(m_encoder, OPUS_SET_SIGNAL(OPUS_SIGNAL_VOICE));
+
+    opus_int32 lookahead = 0;
+    opus_encoder_ctl(m_encoder, OPUS_GET_LOOKAHEAD(&lookahead));
+
+    m_sampleRate = sampleRate;
+    m_channels = channels;
+    m_frameSize = sampleRate * OPUS_FRAME_MS / 1000;
+    m_granuleScale = OPUS_GRANULE_RATE / sampleRate;
+    m_preSkip = lookahead * m_granuleScale;
+    m_packetNumber = 0;
+    m_samplesEncoded = 0;
+
+    ogg_stream_init(&m_stream, static_cast<int>(QRandomGenerator::global()->generate() & 0x7fffffff));
+    m_streamOpen = true;
+
+    // Identification header (RFC 7845, section 5.1)
+    QByteArray head(19, '\0');
+    uchar* h = reinterpret_cast<uchar*>(head.data());
+    std::memcpy(h, "OpusHead", 8);
+    h[8] = 1;                                                   // version
+    h[9] = static_cast<uchar>(channels);
+    qToLittleEndian<quint16>(static_cast<quint16>(m_preSkip), h + 10);
+    qToLittleEndian<quint32>(static_cast<quint32>(sampleRate), h + 12);
+    qToLittleEndian<quint16>(0, h + 16);                        // output gain
+    h[18] = 0;                                                  // mapping family
+
+    // Comment header (section 5.2) with no user comments
+    const quint32 vendorLength = sizeof(OPUS_VENDOR) - 1;
+    QByteArray tags(8 + 4 + static_cast<int>(vendorLength) + 4, '\0');
+    uchar* t = reinterpret_cast<uchar*>(tags.data());
+    std::memcpy(t, "OpusTags", 8);
+    qToLittleEndian<quint32>(vendorLength, t + 8);
+    std::memcpy(t + 12, OPUS_VENDOR, vendorLength);
+    qToLittleEndian<quint32>(0, t + 12 + vendorLength);
+
+    const QByteArray* headers[] = {&head, &tags};
+    for (int i = 0; i < 2; ++i) {
+        ogg_packet packet;
+        packet.packet = reinterpret_cast<unsigned char*>(const_cast<char*>(headers[i]->constData()));
+        packet.bytes = headers[i]->size();
+        packet.b_o_s = i == 0 ? 1 : 0;
+        packet.e_o_s = 0;
+        packet.granulepos = 0;
+        packet.packetno = m_packetNumber++;
+        ogg_stream_packetin(&m_stream, &packet);
+
+        // Each header must sit on its own page
+        writePages(m_headerPages, true);
+    }
+    return true;
+}
+
+bool OggOpusEncoder::encodeFrame(const short* pcm, bool endOfStream, qint64 granuleAfter)
+{
+    const opus_int32 bytes = opus_encode(m_encoder, pcm, m_frameSize, m_packet.data(),
+                                         static_cast<opus_int32>(m_packet.size()));
+    if (bytes < 0) {
+        m_lastError = QString("Opus encoding error: %1").arg(opus_strerror(bytes));
+        return false;
+    }
+
+    ogg_packet packet;
+    packet.packet = m_packet.data();
+    packet.bytes = bytes;
+    packet.b_o_s = 0;
+    packet.e_o_s = endOfStream ? 1 : 0;
+    packet.granulepos = granuleAfter;
+    packet.packetno = m_packetNumber++;
+    ogg_stream_packetin(&m_stream, &packet);
+    return true;
+}
+
+void OggOpusEncoder::writePages(QByteArray& out, bool flush)
+{
+    ogg_page page;
+    while (flush ? ogg_stream_flush(&m_stream, &page) : ogg_stream_pageout(&m_stream, &page)) {
+        out.append(reinterpret_cast<const char*>(page.header), static_cast<int>(page.header_len));
+        out.append(reinterpret_cast<const char*>(page.body), static_cast<int>(page.body_len));
+    }
+}
+
+bool OggOpusEncoder::encode(const short* pcm, int frames, QByteArray& out)
+{
+    if (!m_encoder) {
+        m_lastError = "Opus encoder not initialized";
+        return false;
+    }
+
+    out.append(m_headerPages);
+    m_headerPages.clear();
+
+    m_pendingPcm.insert(m_pendingPcm.end(), pcm, pcm + static_cast<std::size_t>(frames) * m_channels);
+
+    const std::size_t frameSamples = static_cast<std::size_t>(m_frameSize) * m_channels;
+    std::size_t offset = 0;
+    while (m_pendingPcm.size() - offset >= frameSamples) {
+        m_samplesEncoded += m_frameSize;
+        if (!encodeFrame(m_pendingPcm.data() + offset, false, m_preSkip + m_samplesEncoded * m_granuleScale)) {
+            return false;
+        }
+        offset += frameSamples;
+    }
+    m_pendingPcm.erase(m_pendingPcm.begin(), m_pendingPcm.begin() + static_cast<std::ptrdiff_t>(offset));
+
+    writePages(out, false);
+    return true;
+}
+
+bool OggOpusEncoder::finish(QByteArray& out)
+{
+    if (!m_encoder) {
+        return true;
+    }
+
+    out.append(m_headerPages);
+    m_headerPages.clear();
+
+    // Pad the tail with silence far enough to push the encoder lookahead out.
+    // The final granule position tells the decoder where the real audio ends.
+    const int remaining = static_cast<int>(m_pendingPcm.size()) / m_channels;
+    const int lookahead = m_preSkip / m_granuleScale;
+    const int tailFrames = qMax(1, (remaining + lookahead + m_frameSize - 1) / m_frameSize);
+    const qint64 finalGranule = m_preSkip + (m_samplesEncoded + remaining) * m_granuleScale;
+
+    m_pendingPcm.resize(static_cast<std::size_t>(tailFrames) * m_frameSize * m_channels, 0);
+    bool ok = true;
+    for (int i = 0; i < tailFrames && ok; ++i) {
+        const short* frame = m_pendingPcm.data() + static_cast<std::size_t>(i) * m_frameSize * m_channels;
+        ok = encodeFrame(frame, i == tailFrames - 1, finalGranule);
+    }
+    m_samplesEncoded += remaining;
+    m_pendingPcm.clear();
+
+    writePages(out, true);
+    close();
+    return ok;
+}
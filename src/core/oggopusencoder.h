@@ -0,0 +1,45 @@
+#ifndef OGGOPUSENCODER_H
+#define OGGOPUSENCODER_H
+
+#include <ogg/ogg.h>
+#include <opus.h>
+#include <vector>
+
+#include "audioencoder.h"
+
+// Opus (VoIP mode) packed into Ogg pages per RFC 7845. Only the sample rates
+// Opus supports natively are accepted: 8, 12, 16, 24 and 48 kHz.
+class OggOpusEncoder : public AudioEncoder
+{
+public:
+    explicit OggOpusEncoder(int bitrate);
+    ~OggOpusEncoder() override;
+
+    AudioFormat format() const override { return AudioFormat::Opus; }
+    bool begin(int sampleRate, int channels) override;
+    bool encode(const short* pcm, int frames, QByteArray& out) override;
+    bool finish(QByteArray& out) override;
+
+private:
+    bool encodeFrame(const short* pcm, bool endOfStream, qint64 granuleAfter);
+    void writePages(QByteArray& out, bool flush);
+    void close();
+
+private:
+    int             m_bitrate;
+    int             m_sampleRate;
+    int             m_channels;
+    int             m_frameSize;       // Samples per channel in one 20 ms Opus frame
+    int             m_granuleScale;    // 48 kHz granule units per input sample
+    int             m_preSkip;         // Encoder lookahead in 48 kHz units
+    ::OpusEncoder*  m_encoder;
+    ogg_stream_state m_stream;
+    bool            m_streamOpen;
+    qint64          m_packetNumber;
+    qint64          m_samplesEncoded;  // Real (non-padding) input samples per channel
+    std::vector<short> m_pendingPcm;   // Input not yet filling a whole frame
+    QByteArray      m_headerPages;     // Written ahead of the first audio output
+    std::vector<unsigned char> m_packet;
+};
+
+#endif // OGGOPUSENCODER_H
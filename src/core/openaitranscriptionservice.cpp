@@ -7,13 +7,54 @@
 #include <QProcessEnvironment>
 #include <QTimer>
 #include <QFileInfo>
+#include "arenadevice.h"
 #include "config/config.h"
+#include "tracer.h"
+
+namespace {
+
+// Set on a reply that the stall watchdog aborted
+constexpr auto STALLED_PROPERTY = "transcriptionStalled";
+
+// Transport failures (as opposed to HTTP errors and our own aborts) may leave
+// a dead socket in the manager's connection pool
+bool isConnectionError(QNetworkReply::NetworkError error)
+{
+    return error != QNetworkReply::NoError
+           && error != QNetworkReply::OperationCanceledError
+           && error < QNetworkReply::ProxyConnectionRefusedError;
+}
+
+// Error text of a failed reply; empty on success
+QString replyError(QNetworkReply* reply)
+{
+    if (reply->property(STALLED_PROPERTY).toBool()) {
+        return "Network error: connection stalled";
+    }
+    if (reply->error() != QNetworkReply::NoError) {
+        return QString("Network error: %1").arg(reply->errorString());
+    }
+    return QString();
+}
+
+// For RetryPolicy::isRetryable(): a stall is aborted by us, but is a timeout
+QNetworkReply::NetworkError replyErrorCode(QNetworkReply* reply)
+{
+    if (reply->property(STALLED_PROPERTY).toBool()) {
+        return QNetworkReply::TimeoutError;
+    }
+    return reply->error();
+}
+
+} // namespace
 
 OpenAiTranscriptionService::OpenAiTranscriptionService(QObject* parent)
-    : QObject(parent),
+    : TranscriptionBackend(parent),
       m_networkManager(new QNetworkAccessManager(this)),
       m_currentReply(nullptr),
-      m_isTranscribing(false)
+      m_streamingUpload(new StreamingUpload(this)),
+      m_isTranscribing(false),
+      m_requestStats(sharedRequestStatistics())
 {
     // Retrieve API key from environment variable
     QProcessEnvironment env = QProcessEnvironment::systemEnvironment();
@@ -22,6 +63,27 @@ OpenAiTranscriptionService::OpenAiTranscriptionService(QObject* parent)
     // Connect network signals
     connect(m_networkManager, &QNetworkAccessManager::finished, 
             this, &OpenAiTranscriptionService::handleNetworkReply);
+    
+    connect(m_streamingUpload, &StreamingUpload::uploadProgress, this, &OpenAiTranscriptionService::onStreamingProgress);
+    connect(m_streamingUpload, &StreamingUpload::finished, this, &OpenAiTranscriptionService::onStreamingFinished);
+    connect(m_streamingUpload, &StreamingUpload::failed, this, &OpenAiTranscriptionService::onStreamingFailed);
+    connect(m_streamingUpload, &StreamingUpload::bodySent, this, &OpenAiTranscriptionService::traceBodySent);
+    
+    m_hedgeTimer.setSingleShot(true);
+    connect(&m_hedgeTimer, &QTimer::timeout, this, &OpenAiTranscriptionService::sendHedge);
+    m_deadlineTimer.setSingleShot(true);
+    connect(&m_deadlineTimer, &QTimer::timeout, this, &OpenAiTranscriptionService::onDeadlineExpired);
+}
+
+QSharedPointer<RequestStatistics> OpenAiTranscriptionService::sharedRequestStatistics()
+{
+    // Loaded on first use; GUI thread only, like the services themselves
+    static QSharedPointer<RequestStatistics> stats;
+    if (!stats) {
+        stats.reset(new RequestStatistics());
+        stats->load();
+    }
+    return stats;
 }
 
 OpenAiTranscriptionService::~OpenAiTranscriptionService()
@@ -29,7 +91,7 @@ OpenAiTranscriptionService::~OpenAiTranscriptionService()
     cancelTranscription();
 }
 
-void OpenAiTranscriptionService::transcribeAudio(const QString& audioFilePath, const QString& language)
+bool OpenAiTranscriptionService::prepareRequest(qint64 audioMs)
 {
     // Check if we're already transcribing
     if (m_isTranscribing) {
@@ -40,6 +102,130 @@ void OpenAiTranscriptionService::transcribeAudio(const QString& audioFilePath, c
     if (!hasApiKey()) {
         m_lastError = "OpenAI API key not found in environment variable OPENAI_API_KEY";
         emit transcriptionFailed(m_lastError);
+        return false;
+    }
+    
+    if (m_resetConnections) {
+        recreateNetworkManager();
+    }
+    
+    ++m_requestGeneration;
+    m_failedAttempts = 0;
+    m_retryPolicy.start(audioMs);
+    armDeadline();
+    return true;
+}
+
+void OpenAiTranscriptionService::setAudioDuration(qint64 durationMs)
+{
+    m_audioDurationMs = durationMs;
+    
+    // A streamed recording has just ended; its deadline starts now
+    if (m_isTranscribing && m_requestStreamed) {
+        m_retryPolicy.start(durationMs);
+        armDeadline();
+    }
+}
+
+void OpenAiTranscriptionService::armDeadline()
+{
+    const qint64 remaining = m_retryPolicy.remainingMs();
+    if (remaining < 0) {
+        m_deadlineTimer.stop();
+    } else {
+        m_deadlineTimer.start(static_cast<int>(remaining));
+    }
+}
+
+void OpenAiTranscriptionService::onDeadlineExpired()
+{
+    if (!m_isTranscribing) {
+        return;
+    }
+    const QString error = QString("Transcription took too long, gave up after %1 attempts").arg(m_failedAttempts + 1);
+    cancelTranscription();
+    m_lastError = error;
+    qWarning() << "Transcription failed:" << m_lastError;
+    emit transcriptionFailed(m_lastError);
+}
+
+bool OpenAiTranscriptionService::scheduleRetry(int httpStatus, QNetworkReply::NetworkError errorCode,
+                                               const QByteArray& retryAfter, const QString& error)
+{
+    if (!RetryPolicy::isRetryable(httpStatus, errorCode)) {
+        return false;
+    }
+    ++m_failedAttempts;
+    const qint64 delayMs = m_retryPolicy.nextDelayMs(m_failedAttempts, RetryPolicy::parseRetryAfter(retryAfter));
+    if (delayMs < 0) {
+        qWarning() << "Not retrying after" << m_failedAttempts << "attempts:" << error;
+        return false;
+    }
+    
+    qWarning() << "Attempt" << m_failedAttempts << "failed:" << error << "HTTP status:" << httpStatus
+               << "- retrying in" << delayMs << "ms";
+    Tracer::instance().instant("retry", "network", QString("%1, in %2 ms").arg(error).arg(delayMs));
+    emit transcriptionProgress(QString("Connection problem, retrying in %1 s...").arg(delayMs / 1000.0, 0, 'f', 1));
+    
+    const quint64 generation = m_requestGeneration;
+    QTimer::singleShot(static_cast<int>(delayMs), this, [this, generation]() {
+        if (generation == m_requestGeneration && m_isTranscribing) {
+            resendRequest();
+        }
+    });
+    return true;
+}
+
+void OpenAiTranscriptionService::resendRequest()
+{
+    if (m_resetConnections) {
+        recreateNetworkManager();
+    }
+    if (m_requestStreamed) {
+        startStream();
+        return;
+    }
+    
+    QIODevice* audioDevice = nullptr;
+    if (m_requestAudio) {
+        audioDevice = new ArenaDevice(m_requestAudio);
+        audioDevice->open(QIODevice::ReadOnly);
+    } else {
+        QFile* file = new QFile(m_requestFilePath);
+        if (!file->open(QIODevice::ReadOnly)) {
+            delete file;
+            handleResponse(0, "Could not reopen audio file: " + m_requestFilePath, QByteArray());
+            return;
+        }
+        audioDevice = file;
+    }
+    postAudio(audioDevice, m_requestFilename, m_requestLanguage);
+}
+
+void OpenAiTranscriptionService::preconnect()
+{
+    if (!hasApiKey() || m_isTranscribing) {
+        return;
+    }
+    if (m_resetConnections) {
+        recreateNetworkManager();
+    }
+    
+    // The request that follows reuses this connection from the manager's pool;
+    // an already open one is kept as it is
+    const QUrl url = apiUrl();
+    Tracer::instance().instant("preconnect", "network", url.host());
+    qDebug() << "Pre-connecting to" << url.host();
+    if (url.scheme() == "https") {
+        m_networkManager->connectToHostEncrypted(url.host(), static_cast<quint16>(url.port(443)));
+    } else {
+        m_networkManager->connectToHost(url.host(), static_cast<quint16>(url.port(80)));
+    }
+}
+
+void OpenAiTranscriptionService::transcribeAudio(const QString& audioFilePath, const QString& language)
+{
+    if (!prepareRequest(m_audioDurationMs)) {
         return;
     }
     
@@ -55,9 +241,10 @@ void OpenAiTranscriptionService::transcribeAudio(const QString& audioFilePath, c
     QFileInfo fileInfo(audioFilePath);
     qDebug() << "File extension:" << fileInfo.suffix();
     
-    // Verify it's an MP3 file
-    if (fileInfo.suffix().toLower() != "mp3") {
-        qWarning() << "Warning: File extension is not mp3, may not be recognized by the API";
+    // Verify it's a container the API accepts
+    static const QStringList supportedSuffixes = {"mp3", "wav", "flac", "ogg"};
+    if (!supportedSuffixes.contains(fileInfo.suffix().toLower())) {
+        qWarning() << "Warning: File extension" << fileInfo.suffix() << "may not be recognized by the API";
     }
     
     // Create a file object that will be owned by the multipart
@@ -69,23 +256,124 @@ void OpenAiTranscriptionService::transcribeAudio(const QString& audioFilePath, c
         return;
     }
     
+    // Keep the original file extension
+    qDebug() << "Sending audio file:" << audioFilePath;
+    m_requestAudio.reset();
+    m_requestStreamed = false;
+    m_requestFilePath = audioFilePath;
+    m_requestFilename = "audio." + fileInfo.suffix();
+    m_requestLanguage = language;
+    postAudio(audioFilePtr, m_requestFilename, language);
+}
+
+void OpenAiTranscriptionService::transcribeRecording(QSharedPointer<const ChunkedArena> audio,
+                                                     AudioFormat format,
+                                                     const QString& language)
+{
+    if (!prepareRequest(m_audioDurationMs)) {
+        return;
+    }
+    
+    if (!audio || audio->size() == 0) {
+        m_lastError = "Recording is empty";
+        emit transcriptionFailed(m_lastError);
+        return;
+    }
+    
+    // The multipart reads straight out of the recorder's memory
+    ArenaDevice* audioDevice = new ArenaDevice(audio);
+    audioDevice->open(QIODevice::ReadOnly);
+    
+    qDebug() << "Sending in-memory recording";
+    m_requestAudio = audio;
+    m_requestStreamed = false;
+    m_requestFilename = "audio." + audioFormatExtension(format);
+    m_requestLanguage = language;
+    postAudio(audioDevice, m_requestFilename, language);
+}
+
+void OpenAiTranscriptionService::streamRecording(QSharedPointer<const ChunkedArena> audio,
+                                                 AudioFormat format,
+                                                 const QString& language)
+{
+    // The recording has just started; the deadline waits for its end
+    if (!prepareRequest(-1)) {
+        return;
+    }
+    
+    if (!audio) {
+        m_lastError = "No recording to stream";
+        emit transcriptionFailed(m_lastError);
+        return;
+    }
+    
+    m_requestAudio = audio;
+    m_requestStreamed = true;
+    m_requestFilename = "audio." + audioFormatExtension(format);
+    m_requestLanguage = language;
+    m_isTranscribing = true;
+    startStream();
+}
+
+void OpenAiTranscriptionService::startStream()
+{
+    StreamingUpload::HeaderList headers;
+    headers.append({"Authorization", QString("Bearer %1").arg(m_apiKey).toUtf8()});
+    StreamingUpload::HeaderList fields;
+    fields.append({"model", "whisper-1"});
+    fields.append({"temperature", "0.1"});
+    
+    // A retry sends everything recorded so far, then keeps up with the rest
+    qDebug() << "Streaming recording to" << apiUrl().toString() << "while it is captured";
+    traceRequestStarted("streamed while recording");
+    m_streamingUpload->start(apiUrl(), headers, fields, m_requestFilename, m_requestAudio);
+}
+
+void OpenAiTranscriptionService::postAudio(QIODevice* audioDevice, const QString& filename, const QString& language)
+{
+    // Send the request
+    m_isTranscribing = true;
+    emit transcriptionProgress("Sending audio to transcription service...");
+    
+    const qint64 payloadBytes = audioDevice->size();
+    traceRequestStarted(QString("%1, %2 bytes").arg(filename).arg(payloadBytes));
+    m_currentReply = sendAudio(audioDevice, filename, language);
+    watchReply(m_currentReply, "upload", payloadBytes, m_audioDurationMs);
+    m_hedgeArmed = false;
+    if (m_hedgingEnabled && m_requestAudio) {
+        m_requestStats->increment("hedge_eligible");
+    }
+    
+    // Connect to progress signals
+    connect(m_currentReply, &QNetworkReply::uploadProgress, this, &OpenAiTranscriptionService::onUploadProgress);
+}
+
+void OpenAiTranscriptionService::recreateNetworkManager()
+{
+    TraceSpan span("create network manager", "network");
+    m_resetConnections = false;
+    if (m_networkManager) {
+        m_networkManager->deleteLater();
+    }
+    m_networkManager = new QNetworkAccessManager(this);
+    connect(m_networkManager, &QNetworkAccessManager::finished, this, &OpenAiTranscriptionService::handleNetworkReply);
+}
+
+QNetworkReply* OpenAiTranscriptionService::sendAudio(QIODevice* audioDevice, const QString& filename, const QString& /*language*/)
+{
     // Prepare multipart request for file upload
     QHttpMultiPart* multiPart = new QHttpMultiPart(QHttpMultiPart::FormDataType);
     
     // Add the file part
     QHttpPart filePart;
-    // Don't specify a content type, let the server detect it
-    // filePart.setHeader(QNetworkRequest::ContentTypeHeader, QVariant("audio/mpeg"));
-    
-    // Keep the original file extension
-    QString filename = "audio." + fileInfo.suffix();
+    // Don't specify a content type, let the server detect it from the filename
     filePart.setHeader(QNetworkRequest::ContentDispositionHeader, 
                       QVariant(QString("form-data; name=\"file\"; filename=\"%1\"").arg(filename)));
     
-    filePart.setBodyDevice(audioFilePtr);
-    audioFilePtr->setParent(multiPart); // QHttpMultiPart takes ownership
+    filePart.setBodyDevice(audioDevice);
+    audioDevice->setParent(multiPart); // QHttpMultiPart takes ownership
     
-    qDebug() << "Sending file with filename:" << filename;
+    qDebug() << "Sending file with filename:" << filename << "size:" << audioDevice->size() << "bytes";
     multiPart->append(filePart);
     
     // Add model parameter
@@ -104,43 +392,181 @@ void OpenAiTranscriptionService::transcribeAudio(const QString& audioFilePath, c
     multiPart->append(temperaturePart);
     
     // Setup the request
-    QUrl url("https://api.openai.com/v1/audio/transcriptions");
-    QNetworkRequest request(url);
+    QNetworkRequest request(apiUrl());
     request.setRawHeader("Authorization", QString("Bearer %1").arg(m_apiKey).toUtf8());
     
-    // Set timeout to prevent hanging requests
-    request.setTransferTimeout(60000); // 60 seconds timeout
-    
     // Add debug output to understand the request being sent
-    qDebug() << "Sending audio file:" << audioFilePath << "with size:" << QFileInfo(audioFilePath).size() << "bytes";
     qDebug() << "Using API key starting with:" << m_apiKey.left(5) + "..." << "(length:" << m_apiKey.length() << ")";
     
-    // Send the request
+    QNetworkReply* reply = m_networkManager->post(request, multiPart);
+    multiPart->setParent(reply); // QNetworkReply takes ownership
+    return reply;
+}
+
+void OpenAiTranscriptionService::transcribeSegments(const QList<QSharedPointer<const ChunkedArena>>& segments,
+                                                    AudioFormat format,
+                                                    const QString& language)
+{
+    if (!prepareRequest(m_audioDurationMs)) {
+        return;
+    }
+    
+    if (segments.isEmpty()) {
+        m_lastError = "Recording is empty";
+        emit transcriptionFailed(m_lastError);
+        return;
+    }
+    
+    m_segmentJobs.clear();
+    m_segmentBytes = 0;
+    for (const QSharedPointer<const ChunkedArena>& segment : segments) {
+        SegmentJob job;
+        job.audio = segment;
+        m_segmentJobs.append(job);
+        m_segmentBytes += segment->size();
+    }
+    m_segmentFormat = format;
+    m_segmentLanguage = language;
+    m_segmentsInFlight = 0;
+    m_segmentsDone = 0;
+    ++m_segmentBatch;
+    
+    qInfo() << "Transcribing" << segments.size() << "segments, up to"
+            << TRANSCRIPTION_MAX_PARALLEL_SEGMENTS << "at a time";
     m_isTranscribing = true;
-    emit transcriptionProgress("Sending audio to transcription service...");
+    emit transcriptionProgress(QString("Transcribing %1 segments...").arg(segments.size()));
     
-    // Create a new network manager for each request to avoid issues
-    if (m_networkManager) {
-        m_networkManager->deleteLater();
+    startPendingSegments();
+}
+
+void OpenAiTranscriptionService::startPendingSegments()
+{
+    for (int i = 0; i < m_segmentJobs.size() && m_segmentsInFlight < TRANSCRIPTION_MAX_PARALLEL_SEGMENTS; ++i) {
+        SegmentJob& job = m_segmentJobs[i];
+        if (job.done || job.reply || job.retryPending) {
+            continue;
+        }
+        
+        ArenaDevice* audioDevice = new ArenaDevice(job.audio);
+        audioDevice->open(QIODevice::ReadOnly);
+        
+        ++job.attempts;
+        ++m_segmentsInFlight;
+        const qint64 payloadBytes = job.audio->size();
+        job.reply = sendAudio(audioDevice, "audio." + audioFormatExtension(m_segmentFormat), m_segmentLanguage);
+        // Segments share one encoder setting, so bytes split the duration well enough
+        const qint64 audioMs = m_audioDurationMs >= 0 && m_segmentBytes > 0
+                                   ? m_audioDurationMs * payloadBytes / m_segmentBytes
+                                   : -1;
+        watchReply(job.reply, "segment", payloadBytes, audioMs);
+        Tracer::instance().asyncBegin("segment request", "network", reinterpret_cast<quintptr>(job.reply),
+                                      QString("segment %1, attempt %2").arg(i + 1).arg(job.attempts));
+        qDebug() << "Segment" << i + 1 << "of" << m_segmentJobs.size() << "sent, attempt" << job.attempts;
     }
-    m_networkManager = new QNetworkAccessManager(this);
-    connect(m_networkManager, &QNetworkAccessManager::finished, this, &OpenAiTranscriptionService::handleNetworkReply);
+}
+
+void OpenAiTranscriptionService::handleSegmentReply(int index, QNetworkReply* reply)
+{
+    Tracer::instance().asyncEnd("segment request", "network", reinterpret_cast<quintptr>(reply));
+    SegmentJob& job = m_segmentJobs[index];
+    job.reply = nullptr;
+    --m_segmentsInFlight;
     
-    m_currentReply = m_networkManager->post(request, multiPart);
-    multiPart->setParent(m_currentReply); // QNetworkReply takes ownership
+    const int httpStatus = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    const QByteArray responseData = reply->readAll();
+    const QByteArray retryAfter = reply->rawHeader("Retry-After");
+    QString error = replyError(reply);
+    const QNetworkReply::NetworkError errorCode = replyErrorCode(reply);
+    reply->deleteLater();
     
-    // Connect to progress signals
-    connect(m_currentReply, &QNetworkReply::uploadProgress, this, &OpenAiTranscriptionService::onUploadProgress);
+    QString text;
+    if (error.isEmpty() && parseTranscriptionResponse(responseData, &text, &error)) {
+        job.text = text.trimmed();
+        job.done = true;
+        ++m_segmentsDone;
+        emit transcriptionProgress(QString("Transcribed %1 of %2 segments").arg(m_segmentsDone).arg(m_segmentJobs.size()));
+        
+        if (m_segmentsDone == m_segmentJobs.size()) {
+            // Stitch in recording order, whatever order the responses came in
+            QStringList parts;
+            for (const SegmentJob& finished : m_segmentJobs) {
+                if (!finished.text.isEmpty()) {
+                    parts << finished.text;
+                }
+            }
+            m_segmentJobs.clear();
+            m_isTranscribing = false;
+            completeTranscription(parts.join(' '));
+        } else {
+            startPendingSegments();
+        }
+        return;
+    }
+    
+    // A rejected request (bad key, bad audio) would fail the same way again
+    const qint64 delayMs = RetryPolicy::isRetryable(httpStatus, errorCode)
+                               ? m_retryPolicy.nextDelayMs(job.attempts, RetryPolicy::parseRetryAfter(retryAfter))
+                               : -1;
+    qWarning() << "Segment" << index + 1 << "of" << m_segmentJobs.size() << "failed on attempt" << job.attempts
+               << ":" << error << "HTTP status:" << httpStatus;
+    
+    if (delayMs >= 0) {
+        qWarning() << "Retrying segment" << index + 1 << "in" << delayMs << "ms";
+        job.retryPending = true;
+        const int batch = m_segmentBatch;
+        QTimer::singleShot(static_cast<int>(delayMs), this, [this, batch, index]() {
+            if (batch != m_segmentBatch || index >= m_segmentJobs.size()) {
+                return;
+            }
+            m_segmentJobs[index].retryPending = false;
+            startPendingSegments();
+        });
+        startPendingSegments();
+        return;
+    }
+    
+    const int segmentCount = m_segmentJobs.size();
+    abortSegments();
+    m_isTranscribing = false;
+    m_lastError = QString("%1 (segment %2 of %3)").arg(error).arg(index + 1).arg(segmentCount);
+    qWarning() << "Transcription failed:" << m_lastError;
+    emit transcriptionFailed(m_lastError);
+}
+
+void OpenAiTranscriptionService::abortSegments()
+{
+    ++m_segmentBatch;
+    // Take the list first: abort() delivers finished() synchronously
+    const QVector<SegmentJob> jobs = m_segmentJobs;
+    m_segmentJobs.clear();
+    m_segmentsInFlight = 0;
+    for (const SegmentJob& job : jobs) {
+        if (job.reply) {
+            job.reply->abort();
+            job.reply->deleteLater();
+        }
+    }
 }
 
 void OpenAiTranscriptionService::cancelTranscription()
 {
     if (m_isTranscribing) {
-        if (m_currentReply) {
-            m_currentReply->abort();
-            m_currentReply->deleteLater();
-            m_currentReply = nullptr;
+        m_streamingUpload->abort();
+        abortSegments();
+        m_hedgeTimer.stop();
+        m_deadlineTimer.stop();
+        ++m_requestGeneration;
+        m_requestAudio.reset();
+        for (QNetworkReply** reply : {&m_currentReply, &m_hedgeReply}) {
+            if (*reply) {
+                QNetworkReply* aborted = *reply;
+                *reply = nullptr;
+                aborted->abort();
+                aborted->deleteLater();
+            }
         }
+        traceRequestFinished();
+        m_replyTimings.clear();
         m_isTranscribing = false;
         emit transcriptionProgress("Transcription canceled");
     }
@@ -180,6 +606,11 @@ void OpenAiTranscriptionService::onUploadProgress(qint64 bytesSent, qint64 bytes
         
         // When upload is 100% complete, change message to indicate waiting for server processing
         if (percentage >= 100) {
+            traceBodySent();
+            if (m_hedgingEnabled && m_requestAudio && !m_hedgeArmed) {
+                m_hedgeArmed = true;
+                m_hedgeTimer.start(hedgeDelayMs());
+            }
             emit transcriptionProgress("Processing audio... Waiting for server response");
         } else {
             emit transcriptionProgress(QString("Uploading audio: %1%").arg(percentage));
@@ -187,47 +618,319 @@ void OpenAiTranscriptionService::onUploadProgress(qint64 bytesSent, qint64 bytes
     }
 }
 
+void OpenAiTranscriptionService::onStreamingProgress(qint64 audioBytesSent, bool recordingFinished)
+{
+    // While recording, the upload just keeps pace; only the tail is left after stop
+    if (recordingFinished) {
+        emit transcriptionProgress(QString("Uploading audio tail (%1 KB sent)").arg(audioBytesSent / 1024));
+    }
+}
+
+void OpenAiTranscriptionService::onStreamingFinished(int httpStatus, const QByteArray& body)
+{
+    QString networkError;
+    if (httpStatus < 200 || httpStatus >= 300) {
+        networkError = QString("Network error: server replied with HTTP %1").arg(httpStatus);
+    }
+    traceRequestFinished();
+    RequestTiming timing = m_streamingUpload->timing();
+    timing.audioMs = m_audioDurationMs;
+    recordRequestTiming(timing);
+    if (!networkError.isEmpty()
+        && scheduleRetry(httpStatus, QNetworkReply::NoError, m_streamingUpload->retryAfter(), networkError)) {
+        return;
+    }
+    handleResponse(httpStatus, networkError, body);
+}
+
+void OpenAiTranscriptionService::onStreamingFailed(const QString& error, QNetworkReply::NetworkError errorCode)
+{
+    traceRequestFinished();
+    RequestTiming timing = m_streamingUpload->timing();
+    timing.audioMs = m_audioDurationMs;
+    recordRequestTiming(timing);
+    if (scheduleRetry(0, errorCode, QByteArray(), error)) {
+        return;
+    }
+    handleResponse(0, error, QByteArray());
+}
+
+void OpenAiTranscriptionService::watchReply(QNetworkReply* reply, const QString& kind, qint64 payloadBytes, qint64 audioMs)
+{
+    RequestTiming& timing = m_replyTimings[reply];
+    timing.kind = kind;
+    timing.payloadBytes = payloadBytes;
+    timing.audioMs = audioMs;
+    timing.start();
+    
+    // Qt 5 only reports the end of the handshake; DNS and TCP are folded into it
+    auto mark = [this, reply](qint64 RequestTiming::*point) {
+        auto it = m_replyTimings.find(reply);
+        if (it != m_replyTimings.end()) {
+            it->mark((*it).*point);
+        }
+    };
+    connect(reply, &QNetworkReply::encrypted, this, [mark]() { mark(&RequestTiming::secureUs); });
+    connect(reply, &QNetworkReply::uploadProgress, this, [mark](qint64 bytesSent, qint64 bytesTotal) {
+        if (bytesSent > 0) {
+            mark(&RequestTiming::firstBodyByteUs);
+        }
+        if (bytesTotal > 0 && bytesSent >= bytesTotal) {
+            mark(&RequestTiming::bodySentUs);
+        }
+    });
+    connect(reply, &QNetworkReply::metaDataChanged, this, [mark]() { mark(&RequestTiming::firstByteUs); });
+    
+    // Stall watchdog: no bytes moving means a dead connection, except while
+    // the server works on the complete upload
+    QTimer* watchdog = new QTimer(reply);
+    watchdog->setSingleShot(true);
+    connect(watchdog, &QTimer::timeout, reply, [reply]() {
+        qWarning() << "Request stalled, aborting it";
+        reply->setProperty(STALLED_PROPERTY, true);
+        reply->abort();
+    });
+    connect(reply, &QNetworkReply::uploadProgress, watchdog, [watchdog](qint64 bytesSent, qint64 bytesTotal) {
+        const bool bodySent = bytesTotal > 0 && bytesSent >= bytesTotal;
+        watchdog->start(bodySent ? TRANSCRIPTION_RESPONSE_TIMEOUT_MS : TRANSCRIPTION_STALL_TIMEOUT_MS);
+    });
+    connect(reply, &QNetworkReply::downloadProgress, watchdog, [watchdog]() {
+        watchdog->start(TRANSCRIPTION_STALL_TIMEOUT_MS);
+    });
+    watchdog->start(TRANSCRIPTION_STALL_TIMEOUT_MS);
+}
+
+void OpenAiTranscriptionService::finishReplyTiming(QNetworkReply* reply)
+{
+    auto it = m_replyTimings.find(reply);
+    if (it == m_replyTimings.end()) {
+        return;
+    }
+    RequestTiming timing = *it;
+    m_replyTimings.erase(it);
+    if (reply->error() == QNetworkReply::OperationCanceledError) {
+        return;
+    }
+    
+    timing.mark(timing.finishedUs);
+    timing.httpStatus = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    timing.succeeded = reply->error() == QNetworkReply::NoError;
+    bool ok = false;
+    const qint64 processingMs = reply->rawHeader(SERVER_PROCESSING_HEADER).toLongLong(&ok);
+    if (ok) {
+        timing.serverProcessingMs = processingMs;
+    }
+    recordRequestTiming(timing);
+}
+
+void OpenAiTranscriptionService::recordRequestTiming(const RequestTiming& timing)
+{
+    qInfo().noquote() << "Request timing:" << timing.describe();
+    if (!timing.succeeded) {
+        return;
+    }
+    
+    m_requestStats->add(timing);
+    m_requestStats->save();
+    
+    const RequestStatistics::Percentiles firstByte = m_requestStats->percentiles("ttfb_ms");
+    const RequestStatistics::Percentiles total = m_requestStats->percentiles("total_ms");
+    qInfo().noquote() << QString("Last %1 requests: first byte p50/p95/p99 %2/%3/%4 ms, total %5/%6/%7 ms "
+                                 "(--request-stats for all phases)")
+                             .arg(total.count)
+                             .arg(firstByte.p50, 0, 'f', 0).arg(firstByte.p95, 0, 'f', 0).arg(firstByte.p99, 0, 'f', 0)
+                             .arg(total.p50, 0, 'f', 0).arg(total.p95, 0, 'f', 0).arg(total.p99, 0, 'f', 0);
+}
+
+int OpenAiTranscriptionService::hedgeDelayMs() const
+{
+    const RequestStatistics::Percentiles firstByte = m_requestStats->percentiles("ttfb_ms");
+    if (firstByte.count < HEDGE_MIN_SAMPLES) {
+        return HEDGE_DEFAULT_DELAY_MS;
+    }
+    return qBound(HEDGE_MIN_DELAY_MS, static_cast<int>(firstByte.p95), HEDGE_MAX_DELAY_MS);
+}
+
+void OpenAiTranscriptionService::sendHedge()
+{
+    if (!m_currentReply || m_hedgeReply || !m_requestAudio) {
+        return;
+    }
+    
+    ArenaDevice* audioDevice = new ArenaDevice(m_requestAudio);
+    audioDevice->open(QIODevice::ReadOnly);
+    
+    qInfo() << "No response" << m_hedgeTimer.interval() << "ms after the upload, sending the recording again";
+    Tracer::instance().instant("hedge", "network", QString("after %1 ms").arg(m_hedgeTimer.interval()));
+    m_hedgeReply = sendAudio(audioDevice, m_requestFilename, m_requestLanguage);
+    watchReply(m_hedgeReply, "hedge", m_requestAudio->size(), m_audioDurationMs);
+    countHedgeEvent("hedge_sent");
+    emit transcriptionProgress("Server is slow, sending a second request...");
+}
+
+void OpenAiTranscriptionService::countHedgeEvent(const QString& counter)
+{
+    m_requestStats->increment(counter);
+    m_requestStats->save();
+}
+
+void OpenAiTranscriptionService::traceRequestStarted(const QString& detail)
+{
+    traceRequestFinished();
+    ++m_traceRequestId;
+    m_traceUploading = true;
+    Tracer::instance().asyncBegin("upload", "network", m_traceRequestId, detail);
+}
+
+void OpenAiTranscriptionService::traceBodySent()
+{
+    if (!m_traceUploading) {
+        return;
+    }
+    m_traceUploading = false;
+    m_traceWaiting = true;
+    Tracer::instance().asyncEnd("upload", "network", m_traceRequestId);
+    Tracer::instance().asyncBegin("server response", "network", m_traceRequestId);
+}
+
+void OpenAiTranscriptionService::traceRequestFinished()
+{
+    if (m_traceUploading) {
+        Tracer::instance().asyncEnd("upload", "network", m_traceRequestId);
+    }
+    if (m_traceWaiting) {
+        Tracer::instance().asyncEnd("server response", "network", m_traceRequestId);
+    }
+    m_traceUploading = false;
+    m_traceWaiting = false;
+}
+
+QUrl OpenAiTranscriptionService::transcriptionUrl(const QString& baseUrl)
+{
+    QString url = baseUrl.trimmed();
+    while (url.endsWith('/')) {
+        url.chop(1);
+    }
+    return QUrl(url + TRANSCRIPTION_API_PATH);
+}
+
+QUrl OpenAiTranscriptionService::apiUrl() const
+{
+    if (!m_apiBaseUrl.isEmpty()) {
+        return transcriptionUrl(m_apiBaseUrl);
+    }
+    const QProcessEnvironment env = QProcessEnvironment::systemEnvironment();
+    const QString endpointUrl = env.value("OPENAI_TRANSCRIPTION_URL");
+    if (!endpointUrl.isEmpty()) {
+        return QUrl(endpointUrl);
+    }
+    const QString baseUrl = env.value("OPENAI_BASE_URL");
+    return transcriptionUrl(baseUrl.isEmpty() ? QString(TRANSCRIPTION_API_BASE_URL) : baseUrl);
+}
+
 void OpenAiTranscriptionService::handleNetworkReply(QNetworkReply* reply)
 {
-    if (reply != m_currentReply) {
+    finishReplyTiming(reply);
+    if (isConnectionError(reply->error())) {
+        m_resetConnections = true;
+    }
+    
+    for (int i = 0; i < m_segmentJobs.size(); ++i) {
+        if (m_segmentJobs.at(i).reply == reply) {
+            handleSegmentReply(i, reply);
+            return;
+        }
+    }
+    
+    if (reply != m_currentReply && reply != m_hedgeReply) {
         // Not our current reply, ignore it
         return;
     }
     
+    // With a hedge in flight the first success wins and a failure leaves it
+    // to the other request
+    const bool isHedge = reply == m_hedgeReply;
+    QNetworkReply* other = isHedge ? m_currentReply : m_hedgeReply;
+    if (other && reply->error() != QNetworkReply::NoError) {
+        qWarning() << (isHedge ? "Hedged" : "Original") << "request failed:" << replyError(reply)
+                   << "- waiting for the other one";
+        (isHedge ? m_hedgeReply : m_currentReply) = nullptr;
+        reply->deleteLater();
+        return;
+    }
+    m_hedgeTimer.stop();
+    m_currentReply = nullptr;
+    m_hedgeReply = nullptr;
+    if (other) {
+        other->abort();
+        other->deleteLater();
+    }
+    if (isHedge && reply->error() == QNetworkReply::NoError) {
+        qInfo() << "Hedged request won";
+        countHedgeEvent("hedge_won");
+    }
+    
+    const QString networkError = replyError(reply);
+    const QNetworkReply::NetworkError errorCode = replyErrorCode(reply);
+    
+    // Read response data even for errors
+    const int httpStatus = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    const QByteArray responseData = reply->readAll();
+    const QByteArray retryAfter = reply->rawHeader("Retry-After");
+    
+    reply->deleteLater();
+    
+    traceRequestFinished();
+    if (!networkError.isEmpty() && scheduleRetry(httpStatus, errorCode, retryAfter, networkError)) {
+        return;
+    }
+    handleResponse(httpStatus, networkError, responseData);
+}
+
+void OpenAiTranscriptionService::handleResponse(int httpStatus, const QString& networkError, const QByteArray& responseData)
+{
     // Update status to indicate response received
     emit transcriptionProgress("Response received, parsing results...");
     
     m_isTranscribing = false;
+    m_deadlineTimer.stop();
+    m_requestAudio.reset();
     
     // Check for network errors
-    if (reply->error() != QNetworkReply::NoError) {
-        m_lastError = QString("Network error: %1").arg(reply->errorString());
-        int httpStatus = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
-        
-        // Read response data even for errors
-        QByteArray responseData = reply->readAll();
+    if (!networkError.isEmpty()) {
+        m_lastError = networkError;
         
         qWarning() << "Transcription failed:" << m_lastError << "HTTP status:" << httpStatus;
         qWarning() << "Response body:" << responseData;
         
         emit transcriptionFailed(m_lastError);
-        reply->deleteLater();
-        m_currentReply = nullptr;
         return;
     }
     
-    // Read response data
-    QByteArray responseData = reply->readAll();
+    QString transcribedText;
+    bool parsed = false;
+    {
+        TraceSpan span("parse response", "transcription");
+        span.setDetail(QString("%1 bytes").arg(responseData.size()));
+        parsed = parseTranscriptionResponse(responseData, &transcribedText, &m_lastError);
+    }
+    if (!parsed) {
+        qWarning() << "Transcription failed:" << m_lastError;
+        qWarning() << "Response received:" << responseData;
+        emit transcriptionFailed(m_lastError);
+        return;
+    }
     
+    completeTranscription(transcribedText);
+}
+
+bool OpenAiTranscriptionService::parseTranscriptionResponse(const QByteArray& responseData, QString* text, QString* error)
+{
     // Parse JSON response
     QJsonDocument jsonDoc = QJsonDocument::fromJson(responseData);
     if (jsonDoc.isNull() || !jsonDoc.isObject()) {
-        m_lastError = "Invalid response from transcription service";
-        qWarning() << "Transcription failed:" << m_lastError;
-        emit transcriptionFailed(m_lastError);
-        reply->deleteLater();
-        m_currentReply = nullptr;
-        return;
+        *error = "Invalid response from transcription service";
+        return false;
     }
     
     QJsonObject jsonObj = jsonDoc.object();
@@ -235,38 +938,22 @@ void OpenAiTranscriptionService::handleNetworkReply(QNetworkReply* reply)
     // Check for API error response
     if (jsonObj.contains("error")) {
         QJsonObject errorObj = jsonObj["error"].toObject();
-        m_lastError = QString("API error: %1").arg(errorObj["message"].toString());
-        qWarning() << "Transcription failed:" << m_lastError;
-        emit transcriptionFailed(m_lastError);
-        reply->deleteLater();
-        m_currentReply = nullptr;
-        return;
+        *error = QString("API error: %1").arg(errorObj["message"].toString());
+        return false;
     }
     
     // Extract transcription text
-    if (jsonObj.contains("text")) {
-        QString transcribedText = jsonObj["text"].toString();
-        qInfo() << "Transcription completed successfully";
-        
-        // Save transcription to file
-        QFile outputFile(TRANSCRIPTION_OUTPUT_PATH);
-        if (outputFile.open(QIODevice::WriteOnly | QIODevice::Text)) {
-            QTextStream out(&outputFile);
-            out << transcribedText;
-            outputFile.close();
-            qInfo() << "Transcription saved to" << TRANSCRIPTION_OUTPUT_PATH;
-        } else {
-            qWarning() << "Failed to save transcription to file";
-        }
-        
-        emit transcriptionCompleted(transcribedText);
-    } else {
-        m_lastError = "No transcription text found in response";
-        qWarning() << "Transcription failed:" << m_lastError;
-        qWarning() << "Response received:" << responseData;
-        emit transcriptionFailed(m_lastError);
+    if (!jsonObj.contains("text")) {
+        *error = "No transcription text found in response";
+        return false;
     }
     
-    reply->deleteLater();
-    m_currentReply = nullptr;
-}
\ No newline at end of file
+    *text = jsonObj["text"].toString();
+    return true;
+}
+
+void OpenAiTranscriptionService::completeTranscription(const QString& transcribedText)
+{
+    qInfo() << "Transcription completed successfully";
+    emit transcriptionCompleted(transcribedText);
+}
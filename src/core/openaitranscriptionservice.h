@@ -7,22 +7,60 @@
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QFile>
+#include <QHash>
+#include <QList>
+#include <QSharedPointer>
+#include <QTimer>
+#include <QVector>
 
-class OpenAiTranscriptionService : public QObject
+#include "audioencoder.h"
+#include "chunkedarena.h"
+#include "requeststats.h"
+#include "retrypolicy.h"
+#include "streamingupload.h"
+#include "transcriptionbackend.h"
+
+class OpenAiTranscriptionService : public TranscriptionBackend
 {
     Q_OBJECT
+    friend class VoiceInputBenchmarks;  // Feeds handleNetworkReply() canned replies
 public:
     explicit OpenAiTranscriptionService(QObject* parent = nullptr);
     ~OpenAiTranscriptionService() override;
 
+    QString name() const override { return "openai"; }
+    bool isAvailable() const override { return hasApiKey(); }
+    QString unavailableReason() const override { return "NO API KEY - Set OPENAI_API_KEY environment variable"; }
+
     // Start transcription of the given audio file
     void transcribeAudio(const QString& audioFilePath, const QString& language);
     
+    // Start transcription of an in-memory recording without touching the disk
+    void transcribeRecording(QSharedPointer<const ChunkedArena> audio, AudioFormat format,
+                             const QString& language) override;
+    
+    // Start uploading a recording that is still in progress; the request
+    // completes on its own once `audio` is finished
+    bool supportsStreaming() const override { return true; }
+    void streamRecording(QSharedPointer<const ChunkedArena> audio, AudioFormat format, const QString& language) override;
+    
+    // Transcribe consecutive segments of one recording concurrently (bounded by
+    // TRANSCRIPTION_MAX_PARALLEL_SEGMENTS), retrying failed segments on their
+    // own, and deliver the texts joined in recording order
+    void transcribeSegments(const QList<QSharedPointer<const ChunkedArena>>& segments,
+                            AudioFormat format,
+                            const QString& language) override;
+    
+    // Open the connection to the API ahead of the next request, so DNS, TCP
+    // and TLS setup overlap with speech instead of following Enter
+    void preconnect();
+    void prepare() override { preconnect(); }
+    
     // Cancel ongoing transcription
-    void cancelTranscription();
+    void cancelTranscription() override;
     
     // Check if transcription is in progress
-    bool isTranscribing() const;
+    bool isTranscribing() const override;
     
     // Get last error message
     QString lastError() const;
@@ -32,27 +70,140 @@ public:
     
     // Refresh API key from environment (used when retrying)
     void refreshApiKey();
-
-signals:
-    // Emitted when transcription completes successfully
-    void transcriptionCompleted(const QString& transcribedText);
+    void refreshCredentials() override { refreshApiKey(); }
     
-    // Emitted when transcription fails
-    void transcriptionFailed(const QString& errorMessage);
+    // Length of the recording being transcribed, for the request statistics
+    // and the retry deadline (-1 = unknown). A streamed request picks it up
+    // when the recording ends.
+    void setAudioDuration(qint64 durationMs) override;
     
-    // Progress information
-    void transcriptionProgress(const QString& status);
+    // API base URL such as "http://127.0.0.1:8089/v1"; takes precedence over
+    // the environment. An empty string restores the default.
+    void setApiBaseUrl(const QString& baseUrl) { m_apiBaseUrl = baseUrl; }
+    
+    // Transcription endpoint below `baseUrl`
+    static QUrl transcriptionUrl(const QString& baseUrl);
+    
+    // Send a second copy of an upload whose response is unusually late (see
+    // HEDGE_*) and take whichever succeeds first. Only in-memory recordings
+    // are hedged.
+    void setHedging(bool enabled) { m_hedgingEnabled = enabled; }
+    
+    // Timings of past requests, kept across runs and shared by all instances
+    const RequestStatistics& requestStatistics() const { return *m_requestStats; }
+    
+    // Extract the text from an API response body; false with `error` set otherwise
+    static bool parseTranscriptionResponse(const QByteArray& responseData, QString* text, QString* error);
 
 private slots:
     void handleNetworkReply(QNetworkReply* reply);
     void onUploadProgress(qint64 bytesSent, qint64 bytesTotal);
+    void onStreamingProgress(qint64 audioBytesSent, bool recordingFinished);
+    void onStreamingFinished(int httpStatus, const QByteArray& body);
+    void onStreamingFailed(const QString& error, QNetworkReply::NetworkError errorCode);
+    void sendHedge();
+    void onDeadlineExpired();
+
+private:
+    // Shared checks before a new request; emits transcriptionFailed on error.
+    // Starts the retry deadline for `audioMs` of audio (-1 = not yet known).
+    bool prepareRequest(qint64 audioMs);
+    void startStream();
+    
+    // Retries of the single-request paths. scheduleRetry() returns false
+    // when the failure is final and should be reported.
+    bool scheduleRetry(int httpStatus, QNetworkReply::NetworkError errorCode, const QByteArray& retryAfter,
+                       const QString& error);
+    void resendRequest();
+    void armDeadline();
+    
+    // Send `audioDevice` (opened, ownership taken) as the multipart file part
+    void postAudio(QIODevice* audioDevice, const QString& filename, const QString& language);
+    QNetworkReply* sendAudio(QIODevice* audioDevice, const QString& filename, const QString& language);
+    // Drops the connection pool; only done after a connection broke
+    void recreateNetworkManager();
+    
+    // Segmented transcription
+    void startPendingSegments();
+    void handleSegmentReply(int index, QNetworkReply* reply);
+    void abortSegments();
+    
+    // Shared by both upload paths; `networkError` is empty on transport success
+    void handleResponse(int httpStatus, const QString& networkError, const QByteArray& responseData);
+    void completeTranscription(const QString& transcribedText);
+    
+    QUrl apiUrl() const;
+    
+    // Per-request phase timings for QNetworkAccessManager requests
+    void watchReply(QNetworkReply* reply, const QString& kind, qint64 payloadBytes, qint64 audioMs);
+    void finishReplyTiming(QNetworkReply* reply);
+    void recordRequestTiming(const RequestTiming& timing);
+    // One copy for every instance, so parallel jobs neither lose each
+    // other's samples on save nor hedge on a partial history
+    static QSharedPointer<RequestStatistics> sharedRequestStatistics();
+    
+    // Wait after the body is sent before hedging, from recent times to first byte
+    int hedgeDelayMs() const;
+    void countHedgeEvent(const QString& counter);
+    
+    // Trace spans of the current request: "upload" until the body is out,
+    // then "server response"
+    void traceRequestStarted(const QString& detail);
+    void traceBodySent();
+    void traceRequestFinished();
 
 private:
     QNetworkAccessManager* m_networkManager;
     QNetworkReply* m_currentReply;
+    StreamingUpload* m_streamingUpload;
     QString m_lastError;
     bool m_isTranscribing;
     QString m_apiKey;
+    
+    struct SegmentJob
+    {
+        QSharedPointer<const ChunkedArena> audio;
+        QNetworkReply* reply = nullptr;
+        int            attempts = 0;
+        bool           retryPending = false;
+        bool           done = false;
+        QString        text;
+    };
+    QVector<SegmentJob> m_segmentJobs;
+    AudioFormat         m_segmentFormat = AudioFormat::Mp3;
+    QString             m_segmentLanguage;
+    int                 m_segmentsInFlight = 0;
+    int                 m_segmentsDone = 0;
+    int                 m_segmentBatch = 0;   // Invalidates retry timers of an aborted batch
+    qint64              m_segmentBytes = 0;   // All segments together, to split the audio duration
+    
+    QHash<QNetworkReply*, RequestTiming> m_replyTimings;
+    QSharedPointer<RequestStatistics> m_requestStats;
+    qint64              m_audioDurationMs = -1;
+    QString             m_apiBaseUrl;
+    bool                m_resetConnections = false;
+    
+    // Payload of the current request, sent again by a retry or a hedge
+    QSharedPointer<const ChunkedArena> m_requestAudio;
+    QString             m_requestFilePath;    // transcribeAudio() only
+    QString             m_requestFilename;
+    QString             m_requestLanguage;
+    bool                m_requestStreamed = false;
+    
+    RetryPolicy         m_retryPolicy;
+    QTimer              m_deadlineTimer;
+    int                 m_failedAttempts = 0;
+    quint64             m_requestGeneration = 0;  // Invalidates retry timers of an earlier request
+    
+    // Hedging of the single-upload path
+    bool                m_hedgingEnabled = false;
+    QNetworkReply*      m_hedgeReply = nullptr;
+    QTimer              m_hedgeTimer;
+    bool                m_hedgeArmed = false;
+    
+    quint64             m_traceRequestId = 0;
+    bool                m_traceUploading = false;
+    bool                m_traceWaiting = false;
 };
 
 #endif // OPENAITRANSCRIPTIONSERVICE_H
\ No newline at end of file
@@ -0,0 +1,171 @@
+#include "polyphaseresampler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "config/config.h"
+
+namespace {
+
+// Zeroth-order modified Bessel function, for the Kaiser window
+double besselI0(double x)
+{
+    double sum = 1.0;
+    double term = 1.0;
+    const double halfX = x / 2.0;
+    for (int k = 1; k < 50; ++k) {
+        term *= (halfX / k) * (halfX / k);
+        sum += term;
+        if (term < sum * 1e-12) {
+            break;
+        }
+    }
+    return sum;
+}
+
+inline float dotProduct(const float* a, const float* b, int count)
+{
+#if defined(__SSE2__)
+    // count is always a multiple of 4 (see constructor)
+    __m128 acc0 = _mm_setzero_ps();
+    __m128 acc1 = _mm_setzero_ps();
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+        acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4)));
+    }
+    for (; i < count; i += 4) {
+        acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+    }
+    acc0 = _mm_add_ps(acc0, acc1);
+    alignas(16) float lanes[4];
+    _mm_store_ps(lanes, acc0);
+    return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#else
+    float sum = 0.0f;
+    for (int i = 0; i < count; ++i) {
+        sum += a[i] * b[i];
+    }
+    return sum;
+#endif
+}
+
+inline short toSample(float value)
+{
+    const float rounded = std::nearbyint(value);
+    return static_cast<short>(std::max(-32768.0f, std::min(32767.0f, rounded)));
+}
+
+} // namespace
+
+PolyphaseResampler::PolyphaseResampler(int inputRate, int outputRate, int tapsPerPhase)
+    : m_inputRate(inputRate),
+      m_outputRate(outputRate),
+      m_interpolation(1),
+      m_decimation(1),
+      m_tapsPerPhase((std::max(tapsPerPhase, 4) + 3) & ~3),
+      m_position(0),
+      m_phase(0)
+{
+    const int divisor = std::gcd(inputRate, outputRate);
+    m_interpolation = outputRate / divisor;
+    m_decimation = inputRate / divisor;
+
+    if (!isPassthrough()) {
+        designFilter();
+    }
+    reset();
+}
+
+void PolyphaseResampler::designFilter()
+{
+    const int length = m_tapsPerPhase * m_interpolation;
+    const double upsampledRate = static_cast<double>(m_inputRate) * m_interpolation;
+
+    // Low-pass just below the lower of the two Nyquist frequencies
+    const double cutoff = RESAMPLER_CUTOFF * std::min(m_inputRate, m_outputRate) / 2.0;
+    const double normalizedCutoff = cutoff / upsampledRate;
+    const double center = (length - 1) / 2.0;
+    const double windowNorm = besselI0(RESAMPLER_KAISER_BETA);
+
+    std::vector<double> prototype(static_cast<std::size_t>(length));
+    for (int n = 0; n < length; ++n) {
+        const double x = n - center;
+        const double sinc = x == 0.0
+            ? 2.0 * normalizedCutoff
+            : std::sin(2.0 * M_PI * normalizedCutoff * x) / (M_PI * x);
+        const double ratio = 2.0 * n / (length - 1) - 1.0;
+        const double window = besselI0(RESAMPLER_KAISER_BETA * std::sqrt(std::max(0.0, 1.0 - ratio * ratio))) / windowNorm;
+        // Gain of L compensates for the zero-stuffing of the interpolator
+        prototype[static_cast<std::size_t>(n)] = sinc * window * m_interpolation;
+    }
+
+    // Split into branches: branch p uses prototype[k * L + p] against x[i - k]
+    m_coefficients.assign(static_cast<std::size_t>(length), 0.0f);
+    for (int phase = 0; phase < m_interpolation; ++phase) {
+        for (int k = 0; k < m_tapsPerPhase; ++k) {
+            const std::size_t target = static_cast<std::size_t>(phase) * m_tapsPerPhase + (m_tapsPerPhase - 1 - k);
+            m_coefficients[target] = static_cast<float>(prototype[static_cast<std::size_t>(k) * m_interpolation + phase]);
+        }
+    }
+}
+
+void PolyphaseResampler::reset()
+{
+    // Prime with silence so the first output already has a full filter history
+    m_history.assign(static_cast<std::size_t>(m_tapsPerPhase - 1), 0.0f);
+    m_position = 0;
+    m_phase = 0;
+}
+
+std::size_t PolyphaseResampler::maxOutputFrames(std::size_t inputFrames) const
+{
+    return (inputFrames + static_cast<std::size_t>(m_tapsPerPhase)) * m_interpolation / m_decimation + 1;
+}
+
+std::size_t PolyphaseResampler::process(const short* input, std::size_t frames, std::vector<short>& output)
+{
+    if (isPassthrough()) {
+        output.insert(output.end(), input, input + frames);
+        return frames;
+    }
+
+    const std::size_t previousSize = m_history.size();
+    m_history.resize(previousSize + frames);
+    for (std::size_t i = 0; i < frames; ++i) {
+        m_history[previousSize + i] = input[i];
+    }
+
+    const std::size_t taps = static_cast<std::size_t>(m_tapsPerPhase);
+    const std::size_t before = output.size();
+    while (m_position + taps <= m_history.size()) {
+        const float* branch = m_coefficients.data() + static_cast<std::size_t>(m_phase) * taps;
+        output.push_back(toSample(dotProduct(branch, m_history.data() + m_position, m_tapsPerPhase)));
+
+        m_phase += m_decimation;
+        m_position += static_cast<std::size_t>(m_phase / m_interpolation);
+        m_phase %= m_interpolation;
+    }
+
+    // Keep only the samples later outputs still need
+    const std::size_t consumed = std::min(m_position, m_history.size());
+    m_history.erase(m_history.begin(), m_history.begin() + static_cast<std::ptrdiff_t>(consumed));
+    m_position -= consumed;
+
+    return output.size() - before;
+}
+
+std::size_t PolyphaseResampler::flush(std::vector<short>& output)
+{
+    if (isPassthrough()) {
+        return 0;
+    }
+
+    const std::vector<short> silence(static_cast<std::size_t>(m_tapsPerPhase / 2), 0);
+    return process(silence.data(), silence.size(), output);
+}
@@ -0,0 +1,54 @@
+#ifndef POLYPHASERESAMPLER_H
+#define POLYPHASERESAMPLER_H
+
+#include <cstddef>
+#include <vector>
+
+// Streaming rational-ratio resampler for mono int16 PCM.
+//
+// The rate ratio is reduced to L/M and a windowed-sinc low-pass prototype is
+// split into L polyphase branches, so every output sample costs a single
+// `tapsPerPhase`-long dot product (vectorized with SSE where available).
+// State is carried between process() calls, so blocks of any size can be fed.
+class PolyphaseResampler
+{
+public:
+    PolyphaseResampler(int inputRate, int outputRate, int tapsPerPhase);
+
+    int inputRate() const { return m_inputRate; }
+    int outputRate() const { return m_outputRate; }
+    bool isPassthrough() const { return m_interpolation == m_decimation; }
+
+    // Resample `frames` input samples and append the result to `output`.
+    // Returns the number of samples appended.
+    std::size_t process(const short* input, std::size_t frames, std::vector<short>& output);
+
+    // Push out the samples still held back by the filter delay
+    std::size_t flush(std::vector<short>& output);
+
+    // Forget all history, e.g. before a new recording
+    void reset();
+
+    // Upper bound of output samples produced for `inputFrames` input samples
+    std::size_t maxOutputFrames(std::size_t inputFrames) const;
+
+private:
+    void designFilter();
+
+private:
+    int m_inputRate;
+    int m_outputRate;
+    int m_interpolation;   // L
+    int m_decimation;      // M
+    int m_tapsPerPhase;
+
+    // m_coefficients[phase * m_tapsPerPhase + k], stored time-reversed so each
+    // branch is a straight dot product with the input history
+    std::vector<float> m_coefficients;
+
+    std::vector<float> m_history;   // Input samples not fully consumed yet
+    std::size_t        m_position;  // Index in m_history of the next output's first tap
+    int                m_phase;     // Polyphase branch of the next output
+};
+
+#endif // POLYPHASERESAMPLER_H
@@ -0,0 +1,397 @@
+#include "realtimetranscriptionservice.h"
+
+#include <QDebug>
+#include <QJsonDocument>
+#include <QNetworkRequest>
+#include <QProcessEnvironment>
+#include <QUrlQuery>
+#include <QtEndian>
+
+#include "config/config.h"
+#include "tracer.h"
+#include "wavencoder.h"
+
+namespace {
+
+// Returned when a commit finds nothing left to commit, e.g. because the
+// server's turn detection committed the last words a moment earlier
+constexpr auto COMMIT_EMPTY_CODE = "input_audio_buffer_commit_empty";
+
+} // namespace
+
+RealtimeTranscriptionService::RealtimeTranscriptionService(QObject* parent)
+    : TranscriptionBackend(parent),
+      m_isTranscribing(false),
+      m_connected(false),
+      m_sourceIndex(0),
+      m_sourceOffset(0),
+      m_audioDone(false),
+      m_commitPending(false),
+      m_uncommittedSamples(0)
+{
+    refreshCredentials();
+
+    m_sendTimer.setInterval(REALTIME_SEND_INTERVAL_MS);
+    connect(&m_sendTimer, &QTimer::timeout, this, &RealtimeTranscriptionService::pump);
+
+    // Waits for the handshake, then for the server once all audio is sent
+    m_responseTimer.setSingleShot(true);
+    m_responseTimer.setInterval(TRANSCRIPTION_STALL_TIMEOUT_MS);
+    connect(&m_responseTimer, &QTimer::timeout, this, &RealtimeTranscriptionService::onResponseTimeout);
+}
+
+RealtimeTranscriptionService::~RealtimeTranscriptionService()
+{
+    closeSession();
+}
+
+void RealtimeTranscriptionService::streamRecording(QSharedPointer<const ChunkedArena> audio, AudioFormat format,
+                                                   const QString& language)
+{
+    startSession({audio}, format, language);
+}
+
+void RealtimeTranscriptionService::transcribeRecording(QSharedPointer<const ChunkedArena> audio, AudioFormat format,
+                                                       const QString& language)
+{
+    startSession({audio}, format, language);
+}
+
+void RealtimeTranscriptionService::transcribeSegments(const QList<QSharedPointer<const ChunkedArena>>& segments,
+                                                      AudioFormat format,
+                                                      const QString& language)
+{
+    startSession(segments, format, language);
+}
+
+void RealtimeTranscriptionService::startSession(const QList<QSharedPointer<const ChunkedArena>>& sources,
+                                                AudioFormat format,
+                                                const QString& language)
+{
+    cancelTranscription();
+
+    if (m_apiKey.isEmpty()) {
+        emit transcriptionFailed("API key not found. Set the OPENAI_API_KEY environment variable.");
+        return;
+    }
+    if (format != AudioFormat::Wav) {
+        emit transcriptionFailed(QString("Realtime transcription needs WAV recordings, not %1").arg(audioFormatName(format)));
+        return;
+    }
+    if (sources.isEmpty() || !sources.first()) {
+        emit transcriptionFailed("Recording is empty");
+        return;
+    }
+
+    m_isTranscribing = true;
+    m_language = language;
+    m_sources = sources;
+    m_sourceIndex = 0;
+    m_sourceOffset = WavEncoder::HeaderSize;
+    m_resampler.reset(new PolyphaseResampler(SPEECH_SAMPLE_RATE, REALTIME_SAMPLE_RATE, RESAMPLER_TAPS_PER_PHASE));
+    m_pcm.clear();
+    m_audioDone = false;
+    m_commitPending = false;
+    m_uncommittedSamples = 0;
+    m_items.clear();
+
+    QString baseUrl = m_apiBaseUrl;
+    if (baseUrl.isEmpty()) {
+        baseUrl = QProcessEnvironment::systemEnvironment().value("OPENAI_BASE_URL", TRANSCRIPTION_API_BASE_URL);
+    }
+    QNetworkRequest request(realtimeUrl(baseUrl));
+    request.setRawHeader("Authorization", QString("Bearer %1").arg(m_apiKey).toUtf8());
+    request.setRawHeader("OpenAI-Beta", "realtime=v1");
+
+    m_socket = new QWebSocket(QString(), QWebSocketProtocol::VersionLatest, this);
+    connect(m_socket, &QWebSocket::connected, this, &RealtimeTranscriptionService::onConnected);
+    connect(m_socket, &QWebSocket::disconnected, this, &RealtimeTranscriptionService::onDisconnected);
+    connect(m_socket, &QWebSocket::textMessageReceived, this, &RealtimeTranscriptionService::onTextMessage);
+    connect(m_socket, QOverload<QAbstractSocket::SocketError>::of(&QWebSocket::error), this, [this]() {
+        fail(QString("Network error: %1").arg(m_socket ? m_socket->errorString() : QString()));
+    });
+
+    qDebug() << "Opening realtime session at" << request.url().toString();
+    Tracer::instance().instant("realtime connect", "network", request.url().host());
+    m_socket->open(request);
+    m_responseTimer.start();
+    m_sendTimer.start();
+}
+
+QUrl RealtimeTranscriptionService::realtimeUrl(const QString& baseUrl)
+{
+    QString url = baseUrl.trimmed();
+    while (url.endsWith('/')) {
+        url.chop(1);
+    }
+    QUrl endpoint(url + REALTIME_API_PATH);
+    if (endpoint.scheme() == "https") {
+        endpoint.setScheme("wss");
+    } else if (endpoint.scheme() == "http") {
+        endpoint.setScheme("ws");
+    }
+    QUrlQuery query;
+    query.addQueryItem("intent", "transcription");
+    endpoint.setQuery(query);
+    return endpoint;
+}
+
+void RealtimeTranscriptionService::refreshCredentials()
+{
+    m_apiKey = QProcessEnvironment::systemEnvironment().value("OPENAI_API_KEY");
+}
+
+void RealtimeTranscriptionService::cancelTranscription()
+{
+    if (m_isTranscribing) {
+        closeSession();
+        m_isTranscribing = false;
+        qInfo() << "Realtime transcription canceled";
+    }
+}
+
+void RealtimeTranscriptionService::onConnected()
+{
+    m_connected = true;
+    m_responseTimer.stop();
+    Tracer::instance().instant("realtime connected", "network");
+
+    // The server cuts turns at pauses, so each one is transcribed while the
+    // user goes on speaking
+    QJsonObject transcription{{"model", REALTIME_TRANSCRIPTION_MODEL}};
+    if (!m_language.isEmpty()) {
+        transcription["language"] = m_language;
+    }
+    const QJsonObject turnDetection{{"type", "server_vad"},
+                                    {"threshold", 0.5},
+                                    {"prefix_padding_ms", 300},
+                                    {"silence_duration_ms", REALTIME_VAD_SILENCE_MS}};
+    sendEvent({{"type", "transcription_session.update"},
+               {"session", QJsonObject{{"input_audio_format", "pcm16"},
+                                       {"input_audio_transcription", transcription},
+                                       {"turn_detection", turnDetection}}}});
+    pump();
+}
+
+void RealtimeTranscriptionService::onDisconnected()
+{
+    if (!m_isTranscribing || !m_socket) {
+        return;
+    }
+    const QString reason = m_socket->closeReason();
+    fail(QString("Network error: realtime session closed (%1%2)")
+             .arg(static_cast<int>(m_socket->closeCode()))
+             .arg(reason.isEmpty() ? QString() : ": " + reason));
+}
+
+void RealtimeTranscriptionService::pump()
+{
+    if (!m_connected || m_audioDone) {
+        return;
+    }
+
+    const std::size_t maxFrames = static_cast<std::size_t>(REALTIME_MAX_APPEND_MS) * SPEECH_SAMPLE_RATE / 1000;
+    while (m_sourceIndex < m_sources.size()) {
+        const ChunkedArena& arena = *m_sources.at(m_sourceIndex);
+        // Once finished, what readSamples() sees next is all there is
+        const bool finished = arena.isFinished();
+
+        // In appends of at most REALTIME_MAX_APPEND_MS
+        while (true) {
+            m_sourceOffset = WavEncoder::readSamples(arena, m_sourceOffset, maxFrames - m_pcm.size(), m_pcm);
+            if (m_pcm.size() < maxFrames) {
+                break;
+            }
+            sendPendingAudio();
+        }
+
+        if (!finished) {
+            break;
+        }
+        ++m_sourceIndex;
+        m_sourceOffset = WavEncoder::HeaderSize;
+    }
+
+    sendPendingAudio();
+    if (m_sourceIndex >= m_sources.size()) {
+        finishAudio();
+    }
+}
+
+void RealtimeTranscriptionService::sendPendingAudio()
+{
+    if (!m_pcm.empty()) {
+        m_resampler->process(m_pcm.data(), m_pcm.size(), m_resampled);
+        m_pcm.clear();
+    }
+    if (m_resampled.empty()) {
+        return;
+    }
+
+    QByteArray bytes(static_cast<int>(m_resampled.size() * 2), Qt::Uninitialized);
+    for (std::size_t i = 0; i < m_resampled.size(); ++i) {
+        qToLittleEndian<qint16>(m_resampled[i], bytes.data() + 2 * i);
+    }
+    m_uncommittedSamples += static_cast<qint64>(m_resampled.size());
+    m_resampled.clear();
+    sendEvent({{"type", "input_audio_buffer.append"}, {"audio", QString::fromLatin1(bytes.toBase64())}});
+}
+
+void RealtimeTranscriptionService::finishAudio()
+{
+    m_resampler->flush(m_resampled);
+    sendPendingAudio();
+    m_audioDone = true;
+    m_sendTimer.stop();
+    m_sinceAudioDone.start();
+
+    // The words after the last pause are still in the buffer
+    if (m_uncommittedSamples >= static_cast<qint64>(REALTIME_MIN_COMMIT_MS) * REALTIME_SAMPLE_RATE / 1000) {
+        sendEvent({{"type", "input_audio_buffer.commit"}});
+        m_commitPending = true;
+    }
+    Tracer::instance().instant("realtime audio sent", "network");
+    m_responseTimer.start();
+    finishIfDone();
+}
+
+void RealtimeTranscriptionService::sendEvent(const QJsonObject& event)
+{
+    if (m_socket) {
+        m_socket->sendTextMessage(QString::fromUtf8(QJsonDocument(event).toJson(QJsonDocument::Compact)));
+    }
+}
+
+void RealtimeTranscriptionService::onTextMessage(const QString& message)
+{
+    if (!m_isTranscribing) {
+        return;
+    }
+    if (m_audioDone) {
+        m_responseTimer.start();
+    }
+
+    const QJsonObject event = QJsonDocument::fromJson(message.toUtf8()).object();
+    const QString type = event.value("type").toString();
+    const QString itemId = event.value("item_id").toString();
+
+    if (type == "input_audio_buffer.committed") {
+        // Turns are kept in recording order, which previous_item_id spells out
+        if (!findItem(itemId)) {
+            Item item;
+            item.id = itemId;
+            int position = m_items.size();
+            const QString previous = event.value("previous_item_id").toString();
+            for (int i = 0; i < m_items.size(); ++i) {
+                if (m_items.at(i).id == previous) {
+                    position = i + 1;
+                    break;
+                }
+            }
+            m_items.insert(position, item);
+        }
+        m_uncommittedSamples = 0;
+        m_commitPending = false;
+        Tracer::instance().instant("realtime turn committed", "network", itemId);
+    } else if (type == "conversation.item.input_audio_transcription.delta") {
+        Item* item = findItem(itemId);
+        if (item && !item->completed) {
+            item->text += event.value("delta").toString();
+            emit partialTranscription(joinedText());
+        }
+    } else if (type == "conversation.item.input_audio_transcription.completed") {
+        if (Item* item = findItem(itemId)) {
+            item->text = event.value("transcript").toString();
+            item->completed = true;
+            Tracer::instance().instant("realtime turn transcribed", "network", itemId);
+            emit partialTranscription(joinedText());
+        }
+        finishIfDone();
+    } else if (type == "conversation.item.input_audio_transcription.failed") {
+        fail(QString("API error: %1").arg(event.value("error").toObject().value("message").toString()));
+    } else if (type == "error") {
+        const QJsonObject error = event.value("error").toObject();
+        if (error.value("code").toString() == COMMIT_EMPTY_CODE) {
+            m_commitPending = false;
+            finishIfDone();
+        } else {
+            fail(QString("API error: %1").arg(error.value("message").toString()));
+        }
+    }
+}
+
+RealtimeTranscriptionService::Item* RealtimeTranscriptionService::findItem(const QString& id)
+{
+    for (Item& item : m_items) {
+        if (item.id == id) {
+            return &item;
+        }
+    }
+    return nullptr;
+}
+
+QString RealtimeTranscriptionService::joinedText() const
+{
+    QStringList parts;
+    for (const Item& item : m_items) {
+        const QString text = item.text.trimmed();
+        if (!text.isEmpty()) {
+            parts << text;
+        }
+    }
+    return parts.join(' ');
+}
+
+void RealtimeTranscriptionService::finishIfDone()
+{
+    if (!m_isTranscribing || !m_audioDone || m_commitPending) {
+        return;
+    }
+    for (const Item& item : m_items) {
+        if (!item.completed) {
+            return;
+        }
+    }
+
+    const QString text = joinedText();
+    qInfo() << "Realtime transcription:" << m_items.size() << "turn(s), final text" << m_sinceAudioDone.elapsed()
+            << "ms after the last audio";
+    closeSession();
+    m_isTranscribing = false;
+    if (text.isEmpty()) {
+        emit transcriptionFailed("No speech recognized");
+        return;
+    }
+    emit transcriptionCompleted(text);
+}
+
+void RealtimeTranscriptionService::onResponseTimeout()
+{
+    fail(m_connected ? "Network error: connection stalled" : "Network error: timed out connecting to the realtime API");
+}
+
+void RealtimeTranscriptionService::fail(const QString& error)
+{
+    if (!m_isTranscribing) {
+        return;
+    }
+    qWarning() << "Realtime transcription failed:" << error;
+    closeSession();
+    m_isTranscribing = false;
+    emit transcriptionFailed(error);
+}
+
+void RealtimeTranscriptionService::closeSession()
+{
+    m_sendTimer.stop();
+    m_responseTimer.stop();
+    m_connected = false;
+    m_sources.clear();
+    if (m_socket) {
+        QWebSocket* socket = m_socket;
+        m_socket = nullptr;
+        socket->disconnect(this);
+        socket->close();
+        socket->deleteLater();
+    }
+}
@@ -0,0 +1,114 @@
+#ifndef REALTIMETRANSCRIPTIONSERVICE_H
+#define REALTIMETRANSCRIPTIONSERVICE_H
+
+#include <QElapsedTimer>
+#include <QJsonObject>
+#include <QList>
+#include <QPointer>
+#include <QSharedPointer>
+#include <QTimer>
+#include <QUrl>
+#include <QVector>
+#include <QWebSocket>
+#include <memory>
+#include <vector>
+
+#include "polyphaseresampler.h"
+#include "transcriptionbackend.h"
+
+// Transcribes while the user is still speaking: PCM is sent over one
+// WebSocket session to the API's realtime transcription endpoint as the
+// recorder produces it. The server cuts the audio into turns at pauses and
+// transcribes each turn as soon as it ends, streaming partial text back, so
+// when recording stops only the last turn is left to transcribe.
+//
+// Reads 16 kHz WAV straight from the recorder's arena and resamples it to the
+// endpoint's 24 kHz; the arena keeps everything, so audio recorded before the
+// socket is open is sent as soon as it is.
+class RealtimeTranscriptionService : public TranscriptionBackend
+{
+    Q_OBJECT
+public:
+    explicit RealtimeTranscriptionService(QObject* parent = nullptr);
+    ~RealtimeTranscriptionService() override;
+
+    QString name() const override { return "realtime"; }
+    bool isAvailable() const override { return !m_apiKey.isEmpty(); }
+    QString unavailableReason() const override { return "NO API KEY - Set OPENAI_API_KEY environment variable"; }
+    bool acceptsFormat(AudioFormat format) const override { return format == AudioFormat::Wav; }
+
+    bool supportsStreaming() const override { return true; }
+    void streamRecording(QSharedPointer<const ChunkedArena> audio, AudioFormat format, const QString& language) override;
+
+    // A finished recording goes through the same session, just faster than real time
+    void transcribeRecording(QSharedPointer<const ChunkedArena> audio, AudioFormat format,
+                             const QString& language) override;
+    void transcribeSegments(const QList<QSharedPointer<const ChunkedArena>>& segments,
+                            AudioFormat format,
+                            const QString& language) override;
+
+    void refreshCredentials() override;
+    void cancelTranscription() override;
+    bool isTranscribing() const override { return m_isTranscribing; }
+
+    // Same base URL as the HTTP API, e.g. "http://127.0.0.1:8089/v1"; empty
+    // restores $OPENAI_BASE_URL or the default
+    void setApiBaseUrl(const QString& baseUrl) { m_apiBaseUrl = baseUrl; }
+
+    // WebSocket endpoint below `baseUrl`: http becomes ws, https becomes wss
+    static QUrl realtimeUrl(const QString& baseUrl);
+
+private slots:
+    void onConnected();
+    void onDisconnected();
+    void onTextMessage(const QString& message);
+    void pump();
+    void onResponseTimeout();
+
+private:
+    // One committed turn, in recording order
+    struct Item
+    {
+        QString id;
+        QString text;
+        bool    completed = false;
+    };
+
+    void startSession(const QList<QSharedPointer<const ChunkedArena>>& sources, AudioFormat format,
+                      const QString& language);
+    void sendEvent(const QJsonObject& event);
+    void sendPendingAudio();
+    void finishAudio();
+    Item* findItem(const QString& id);
+    QString joinedText() const;
+    void finishIfDone();
+    void fail(const QString& error);
+    void closeSession();
+
+private:
+    QPointer<QWebSocket> m_socket;
+    QString              m_apiKey;
+    QString              m_apiBaseUrl;
+    QString              m_language;
+    bool                 m_isTranscribing;
+    bool                 m_connected;
+
+    // Audio still to send: the arenas in order and the read position in the current one
+    QList<QSharedPointer<const ChunkedArena>> m_sources;
+    int                  m_sourceIndex;
+    qint64               m_sourceOffset;
+    std::unique_ptr<PolyphaseResampler> m_resampler;
+    std::vector<short>   m_pcm;             // 16 kHz, not sent yet
+    std::vector<short>   m_resampled;
+    QTimer               m_sendTimer;
+
+    // After the last audio: the final commit and the turns still being transcribed
+    bool                 m_audioDone;
+    bool                 m_commitPending;
+    qint64               m_uncommittedSamples;  // At REALTIME_SAMPLE_RATE, since the last commit
+    QVector<Item>        m_items;
+    QTimer               m_responseTimer;
+    QElapsedTimer        m_sinceAudioDone;
+};
+
+#endif // REALTIMETRANSCRIPTIONSERVICE_H
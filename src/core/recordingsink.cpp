@@ -0,0 +1,40 @@
+#include "recordingsink.h"
+
+#include "config/config.h"
+
+QSharedPointer<ChunkedArena> createSegmentArena()
+{
+    return QSharedPointer<ChunkedArena>::create(RECORDING_ARENA_CHUNK_BYTES,
+                                                SEGMENT_MAX_BYTES / RECORDING_ARENA_CHUNK_BYTES + 2);
+}
+
+std::unique_ptr<RecordingSink> createRecordingSink(AudioFormat format, bool segmented, QString* error)
+{
+    std::unique_ptr<RecordingSink> sink(new RecordingSink);
+    sink->format = format;
+
+    sink->encoder = createAudioEncoder(format);
+    if (!sink->encoder || !sink->encoder->begin(SPEECH_SAMPLE_RATE, NUM_CHANNELS)) {
+        if (error) {
+            *error = sink->encoder ? sink->encoder->lastError() : QString("not available");
+        }
+        return nullptr;
+    }
+
+    // Fresh arena per recording: an upload still reading the previous one keeps
+    // its own reference
+    sink->recording = QSharedPointer<ChunkedArena>::create(RECORDING_ARENA_CHUNK_BYTES, RECORDING_ARENA_MAX_CHUNKS);
+
+    if (segmented) {
+        sink->segmentEncoder = createAudioEncoder(format);
+        if (!sink->segmentEncoder->begin(SPEECH_SAMPLE_RATE, NUM_CHANNELS)) {
+            if (error) {
+                *error = sink->segmentEncoder->lastError();
+            }
+            return nullptr;
+        }
+        sink->firstSegment = createSegmentArena();
+    }
+
+    return sink;
+}
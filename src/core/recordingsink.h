@@ -0,0 +1,33 @@
+#ifndef RECORDINGSINK_H
+#define RECORDINGSINK_H
+
+#include <QSharedPointer>
+#include <QString>
+#include <memory>
+
+#include "audioencoder.h"
+#include "chunkedarena.h"
+
+// Everything a recording writes into: a started encoder and the arena it
+// fills, plus the first segment when the recording is split. Built off the
+// critical path so starting a recording only has to move pointers.
+struct RecordingSink
+{
+    AudioFormat                     format = AudioFormat::Mp3;
+    std::unique_ptr<AudioEncoder>   encoder;
+    QSharedPointer<ChunkedArena>    recording;
+
+    // Only set when built for segmentation
+    std::unique_ptr<AudioEncoder>   segmentEncoder;
+    QSharedPointer<ChunkedArena>    firstSegment;
+
+    bool isSegmented() const { return segmentEncoder != nullptr; }
+};
+
+// Arena for one segment; sized for the segment byte budget
+QSharedPointer<ChunkedArena> createSegmentArena();
+
+// Returns nullptr and sets `error` if an encoder could not be started
+std::unique_ptr<RecordingSink> createRecordingSink(AudioFormat format, bool segmented, QString* error = nullptr);
+
+#endif // RECORDINGSINK_H
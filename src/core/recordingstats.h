@@ -0,0 +1,81 @@
+#ifndef RECORDINGSTATS_H
+#define RECORDINGSTATS_H
+
+#include <QtGlobal>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+// Snapshot of the live recording state, sampled by the UI at its own rate
+struct RecordingStats
+{
+    float   level = 0.0f;        // Scaled display level (0..1)
+    float   peakHold = 0.0f;     // Decaying peak level (0..1)
+    qint64  framesCaptured = 0;  // Frames handed to the encoder in this recording
+    qint64  bytesWritten = 0;    // Encoded bytes produced in this recording
+    quint32 generation = 0;      // Recording the frame counters belong to
+
+    qint64 elapsedMs(int sampleRate) const
+    {
+        return sampleRate > 0 ? framesCaptured * 1000 / sampleRate : 0;
+    }
+};
+
+// Single-writer sequence lock for small trivially copyable values.
+//
+// The writer never waits, so store() may be called from the audio callback.
+// Readers retry if they overlapped a write. The payload is kept in relaxed
+// atomic words so concurrent reads are well-defined.
+template <typename T>
+class SeqLock
+{
+    static_assert(std::is_trivially_copyable<T>::value, "SeqLock payload must be trivially copyable");
+
+public:
+    SeqLock()
+    {
+        store(T());
+    }
+
+    void store(const T& value)
+    {
+        std::uint64_t words[WordCount] = {};
+        std::memcpy(words, &value, sizeof(T));
+
+        const std::uint32_t sequence = m_sequence.load(std::memory_order_relaxed);
+        m_sequence.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (std::size_t i = 0; i < WordCount; ++i) {
+            m_words[i].store(words[i], std::memory_order_relaxed);
+        }
+        m_sequence.store(sequence + 2, std::memory_order_release);
+    }
+
+    T load() const
+    {
+        std::uint64_t words[WordCount];
+        std::uint32_t before = 0;
+        std::uint32_t after = 0;
+        do {
+            before = m_sequence.load(std::memory_order_acquire);
+            for (std::size_t i = 0; i < WordCount; ++i) {
+                words[i] = m_words[i].load(std::memory_order_relaxed);
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            after = m_sequence.load(std::memory_order_relaxed);
+        } while ((before & 1u) != 0 || before != after);
+
+        T value;
+        std::memcpy(&value, words, sizeof(T));
+        return value;
+    }
+
+private:
+    static constexpr std::size_t WordCount = (sizeof(T) + sizeof(std::uint64_t) - 1) / sizeof(std::uint64_t);
+
+    std::atomic<std::uint32_t> m_sequence{0};
+    std::atomic<std::uint64_t> m_words[WordCount];
+};
+
+#endif // RECORDINGSTATS_H
@@ -0,0 +1,247 @@
+#include "requeststats.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QStandardPaths>
+#include <algorithm>
+#include <cmath>
+
+#include "config/config.h"
+
+namespace {
+
+constexpr int STATS_FILE_VERSION = 1;
+
+QString formatMs(qint64 us)
+{
+    return us < 0 ? QString("-") : QString::number(us / 1000.0, 'f', 1);
+}
+
+// Nearest-rank percentile of an ascending list
+double percentile(const QVector<double>& sorted, int percent)
+{
+    const int rank = static_cast<int>(std::ceil(percent / 100.0 * sorted.size()));
+    return sorted.at(qBound(0, rank - 1, sorted.size() - 1));
+}
+
+} // namespace
+
+qint64 RequestTiming::tcpUs() const
+{
+    return connectedUs < 0 ? -1 : connectedUs - qMax<qint64>(dnsDoneUs, 0);
+}
+
+qint64 RequestTiming::tlsUs() const
+{
+    return secureUs < 0 || connectedUs < 0 ? -1 : secureUs - connectedUs;
+}
+
+qint64 RequestTiming::connectUs() const
+{
+    return secureUs >= 0 ? secureUs : connectedUs;
+}
+
+qint64 RequestTiming::uploadUs() const
+{
+    return bodySentUs < 0 ? -1 : bodySentUs - qMax<qint64>(connectUs(), 0);
+}
+
+qint64 RequestTiming::timeToFirstByteUs() const
+{
+    return firstByteUs < 0 || bodySentUs < 0 ? -1 : firstByteUs - bodySentUs;
+}
+
+qint64 RequestTiming::networkWaitUs() const
+{
+    const qint64 ttfb = timeToFirstByteUs();
+    return ttfb < 0 || serverProcessingMs < 0 ? -1 : ttfb - serverProcessingMs * 1000;
+}
+
+double RequestTiming::uploadKBps() const
+{
+    const qint64 upload = uploadUs();
+    return upload > 0 ? payloadBytes / 1024.0 / (upload / 1e6) : -1.0;
+}
+
+QString RequestTiming::describe() const
+{
+    QString text = QString("%1 request, HTTP %2: %3 bytes").arg(kind).arg(httpStatus).arg(payloadBytes);
+    if (audioMs >= 0) {
+        text += QString(" (%1 s of audio)").arg(audioMs / 1000.0, 0, 'f', 1);
+    }
+    text += QString(" | dns %1 ms, tcp %2 ms, tls %3 ms, connect %4 ms")
+                .arg(formatMs(dnsUs()), formatMs(tcpUs()), formatMs(tlsUs()), formatMs(connectUs()));
+    text += QString(" | first upload byte at %1 ms, upload %2 ms").arg(formatMs(firstBodyByteUs), formatMs(uploadUs()));
+    if (uploadKBps() >= 0 && kind != "stream") {
+        text += QString(" (%1 KB/s)").arg(uploadKBps(), 0, 'f', 0);
+    }
+    text += QString(" | first byte after %1 ms, server %2 ms, network wait %3 ms | total %4 ms")
+                .arg(formatMs(timeToFirstByteUs()),
+                     serverProcessingMs < 0 ? QString("-") : QString::number(serverProcessingMs),
+                     formatMs(networkWaitUs()),
+                     formatMs(finishedUs));
+    return text;
+}
+
+RequestStatistics::RequestStatistics(const QString& path)
+    : m_path(path)
+{
+}
+
+QString RequestStatistics::defaultPath()
+{
+    QString directory = QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation);
+    if (directory.isEmpty()) {
+        directory = QDir::tempPath();
+    }
+    return QDir(directory).filePath(REQUEST_STATS_FILE_NAME);
+}
+
+bool RequestStatistics::load()
+{
+    m_samples.clear();
+    m_counters.clear();
+
+    QFile file(m_path);
+    if (!file.exists()) {
+        return true;
+    }
+    if (!file.open(QIODevice::ReadOnly)) {
+        qWarning() << "Cannot read request statistics from" << m_path << ":" << file.errorString();
+        return false;
+    }
+
+    const QJsonDocument document = QJsonDocument::fromJson(file.readAll());
+    const QJsonObject root = document.object();
+    if (root.value("version").toInt() != STATS_FILE_VERSION) {
+        qWarning() << "Ignoring request statistics in" << m_path << "with an unknown format";
+        return false;
+    }
+
+    const QJsonObject metrics = root.value("metrics").toObject();
+    for (auto it = metrics.constBegin(); it != metrics.constEnd(); ++it) {
+        const QJsonArray values = it.value().toArray();
+        QVector<double>& samples = m_samples[it.key()];
+        const int first = qMax(0, values.size() - REQUEST_STATS_WINDOW);
+        for (int i = first; i < values.size(); ++i) {
+            samples.append(values.at(i).toDouble());
+        }
+    }
+
+    const QJsonObject counters = root.value("counters").toObject();
+    for (auto it = counters.constBegin(); it != counters.constEnd(); ++it) {
+        m_counters.insert(it.key(), static_cast<qint64>(it.value().toDouble()));
+    }
+    return true;
+}
+
+bool RequestStatistics::save() const
+{
+    QJsonObject metrics;
+    for (auto it = m_samples.constBegin(); it != m_samples.constEnd(); ++it) {
+        QJsonArray values;
+        for (double value : it.value()) {
+            values.append(value);
+        }
+        metrics.insert(it.key(), values);
+    }
+    QJsonObject counters;
+    for (auto it = m_counters.constBegin(); it != m_counters.constEnd(); ++it) {
+        counters.insert(it.key(), it.value());
+    }
+    QJsonObject root;
+    root.insert("version", STATS_FILE_VERSION);
+    root.insert("metrics", metrics);
+    root.insert("counters", counters);
+
+    QDir().mkpath(QFileInfo(m_path).absolutePath());
+    QFile file(m_path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qWarning() << "Cannot write request statistics to" << m_path << ":" << file.errorString();
+        return false;
+    }
+    file.write(QJsonDocument(root).toJson(QJsonDocument::Compact));
+    return true;
+}
+
+void RequestStatistics::add(const RequestTiming& timing)
+{
+    if (!timing.succeeded) {
+        return;
+    }
+
+    auto addMs = [this](const char* metric, qint64 us) {
+        if (us >= 0) {
+            addSample(metric, us / 1000.0);
+        }
+    };
+    addMs("dns_ms", timing.dnsUs());
+    addMs("tcp_ms", timing.tcpUs());
+    addMs("tls_ms", timing.tlsUs());
+    addMs("connect_ms", timing.connectUs());
+    addMs("first_upload_byte_ms", timing.firstBodyByteUs);
+    // A streamed body takes as long as the recording; its upload time says nothing about the link
+    if (timing.kind != "stream") {
+        addMs("upload_ms", timing.uploadUs());
+        if (timing.uploadKBps() >= 0) {
+            addSample("upload_kbps", timing.uploadKBps());
+        }
+    }
+    addMs("ttfb_ms", timing.timeToFirstByteUs());
+    if (timing.serverProcessingMs >= 0) {
+        addSample("server_ms", timing.serverProcessingMs);
+    }
+    addMs("network_wait_ms", timing.networkWaitUs());
+    addMs("total_ms", timing.finishedUs);
+    addSample("payload_kb", timing.payloadBytes / 1024.0);
+    if (timing.audioMs >= 0) {
+        addSample("audio_s", timing.audioMs / 1000.0);
+    }
+}
+
+void RequestStatistics::addSample(const QString& metric, double value)
+{
+    QVector<double>& samples = m_samples[metric];
+    if (samples.size() >= REQUEST_STATS_WINDOW) {
+        samples.remove(0, samples.size() - REQUEST_STATS_WINDOW + 1);
+    }
+    samples.append(value);
+}
+
+RequestStatistics::Percentiles RequestStatistics::percentiles(const QString& metric) const
+{
+    Percentiles result;
+    QVector<double> sorted = m_samples.value(metric);
+    if (sorted.isEmpty()) {
+        return result;
+    }
+    std::sort(sorted.begin(), sorted.end());
+    result.count = sorted.size();
+    result.p50 = percentile(sorted, 50);
+    result.p95 = percentile(sorted, 95);
+    result.p99 = percentile(sorted, 99);
+    return result;
+}
+
+QString RequestStatistics::describe() const
+{
+    QStringList lines;
+    for (const QString& metric : m_samples.keys()) {
+        const Percentiles p = percentiles(metric);
+        lines << QString("%1 n=%2 p50=%3 p95=%4 p99=%5")
+                     .arg(metric, -16)
+                     .arg(p.count)
+                     .arg(p.p50, 0, 'f', 1)
+                     .arg(p.p95, 0, 'f', 1)
+                     .arg(p.p99, 0, 'f', 1);
+    }
+    for (auto it = m_counters.constBegin(); it != m_counters.constEnd(); ++it) {
+        lines << QString("%1 %2").arg(it.key(), -16).arg(it.value());
+    }
+    return lines.join('\n');
+}
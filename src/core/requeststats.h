@@ -0,0 +1,102 @@
+#ifndef REQUESTSTATS_H
+#define REQUESTSTATS_H
+
+#include <QElapsedTimer>
+#include <QMap>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QtGlobal>
+
+// Phase timings of one transcription request. Points are microseconds since
+// start(); -1 where a phase was not observed (QNetworkAccessManager does not
+// report DNS and TCP separately, a reused connection has no handshake).
+struct RequestTiming
+{
+    QString kind;                   // "upload", "stream" or "segment"
+    qint64  payloadBytes = 0;
+    qint64  audioMs = -1;
+    int     httpStatus = 0;
+    bool    succeeded = false;
+
+    qint64  dnsDoneUs = -1;
+    qint64  connectedUs = -1;       // TCP connection established
+    qint64  secureUs = -1;          // TLS handshake done
+    qint64  firstBodyByteUs = -1;   // First request body byte handed to the connection
+    qint64  bodySentUs = -1;
+    qint64  firstByteUs = -1;       // First response byte (or headers)
+    qint64  finishedUs = -1;
+    qint64  serverProcessingMs = -1; // As reported by the server in SERVER_PROCESSING_HEADER
+
+    void start() { m_clock.start(); }
+    qint64 elapsedUs() const { return m_clock.isValid() ? m_clock.nsecsElapsed() / 1000 : -1; }
+
+    // Records the current time into `point` unless it was already set
+    void mark(qint64& point)
+    {
+        if (point < 0) {
+            point = elapsedUs();
+        }
+    }
+
+    // Derived phases, -1 where unknown
+    qint64 dnsUs() const { return dnsDoneUs; }
+    qint64 tcpUs() const;
+    qint64 tlsUs() const;
+    qint64 connectUs() const;       // Until the connection was ready for the request
+    qint64 uploadUs() const;
+    qint64 timeToFirstByteUs() const;   // From the last body byte
+    qint64 networkWaitUs() const;   // Time to first byte minus server processing
+    double uploadKBps() const;
+
+    QString describe() const;
+
+private:
+    QElapsedTimer m_clock;
+};
+
+// Rolling windows of request timings, persisted across runs so percentiles
+// cover more than one session. Only requests that got a successful reply are
+// added; failures would only blur the picture of a normal request. Event
+// counters (e.g. how often a request was hedged) are kept alongside.
+class RequestStatistics
+{
+public:
+    struct Percentiles
+    {
+        int    count = 0;
+        double p50 = 0.0;
+        double p95 = 0.0;
+        double p99 = 0.0;
+    };
+
+    explicit RequestStatistics(const QString& path = defaultPath());
+
+    // Stats file under the user's cache directory
+    static QString defaultPath();
+    QString path() const { return m_path; }
+
+    // A missing file is not an error
+    bool load();
+    bool save() const;
+
+    void add(const RequestTiming& timing);
+    void addSample(const QString& metric, double value);
+
+    Percentiles percentiles(const QString& metric) const;
+    QStringList metrics() const { return m_samples.keys(); }
+
+    // Running totals, never windowed
+    void increment(const QString& counter) { ++m_counters[counter]; }
+    qint64 counter(const QString& counter) const { return m_counters.value(counter); }
+
+    // One line per metric: "ttfb_ms n=42 p50=... p95=... p99=...", then the counters
+    QString describe() const;
+
+private:
+    QString                         m_path;
+    QMap<QString, QVector<double>>  m_samples;  // Oldest first, at most REQUEST_STATS_WINDOW each
+    QMap<QString, qint64>           m_counters;
+};
+
+#endif // REQUESTSTATS_H
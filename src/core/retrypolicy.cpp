@@ -0,0 +1,96 @@
+#include "retrypolicy.h"
+
+#include <QDateTime>
+#include <QLocale>
+#include <QRandomGenerator>
+
+#include "config/config.h"
+
+RetryPolicy::RetryPolicy()
+    : m_deadlineMs(-1)
+{
+}
+
+void RetryPolicy::start(qint64 audioMs)
+{
+    m_clock.start();
+    m_deadlineMs = deadlineForAudio(audioMs);
+}
+
+qint64 RetryPolicy::remainingMs() const
+{
+    if (m_deadlineMs < 0) {
+        return -1;
+    }
+    return qMax<qint64>(0, m_deadlineMs - m_clock.elapsed());
+}
+
+qint64 RetryPolicy::deadlineForAudio(qint64 audioMs)
+{
+    if (audioMs < 0) {
+        return -1;
+    }
+    return qMin<qint64>(RETRY_DEADLINE_BASE_MS + static_cast<qint64>(audioMs * RETRY_DEADLINE_PER_AUDIO_MS),
+                        RETRY_DEADLINE_MAX_MS);
+}
+
+qint64 RetryPolicy::nextDelayMs(int failedAttempts, qint64 retryAfterMs) const
+{
+    if (failedAttempts >= RETRY_MAX_ATTEMPTS) {
+        return -1;
+    }
+
+    // "Equal jitter": half the backoff is fixed, the other half random, so
+    // clients that failed together do not come back together
+    const int exponent = qBound(0, failedAttempts - 1, 16);
+    const qint64 backoff = qMin<qint64>(static_cast<qint64>(RETRY_BASE_DELAY_MS) << exponent, RETRY_MAX_DELAY_MS);
+    qint64 delay = backoff / 2 + QRandomGenerator::global()->bounded(static_cast<int>(backoff / 2 + 1));
+    delay = qMax(delay, retryAfterMs);
+
+    const qint64 remaining = remainingMs();
+    if (remaining >= 0 && delay >= remaining) {
+        return -1;
+    }
+    return delay;
+}
+
+bool RetryPolicy::isRetryable(int httpStatus, QNetworkReply::NetworkError error)
+{
+    if (httpStatus > 0) {
+        return httpStatus == 408 || httpStatus == 409 || httpStatus == 429 || httpStatus >= 500;
+    }
+
+    // A name that does not resolve, a failed TLS handshake or a garbled
+    // response would fail the same way on the next attempt
+    switch (error) {
+    case QNetworkReply::RemoteHostClosedError:
+    case QNetworkReply::TimeoutError:
+    case QNetworkReply::TemporaryNetworkFailureError:
+    case QNetworkReply::NetworkSessionFailedError:
+        return true;
+    default:
+        return false;
+    }
+}
+
+qint64 RetryPolicy::parseRetryAfter(const QByteArray& value)
+{
+    const QByteArray trimmed = value.trimmed();
+    if (trimmed.isEmpty()) {
+        return -1;
+    }
+
+    bool ok = false;
+    const qint64 seconds = trimmed.toLongLong(&ok);
+    if (ok) {
+        return seconds >= 0 ? seconds * 1000 : -1;
+    }
+
+    // IMF-fixdate, e.g. "Wed, 21 Oct 2015 07:28:00 GMT"
+    QDateTime date = QLocale::c().toDateTime(QString::fromLatin1(trimmed), "ddd, dd MMM yyyy HH:mm:ss 'GMT'");
+    if (!date.isValid()) {
+        return -1;
+    }
+    date.setTimeSpec(Qt::UTC);
+    return qMax<qint64>(0, QDateTime::currentDateTimeUtc().msecsTo(date));
+}
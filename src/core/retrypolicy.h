@@ -0,0 +1,46 @@
+#ifndef RETRYPOLICY_H
+#define RETRYPOLICY_H
+
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QNetworkReply>
+#include <QtGlobal>
+
+// When to try a failed transcription request again: exponential backoff
+// with jitter, the server's Retry-After where given, and an overall deadline
+// for the whole transcription that grows with the length of the audio.
+class RetryPolicy
+{
+public:
+    RetryPolicy();
+
+    // Starts the deadline clock for a new transcription, or again once a
+    // streamed recording has ended and its length is known. No deadline
+    // while `audioMs` is unknown (-1).
+    void start(qint64 audioMs);
+
+    // Milliseconds left before giving up, -1 without a deadline
+    qint64 remainingMs() const;
+
+    // Delay before the attempt after `failedAttempts` failures, or -1 to give
+    // up. `retryAfterMs` is the server's Retry-After (-1 = none); it is
+    // honored even when longer than the backoff, unless it runs past the deadline.
+    qint64 nextDelayMs(int failedAttempts, qint64 retryAfterMs) const;
+
+    // Timeouts, throttling and server errors are worth another try; a rejected
+    // request would fail the same way again. Without a response (httpStatus 0)
+    // only a dropped or stalled connection is: `error` is the reply's error,
+    // TimeoutError for a request the stall watchdog aborted.
+    static bool isRetryable(int httpStatus, QNetworkReply::NetworkError error);
+
+    // Retry-After as delay-seconds or HTTP-date; -1 if missing or invalid
+    static qint64 parseRetryAfter(const QByteArray& value);
+
+    static qint64 deadlineForAudio(qint64 audioMs);
+
+private:
+    QElapsedTimer m_clock;
+    qint64        m_deadlineMs;     // From m_clock's start, -1 = none
+};
+
+#endif // RETRYPOLICY_H
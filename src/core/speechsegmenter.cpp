@@ -0,0 +1,77 @@
+#include "speechsegmenter.h"
+
+#include <cmath>
+
+#include "levelmeter.h"
+
+namespace {
+
+constexpr int ANALYSIS_FRAME_MS = 20;
+
+} // namespace
+
+SpeechSegmenter::SpeechSegmenter(int sampleRate, const Budget& budget)
+    : m_sampleRate(sampleRate),
+      m_budget(budget),
+      m_frameSamples(sampleRate * ANALYSIS_FRAME_MS / 1000),
+      m_frameEnergy(0.0),
+      m_frameFill(0),
+      m_segmentSamples(0),
+      m_quietSamples(0)
+{
+}
+
+void SpeechSegmenter::reset()
+{
+    startSegment();
+    m_frameEnergy = 0.0;
+    m_frameFill = 0;
+    m_quietSamples = 0;
+}
+
+void SpeechSegmenter::startSegment()
+{
+    // The pause we cut in carries over: the next segment starts quiet too, and
+    // the frame in progress straddles the cut
+    m_segmentSamples = m_frameFill;
+}
+
+qint64 SpeechSegmenter::findCut(const short* pcm, std::size_t count, qint64 segmentBytes)
+{
+    const qint64 maxSamples = static_cast<qint64>(m_budget.maxSeconds) * m_sampleRate;
+    const qint64 targetSamples = static_cast<qint64>(m_budget.targetSeconds) * m_sampleRate;
+    const qint64 minPauseSamples = static_cast<qint64>(m_budget.minPauseMs) * m_sampleRate / 1000;
+
+    // Encoded output trails the PCM a little, so the size check is approximate
+    if (segmentBytes >= m_budget.maxBytes) {
+        return 0;
+    }
+
+    std::size_t position = 0;
+    while (position < count) {
+        const std::size_t take = qMin<std::size_t>(count - position, static_cast<std::size_t>(m_frameSamples - m_frameFill));
+        const LevelStats level = measureLevel(pcm + position, take);
+        m_frameEnergy += static_cast<double>(level.rms) * level.rms * static_cast<double>(take);
+        m_frameFill += static_cast<int>(take);
+        m_segmentSamples += static_cast<qint64>(take);
+        position += take;
+
+        if (m_frameFill < m_frameSamples) {
+            break;
+        }
+
+        const double rms = std::sqrt(m_frameEnergy / m_frameFill);
+        m_quietSamples = rms < m_budget.silenceRms ? m_quietSamples + m_frameFill : 0;
+        m_frameEnergy = 0.0;
+        m_frameFill = 0;
+
+        const bool pause = m_quietSamples >= minPauseSamples;
+        if (m_segmentSamples >= maxSamples || (m_segmentSamples >= targetSamples && pause)) {
+            // The segment ends here, inside the pause; the rest of the pause
+            // opens the next one
+            m_quietSamples = 0;
+            return static_cast<qint64>(position);
+        }
+    }
+    return -1;
+}
@@ -0,0 +1,46 @@
+#ifndef SPEECHSEGMENTER_H
+#define SPEECHSEGMENTER_H
+
+#include <QtGlobal>
+#include <cstddef>
+
+// Finds where to split a long recording so every piece stays within the
+// transcription budget. PCM is analysed in short frames; once a segment has
+// reached the target duration it is cut at the next pause, and it is cut
+// unconditionally when it hits the duration or size limit.
+class SpeechSegmenter
+{
+public:
+    struct Budget
+    {
+        int    targetSeconds;   // Start looking for a pause from here on
+        int    maxSeconds;      // Hard cut, pause or not
+        qint64 maxBytes;        // Hard cut once the encoded segment gets this big
+        int    minPauseMs;      // Quiet time that counts as a pause
+        float  silenceRms;      // Normalized RMS below which a frame is quiet
+    };
+
+    SpeechSegmenter(int sampleRate, const Budget& budget);
+
+    // Scan `count` mono samples that follow what was fed before. Returns the
+    // number of samples that still belong to the current segment if it should
+    // end inside this block, or -1 to keep going. After a cut, call
+    // startSegment() and feed the rest of the block again.
+    qint64 findCut(const short* pcm, std::size_t count, qint64 segmentBytes);
+
+    void startSegment();
+    void reset();
+
+    qint64 segmentSamples() const { return m_segmentSamples; }
+
+private:
+    int         m_sampleRate;
+    Budget      m_budget;
+    int         m_frameSamples;     // Analysis frame length
+    double      m_frameEnergy;      // Sum of squares of the frame in progress
+    int         m_frameFill;        // Samples in the frame in progress
+    qint64      m_segmentSamples;   // Samples in the current segment
+    qint64      m_quietSamples;     // Length of the current quiet run
+};
+
+#endif // SPEECHSEGMENTER_H
@@ -0,0 +1,105 @@
+#ifndef SPSCRINGBUFFER_H
+#define SPSCRINGBUFFER_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <algorithm>
+#include <type_traits>
+
+// Wait-free single-producer/single-consumer ring buffer.
+//
+// Exactly one thread may call push() (the PortAudio callback) and exactly one
+// thread may call pop() (the encoder worker). Neither side ever blocks, locks
+// or allocates, which makes push() safe to call from a real-time audio thread.
+// The capacity is rounded up to a power of two so indices can be masked.
+template <typename T>
+class SpscRingBuffer
+{
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "SpscRingBuffer only holds trivially copyable samples");
+
+public:
+    explicit SpscRingBuffer(std::size_t minCapacity)
+    {
+        std::size_t capacity = 1;
+        while (capacity < minCapacity) {
+            capacity <<= 1;
+        }
+        m_capacity = capacity;
+        m_mask = capacity - 1;
+        m_data.reset(new T[capacity]);
+    }
+
+    SpscRingBuffer(const SpscRingBuffer&) = delete;
+    SpscRingBuffer& operator=(const SpscRingBuffer&) = delete;
+
+    std::size_t capacity() const { return m_capacity; }
+
+    // Producer side: copies up to `count` items, returns how many fit
+    std::size_t push(const T* data, std::size_t count)
+    {
+        const std::size_t head = m_head.load(std::memory_order_relaxed);
+        const std::size_t tail = m_tail.load(std::memory_order_acquire);
+        const std::size_t toWrite = std::min(count, m_capacity - (head - tail));
+        if (toWrite == 0) {
+            return 0;
+        }
+
+        const std::size_t start = head & m_mask;
+        const std::size_t firstPart = std::min(toWrite, m_capacity - start);
+        std::copy(data, data + firstPart, m_data.get() + start);
+        std::copy(data + firstPart, data + toWrite, m_data.get());
+
+        m_head.store(head + toWrite, std::memory_order_release);
+        return toWrite;
+    }
+
+    // Consumer side: moves up to `maxCount` items into `out`, returns how many
+    std::size_t pop(T* out, std::size_t maxCount)
+    {
+        const std::size_t tail = m_tail.load(std::memory_order_relaxed);
+        const std::size_t head = m_head.load(std::memory_order_acquire);
+        const std::size_t toRead = std::min(maxCount, head - tail);
+        if (toRead == 0) {
+            return 0;
+        }
+
+        const std::size_t start = tail & m_mask;
+        const std::size_t firstPart = std::min(toRead, m_capacity - start);
+        std::copy(m_data.get() + start, m_data.get() + start + firstPart, out);
+        std::copy(m_data.get(), m_data.get() + (toRead - firstPart), out + firstPart);
+
+        m_tail.store(tail + toRead, std::memory_order_release);
+        return toRead;
+    }
+
+    // Number of items waiting to be consumed (approximate from the producer side)
+    std::size_t readAvailable() const
+    {
+        return m_head.load(std::memory_order_acquire) - m_tail.load(std::memory_order_acquire);
+    }
+
+    std::size_t writeAvailable() const
+    {
+        return m_capacity - readAvailable();
+    }
+
+    // Discard everything. Only valid while neither side is running.
+    void reset()
+    {
+        m_head.store(0, std::memory_order_relaxed);
+        m_tail.store(0, std::memory_order_relaxed);
+    }
+
+private:
+    std::unique_ptr<T[]> m_data;
+    std::size_t          m_capacity;
+    std::size_t          m_mask;
+
+    // Keep producer and consumer indices on separate cache lines
+    alignas(64) std::atomic<std::size_t> m_head{0};
+    alignas(64) std::atomic<std::size_t> m_tail{0};
+};
+
+#endif // SPSCRINGBUFFER_H
@@ -1,5 +1,6 @@
 #include "statusutils.h"
 #include "config/config.h"
+#include "tracer.h"
 
 #include <QFile>
 #include <QTextStream>
@@ -8,6 +9,8 @@
 
 bool setFileStatus(const QString& status, const QString& errorMessage)
 {
+    TraceSpan span("write status file", "status");
+    span.setDetail(status);
     QFile statusFile(STATUS_FILE_PATH);
     if (!statusFile.open(QIODevice::WriteOnly | QIODevice::Text)) {
         qWarning() << "Failed to open status file for writing:" << STATUS_FILE_PATH;
@@ -29,15 +32,32 @@ bool setFileStatus(const QString& status, const QString& errorMessage)
 }
 
 void notifyI3Blocks() {
+    TraceSpan span("notify i3blocks", "status");
     QProcess::execute("pkill", {"-RTMIN+2", "i3blocks"}); // pkill -RTMIN+2 i3blocks
 }
 
+bool saveTranscription(const QString& text)
+{
+    TraceSpan span("write transcription file", "status");
+    QFile outputFile(TRANSCRIPTION_OUTPUT_PATH);
+    if (!outputFile.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        qWarning() << "Failed to save transcription to" << TRANSCRIPTION_OUTPUT_PATH;
+        return false;
+    }
+    QTextStream out(&outputFile);
+    out << text;
+    outputFile.close();
+    qInfo() << "Transcription saved to" << TRANSCRIPTION_OUTPUT_PATH;
+    return true;
+}
+
 void copyTranscriptionToClipboard(bool andPressCtrlV) {
     QString command = QString("tr -d '\\n' < %1 | xclip -i -sel c").arg(TRANSCRIPTION_OUTPUT_PATH);
     if (andPressCtrlV) {
         command += " && xdotool key ctrl+v";
     }
 
+    TraceSpan span(andPressCtrlV ? "xclip + xdotool paste" : "xclip", "status");
     int exitCode = QProcess::execute("/bin/sh", {"-c", command});
     if (exitCode != 0) {
         qWarning() << "Failed to copy transcription to clipboard. Exit code:" << exitCode;
@@ -14,6 +14,9 @@ bool setFileStatus(const QString& status, const QString& errorMessage = QString(
 
 void notifyI3Blocks();
 
+// Write `text` to TRANSCRIPTION_OUTPUT_PATH, which the clipboard copy reads
+bool saveTranscription(const QString& text);
+
 void copyTranscriptionToClipboard(bool andPressCtrlV);
 
 #endif // STATUSUTILS_H
\ No newline at end of file
@@ -0,0 +1,405 @@
+#include "streamingupload.h"
+
+#include <QDebug>
+#include <QRandomGenerator>
+
+#include "config/config.h"
+
+namespace {
+
+// Decode a chunked HTTP body. Returns false while the terminating chunk is
+// still missing; `ok` turns false if the framing is invalid.
+bool decodeChunkedBody(const QByteArray& data, QByteArray* body, bool* ok)
+{
+    body->clear();
+    *ok = true;
+    int position = 0;
+    while (true) {
+        const int lineEnd = data.indexOf("\r\n", position);
+        if (lineEnd < 0) {
+            return false;
+        }
+        // Chunk extensions after ';' are allowed and ignored
+        QByteArray sizeField = data.mid(position, lineEnd - position);
+        const int extension = sizeField.indexOf(';');
+        if (extension >= 0) {
+            sizeField.truncate(extension);
+        }
+        bool validSize = false;
+        const int size = sizeField.trimmed().toInt(&validSize, 16);
+        if (!validSize || size < 0) {
+            *ok = false;
+            return true;
+        }
+        position = lineEnd + 2;
+        if (size == 0) {
+            // Trailers are not used by anything we talk to; the final CRLF is enough
+            return data.indexOf("\r\n", position) >= 0;
+        }
+        if (data.size() < position + size + 2) {
+            return false;
+        }
+        // Every chunk's data ends in CRLF; anything else means we lost the framing
+        if (data.at(position + size) != '\r' || data.at(position + size + 1) != '\n') {
+            *ok = false;
+            return true;
+        }
+        body->append(data.constData() + position, size);
+        position += size + 2;
+    }
+}
+
+// What QNetworkAccessManager would have reported for a socket error
+QNetworkReply::NetworkError replyErrorFor(QAbstractSocket::SocketError error)
+{
+    switch (error) {
+    case QAbstractSocket::ConnectionRefusedError:
+        return QNetworkReply::ConnectionRefusedError;
+    case QAbstractSocket::RemoteHostClosedError:
+        return QNetworkReply::RemoteHostClosedError;
+    case QAbstractSocket::HostNotFoundError:
+        return QNetworkReply::HostNotFoundError;
+    case QAbstractSocket::SocketTimeoutError:
+        return QNetworkReply::TimeoutError;
+    case QAbstractSocket::NetworkError:
+        return QNetworkReply::TemporaryNetworkFailureError;
+    case QAbstractSocket::SslHandshakeFailedError:
+        return QNetworkReply::SslHandshakeFailedError;
+    default:
+        return QNetworkReply::UnknownNetworkError;
+    }
+}
+
+} // namespace
+
+StreamingUpload::StreamingUpload(QObject* parent)
+    : QObject(parent),
+      m_socket(nullptr),
+      m_state(State::Idle),
+      m_audioSent(0)
+{
+    m_pumpTimer.setInterval(STREAM_UPLOAD_POLL_INTERVAL_MS);
+    connect(&m_pumpTimer, &QTimer::timeout, this, &StreamingUpload::pump);
+
+    // Guards connecting and waiting for the response; the upload itself is
+    // watched in pump()
+    m_responseTimer.setSingleShot(true);
+    connect(&m_responseTimer, &QTimer::timeout, this, [this]() {
+        fail(m_state == State::Connecting
+                 ? QString("Network error: could not connect within %1 s").arg(TRANSCRIPTION_STALL_TIMEOUT_MS / 1000)
+                 : QString("Network error: timed out waiting for the transcription response"),
+             QNetworkReply::TimeoutError);
+    });
+}
+
+StreamingUpload::~StreamingUpload()
+{
+    reset();
+}
+
+void StreamingUpload::start(const QUrl& url,
+                            const HeaderList& headers,
+                            const HeaderList& fields,
+                            const QString& filename,
+                            QSharedPointer<const ChunkedArena> audio)
+{
+    reset();
+
+    m_url = url;
+    m_audio = std::move(audio);
+    m_audioSent = 0;
+    m_response.clear();
+    m_retryAfter.clear();
+    m_timing = RequestTiming();
+    m_timing.kind = "stream";
+
+    // Fixed length, so the multipart overhead is the same for every request
+    const QByteArray boundary =
+        "----voiceinput" + QByteArray::number(QRandomGenerator::global()->generate64(), 16).rightJustified(16, '0');
+
+    QByteArray path = url.path(QUrl::FullyEncoded).toUtf8();
+    if (path.isEmpty()) {
+        path = "/";
+    }
+    if (url.hasQuery()) {
+        path += "?" + url.query(QUrl::FullyEncoded).toUtf8();
+    }
+
+    const bool secure = url.scheme() == "https";
+    const int defaultPort = secure ? 443 : 80;
+    QByteArray host = url.host().toUtf8();
+    if (url.port(defaultPort) != defaultPort) {
+        host += ":" + QByteArray::number(url.port());
+    }
+
+    m_requestHead = "POST " + path + " HTTP/1.1\r\n"
+                    "Host: " + host + "\r\n"
+                    "Content-Type: multipart/form-data; boundary=" + boundary + "\r\n"
+                    "Transfer-Encoding: chunked\r\n"
+                    "Connection: close\r\n";
+    for (const auto& header : headers) {
+        m_requestHead += header.first + ": " + header.second + "\r\n";
+    }
+    m_requestHead += "\r\n";
+
+    // The multipart preamble goes out as the first chunk
+    QByteArray preamble;
+    for (const auto& field : fields) {
+        preamble += "--" + boundary + "\r\n"
+                    "Content-Disposition: form-data; name=\"" + field.first + "\"\r\n\r\n"
+                    + field.second + "\r\n";
+    }
+    preamble += "--" + boundary + "\r\n"
+                "Content-Disposition: form-data; name=\"file\"; filename=\"" + filename.toUtf8() + "\"\r\n"
+                "Content-Type: application/octet-stream\r\n\r\n";
+    m_requestHead += QByteArray::number(preamble.size(), 16) + "\r\n" + preamble + "\r\n";
+    m_epilogue = "\r\n--" + boundary + "--\r\n";
+
+    m_socket = new QSslSocket(this);
+    connect(m_socket, &QSslSocket::readyRead, this, &StreamingUpload::onReadyRead);
+    connect(m_socket, &QSslSocket::disconnected, this, &StreamingUpload::onDisconnected);
+    connect(m_socket, &QSslSocket::bytesWritten, this, [this]() { m_lastProgress.restart(); });
+    connect(m_socket, &QSslSocket::bytesWritten, this, &StreamingUpload::pump);
+    connect(m_socket, &QAbstractSocket::errorOccurred, this, &StreamingUpload::onSocketError);
+    connect(m_socket, &QAbstractSocket::hostFound, this, [this]() { m_timing.mark(m_timing.dnsDoneUs); });
+    connect(m_socket, &QAbstractSocket::connected, this, [this]() { m_timing.mark(m_timing.connectedUs); });
+
+    m_state = State::Connecting;
+    m_elapsed.start();
+    m_timing.start();
+    m_responseTimer.start(TRANSCRIPTION_STALL_TIMEOUT_MS);
+    if (secure) {
+        // Resume the previous upload's TLS session to skip a full handshake
+        QSslConfiguration sslConfiguration = m_socket->sslConfiguration();
+        sslConfiguration.setSslOption(QSsl::SslOptionDisableSessionPersistence, false);
+        if (m_sessionHost == url.host() && !m_sessionTicket.isEmpty()) {
+            sslConfiguration.setSessionTicket(m_sessionTicket);
+        }
+        m_socket->setSslConfiguration(sslConfiguration);
+        connect(m_socket, &QSslSocket::encrypted, this, [this]() { m_timing.mark(m_timing.secureUs); });
+        connect(m_socket, &QSslSocket::encrypted, this, &StreamingUpload::onConnected);
+        m_socket->connectToHostEncrypted(url.host(), static_cast<quint16>(url.port(defaultPort)));
+    } else {
+        connect(m_socket, &QSslSocket::connected, this, &StreamingUpload::onConnected);
+        m_socket->connectToHost(url.host(), static_cast<quint16>(url.port(defaultPort)));
+    }
+}
+
+void StreamingUpload::abort()
+{
+    reset();
+}
+
+void StreamingUpload::reset()
+{
+    m_pumpTimer.stop();
+    m_responseTimer.stop();
+    m_state = State::Idle;
+    if (m_socket) {
+        // TLS 1.3 tickets arrive after the handshake, so pick the session up last
+        if (m_socket->isEncrypted()) {
+            const QByteArray ticket = m_socket->sslConfiguration().sessionTicket();
+            if (!ticket.isEmpty()) {
+                m_sessionTicket = ticket;
+                m_sessionHost = m_url.host();
+            }
+        }
+        m_socket->disconnect(this);
+        m_socket->abort();
+        m_socket->deleteLater();
+        m_socket = nullptr;
+    }
+    m_audio.reset();
+}
+
+void StreamingUpload::onConnected()
+{
+    if (m_state != State::Connecting) {
+        return;
+    }
+
+    qDebug() << "Streaming upload connected to" << m_url.host() << "after" << m_elapsed.elapsed() << "ms";
+    m_responseTimer.stop();
+    m_lastProgress.start();
+    m_socket->write(m_requestHead);
+    m_timing.mark(m_timing.firstBodyByteUs);
+    m_state = State::SendingBody;
+    m_pumpTimer.start();
+    pump();
+}
+
+void StreamingUpload::writeChunk(const char* data, qint64 length)
+{
+    m_socket->write(QByteArray::number(length, 16) + "\r\n");
+    m_socket->write(data, length);
+    m_socket->write("\r\n", 2);
+}
+
+void StreamingUpload::pump()
+{
+    if (m_state != State::SendingBody) {
+        return;
+    }
+
+    // Audio only trickles in while recording, so only data that is queued
+    // and not moving counts as a stall
+    if (m_socket->bytesToWrite() > 0 && m_lastProgress.elapsed() > TRANSCRIPTION_STALL_TIMEOUT_MS) {
+        fail(QString("Network error: upload stalled, nothing sent for %1 s").arg(TRANSCRIPTION_STALL_TIMEOUT_MS / 1000),
+             QNetworkReply::TimeoutError);
+        return;
+    }
+
+    // Keep the socket buffer short so a slow link doesn't pile up memory here;
+    // the arena already holds everything not yet sent
+    qint64 queued = 0;
+    while (m_socket->bytesToWrite() < STREAM_UPLOAD_MAX_QUEUED_BYTES) {
+        qint64 length = 0;
+        const char* data = m_audio->span(m_audioSent, &length);
+        if (!data) {
+            break;
+        }
+        writeChunk(data, length);
+        m_audioSent += length;
+        queued += length;
+    }
+
+    const bool recordingFinished = m_audio->isFinished();
+    if (queued > 0) {
+        emit uploadProgress(m_audioSent, recordingFinished);
+    }
+
+    // Check completion against a size read after isFinished(), so the tail
+    // appended just before finish() is never skipped
+    if (recordingFinished && m_audioSent == m_audio->size()) {
+        writeChunk(m_epilogue.constData(), m_epilogue.size());
+        m_socket->write("0\r\n\r\n", 5);
+        m_state = State::WaitingForResponse;
+        m_pumpTimer.stop();
+        m_responseTimer.start(TRANSCRIPTION_RESPONSE_TIMEOUT_MS);
+        qDebug() << "Streaming upload sent" << m_audioSent << "audio bytes in" << m_elapsed.elapsed() << "ms";
+        m_timing.payloadBytes = m_audioSent;
+        m_timing.mark(m_timing.bodySentUs);
+        emit bodySent();
+    }
+}
+
+void StreamingUpload::onReadyRead()
+{
+    if (m_state == State::WaitingForResponse) {
+        m_timing.mark(m_timing.firstByteUs);
+        // Once the response has started, a pause in it is a stall
+        m_responseTimer.start(TRANSCRIPTION_STALL_TIMEOUT_MS);
+    }
+    m_response += m_socket->readAll();
+    parseResponse(false);
+}
+
+void StreamingUpload::onDisconnected()
+{
+    if (m_state == State::Idle) {
+        return;
+    }
+    if (!parseResponse(true)) {
+        fail("Network error: connection closed before a complete response arrived",
+             QNetworkReply::RemoteHostClosedError);
+    }
+}
+
+void StreamingUpload::onSocketError()
+{
+    if (m_state == State::Idle || !m_socket) {
+        return;
+    }
+    // The server closing after its response is not an error
+    if (m_socket->error() == QAbstractSocket::RemoteHostClosedError && parseResponse(true)) {
+        return;
+    }
+    fail(QString("Network error: %1").arg(m_socket->errorString()), replyErrorFor(m_socket->error()));
+}
+
+bool StreamingUpload::parseResponse(bool connectionClosed)
+{
+    if (m_state == State::Idle) {
+        return true;
+    }
+
+    const int headerEnd = m_response.indexOf("\r\n\r\n");
+    if (headerEnd < 0) {
+        return false;
+    }
+
+    const QList<QByteArray> lines = m_response.left(headerEnd).split('\n');
+    const QList<QByteArray> statusLine = lines.first().trimmed().split(' ');
+    const int status = statusLine.size() >= 2 ? statusLine.at(1).toInt() : 0;
+    if (status == 100) {
+        // Interim response; the real one follows
+        m_response.remove(0, headerEnd + 4);
+        return parseResponse(connectionClosed);
+    }
+
+    qint64 contentLength = -1;
+    bool chunked = false;
+    for (int i = 1; i < lines.size(); ++i) {
+        const QByteArray line = lines.at(i).trimmed();
+        const int colon = line.indexOf(':');
+        if (colon < 0) {
+            continue;
+        }
+        const QByteArray name = line.left(colon).trimmed().toLower();
+        const QByteArray value = line.mid(colon + 1).trimmed();
+        if (name == "content-length") {
+            contentLength = value.toLongLong();
+        } else if (name == "transfer-encoding" && value.toLower().contains("chunked")) {
+            chunked = true;
+        } else if (name == SERVER_PROCESSING_HEADER) {
+            m_timing.serverProcessingMs = value.toLongLong();
+        } else if (name == "retry-after") {
+            m_retryAfter = value;
+        }
+    }
+
+    const QByteArray raw = m_response.mid(headerEnd + 4);
+    if (chunked) {
+        QByteArray body;
+        bool ok = true;
+        if (!decodeChunkedBody(raw, &body, &ok)) {
+            return false;
+        }
+        if (!ok) {
+            fail("Network error: malformed chunked response", QNetworkReply::ProtocolFailure);
+            return true;
+        }
+        complete(status, body);
+        return true;
+    }
+    if (contentLength >= 0) {
+        if (raw.size() < contentLength) {
+            return false;
+        }
+        complete(status, raw.left(static_cast<int>(contentLength)));
+        return true;
+    }
+    if (connectionClosed) {
+        complete(status, raw);
+        return true;
+    }
+    return false;
+}
+
+void StreamingUpload::complete(int httpStatus, const QByteArray& body)
+{
+    qDebug() << "Streaming upload got HTTP" << httpStatus << "after" << m_elapsed.elapsed() << "ms";
+    m_timing.httpStatus = httpStatus;
+    m_timing.succeeded = httpStatus >= 200 && httpStatus < 300;
+    m_timing.mark(m_timing.finishedUs);
+    reset();
+    emit finished(httpStatus, body);
+}
+
+void StreamingUpload::fail(const QString& error, QNetworkReply::NetworkError code)
+{
+    qWarning() << "Streaming upload failed:" << error;
+    m_timing.mark(m_timing.finishedUs);
+    reset();
+    emit failed(error, code);
+}
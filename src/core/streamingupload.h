@@ -0,0 +1,94 @@
+#ifndef STREAMINGUPLOAD_H
+#define STREAMINGUPLOAD_H
+
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QList>
+#include <QNetworkReply>
+#include <QObject>
+#include <QPair>
+#include <QSharedPointer>
+#include <QSslSocket>
+#include <QTimer>
+#include <QUrl>
+
+#include "chunkedarena.h"
+#include "requeststats.h"
+
+// multipart/form-data POST whose file part is streamed from a ChunkedArena
+// while it is still being written, using HTTP/1.1 chunked transfer encoding.
+// QNetworkAccessManager in Qt 5 cannot send a request body of unknown length
+// without buffering it first, so this talks HTTP over a QSslSocket directly.
+class StreamingUpload : public QObject
+{
+    Q_OBJECT
+public:
+    using HeaderList = QList<QPair<QByteArray, QByteArray>>;
+
+    explicit StreamingUpload(QObject* parent = nullptr);
+    ~StreamingUpload() override;
+
+    // Connect and start sending. `fields` become plain form fields ahead of the
+    // file part; the file part ends once `audio` is finished and fully sent.
+    void start(const QUrl& url,
+               const HeaderList& headers,
+               const HeaderList& fields,
+               const QString& filename,
+               QSharedPointer<const ChunkedArena> audio);
+
+    void abort();
+    bool isRunning() const { return m_state != State::Idle; }
+
+    // Audio bytes handed to the socket so far
+    qint64 audioBytesSent() const { return m_audioSent; }
+
+    // Phase timings of the current or last request
+    const RequestTiming& timing() const { return m_timing; }
+
+    // Retry-After header of the last response, empty if there was none
+    QByteArray retryAfter() const { return m_retryAfter; }
+
+signals:
+    // `recordingFinished` is true once the arena is complete, i.e. only the tail is left
+    void uploadProgress(qint64 audioBytesSent, bool recordingFinished);
+    void bodySent();
+    void finished(int httpStatus, const QByteArray& body);
+    // Without a response; `code` as a QNetworkReply would report it
+    void failed(const QString& error, QNetworkReply::NetworkError code);
+
+private slots:
+    void onConnected();
+    void onReadyRead();
+    void onDisconnected();
+    void onSocketError();
+    void pump();
+
+private:
+    enum class State { Idle, Connecting, SendingBody, WaitingForResponse };
+
+    void writeChunk(const char* data, qint64 length);
+    bool parseResponse(bool connectionClosed);
+    void complete(int httpStatus, const QByteArray& body);
+    void fail(const QString& error, QNetworkReply::NetworkError code);
+    void reset();
+
+private:
+    QSslSocket*                        m_socket;
+    QTimer                             m_pumpTimer;
+    QTimer                             m_responseTimer;
+    State                              m_state;
+    QUrl                               m_url;
+    QByteArray                         m_requestHead;   // Request line, headers and multipart preamble
+    QByteArray                         m_epilogue;      // Closing multipart boundary
+    QSharedPointer<const ChunkedArena> m_audio;
+    qint64                             m_audioSent;
+    QByteArray                         m_response;
+    QElapsedTimer                      m_elapsed;
+    QElapsedTimer                      m_lastProgress;  // Since the socket last wrote anything
+    QByteArray                         m_retryAfter;
+    RequestTiming                      m_timing;
+    QByteArray                         m_sessionTicket;     // TLS session of the last upload, resumed by the next
+    QString                            m_sessionHost;
+};
+
+#endif // STREAMINGUPLOAD_H
@@ -0,0 +1,206 @@
+#include "tracer.h"
+
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDebug>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <chrono>
+
+#include "config/config.h"
+
+namespace {
+
+std::atomic<int> g_nextThreadId{1};
+thread_local int t_threadId = 0;
+
+QByteArray jsonString(const QString& text)
+{
+    // QJsonDocument does the escaping; strip the array brackets around it
+    const QByteArray array = QJsonDocument(QJsonArray{text}).toJson(QJsonDocument::Compact);
+    return array.mid(1, array.size() - 2);
+}
+
+} // namespace
+
+Tracer& Tracer::instance()
+{
+    static Tracer tracer;
+    return tracer;
+}
+
+Tracer::Tracer()
+    : m_enabled(false),
+      m_sessionActive(false),
+      m_overflowWarned(false)
+{
+}
+
+void Tracer::enable(const QString& basePath)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_basePath = basePath;
+    m_events.reserve(TRACE_MAX_EVENTS);
+    m_enabled.store(true, std::memory_order_relaxed);
+}
+
+qint64 Tracer::nowUs()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+int Tracer::currentThreadId()
+{
+    if (t_threadId == 0) {
+        t_threadId = g_nextThreadId.fetch_add(1, std::memory_order_relaxed);
+    }
+    return t_threadId;
+}
+
+void Tracer::setThreadName(const char* name)
+{
+    if (!isEnabled()) {
+        return;
+    }
+    const int threadId = currentThreadId();
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_threadNames.size() <= threadId) {
+        m_threadNames.resize(threadId + 1);
+    }
+    m_threadNames[threadId] = QString::fromLatin1(name);
+}
+
+void Tracer::beginSession()
+{
+    if (!isEnabled()) {
+        return;
+    }
+    endSession();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_events.clear();
+    m_overflowWarned = false;
+    m_sessionActive.store(true, std::memory_order_relaxed);
+}
+
+void Tracer::endSession()
+{
+    if (!isEnabled() || !m_sessionActive.load(std::memory_order_relaxed)) {
+        return;
+    }
+
+    QVector<Event> events;
+    QVector<QString> threadNames;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_sessionActive.store(false, std::memory_order_relaxed);
+        events.swap(m_events);
+        m_events.reserve(TRACE_MAX_EVENTS);
+        threadNames = m_threadNames;
+    }
+
+    const QString path = QString("%1_%2.json").arg(m_basePath, QDateTime::currentDateTime().toString("yyyyMMdd-HHmmss-zzz"));
+    if (writeSession(events, threadNames, path)) {
+        qInfo() << "Trace with" << events.size() << "events written to" << path;
+    }
+}
+
+void Tracer::complete(const char* name, const char* category, qint64 startUs, qint64 durationUs, const QString& detail)
+{
+    if (isEnabled()) {
+        record({name, category, 'X', startUs, durationUs, 0, currentThreadId(), detail});
+    }
+}
+
+void Tracer::instant(const char* name, const char* category, const QString& detail)
+{
+    if (isEnabled()) {
+        record({name, category, 'i', nowUs(), 0, 0, currentThreadId(), detail});
+    }
+}
+
+void Tracer::asyncBegin(const char* name, const char* category, quint64 id, const QString& detail)
+{
+    if (isEnabled()) {
+        record({name, category, 'b', nowUs(), 0, id, currentThreadId(), detail});
+    }
+}
+
+void Tracer::asyncEnd(const char* name, const char* category, quint64 id)
+{
+    if (isEnabled()) {
+        record({name, category, 'e', nowUs(), 0, id, currentThreadId(), QString()});
+    }
+}
+
+void Tracer::record(Event&& event)
+{
+    if (!m_sessionActive.load(std::memory_order_relaxed)) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_events.size() >= TRACE_MAX_EVENTS) {
+        if (!m_overflowWarned) {
+            m_overflowWarned = true;
+            qWarning() << "Trace session reached" << TRACE_MAX_EVENTS << "events, dropping the rest";
+        }
+        return;
+    }
+    m_events.append(std::move(event));
+}
+
+bool Tracer::writeSession(const QVector<Event>& events, const QVector<QString>& threadNames, const QString& path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qWarning() << "Failed to write trace to" << path << ":" << file.errorString();
+        return false;
+    }
+
+    const QByteArray pid = QByteArray::number(QCoreApplication::applicationPid());
+    QByteArray out;
+    out.reserve(events.size() * 128 + 1024);
+    out += "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+
+    bool first = true;
+    auto separator = [&out, &first]() {
+        if (!first) {
+            out += ",\n";
+        }
+        first = false;
+    };
+
+    for (int threadId = 1; threadId < threadNames.size(); ++threadId) {
+        if (threadNames.at(threadId).isEmpty()) {
+            continue;
+        }
+        separator();
+        out += "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" + pid + ",\"tid\":" + QByteArray::number(threadId)
+             + ",\"args\":{\"name\":" + jsonString(threadNames.at(threadId)) + "}}";
+    }
+
+    for (const Event& event : events) {
+        separator();
+        out += "{\"name\":" + jsonString(QString::fromLatin1(event.name))
+             + ",\"cat\":\"" + event.category + "\",\"ph\":\"" + event.phase
+             + "\",\"ts\":" + QByteArray::number(event.timestampUs)
+             + ",\"pid\":" + pid + ",\"tid\":" + QByteArray::number(event.threadId);
+        if (event.phase == 'X') {
+            out += ",\"dur\":" + QByteArray::number(event.durationUs);
+        } else if (event.phase == 'i') {
+            out += ",\"s\":\"t\"";
+        } else {
+            out += ",\"id\":\"0x" + QByteArray::number(event.id, 16) + "\"";
+        }
+        if (!event.detail.isEmpty()) {
+            out += ",\"args\":{\"detail\":" + jsonString(event.detail) + "}";
+        }
+        out += "}";
+    }
+    out += "\n]}\n";
+
+    return file.write(out) == out.size();
+}
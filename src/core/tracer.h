@@ -0,0 +1,110 @@
+#ifndef TRACER_H
+#define TRACER_H
+
+#include <QString>
+#include <QVector>
+#include <QtGlobal>
+#include <atomic>
+#include <mutex>
+
+// Span tracer for the path from hotkey to paste. Events of one session
+// (SIGUSR1 until the text is delivered or the recording is dropped) are kept
+// in memory and written as a Chrome trace JSON file that chrome://tracing or
+// ui.perfetto.dev can open. While disabled every call is one relaxed load.
+//
+// Names and categories must be string literals; they are stored by pointer.
+// Never call from the audio callback: recording an event takes a mutex.
+class Tracer
+{
+public:
+    static Tracer& instance();
+
+    // Turns tracing on; each session goes to <basePath>_<timestamp>.json
+    void enable(const QString& basePath);
+    bool isEnabled() const { return m_enabled.load(std::memory_order_relaxed); }
+
+    // A session still open is written out first
+    void beginSession();
+    void endSession();
+
+    // Microseconds on the trace clock (steady)
+    static qint64 nowUs();
+
+    void complete(const char* name, const char* category, qint64 startUs, qint64 durationUs,
+                  const QString& detail = QString());
+    void instant(const char* name, const char* category, const QString& detail = QString());
+
+    // Spans that start and end in different call stacks (uploads, requests);
+    // `id` pairs the begin with its end
+    void asyncBegin(const char* name, const char* category, quint64 id, const QString& detail = QString());
+    void asyncEnd(const char* name, const char* category, quint64 id);
+
+    // Label for the calling thread in the trace viewer
+    void setThreadName(const char* name);
+
+private:
+    struct Event
+    {
+        const char* name;
+        const char* category;
+        char        phase;      // X complete, i instant, b/e async
+        qint64      timestampUs;
+        qint64      durationUs;
+        quint64     id;
+        int         threadId;
+        QString     detail;
+    };
+
+    Tracer();
+    void record(Event&& event);
+    static bool writeSession(const QVector<Event>& events, const QVector<QString>& threadNames, const QString& path);
+    static int currentThreadId();
+
+private:
+    std::atomic<bool>   m_enabled;
+    std::atomic<bool>   m_sessionActive;
+    QString             m_basePath;
+
+    std::mutex              m_mutex;
+    QVector<Event>          m_events;
+    QVector<QString>        m_threadNames;  // Indexed by thread id
+    bool                    m_overflowWarned;
+};
+
+// Times the enclosing scope as one complete event
+class TraceSpan
+{
+public:
+    TraceSpan(const char* name, const char* category)
+        : m_name(name),
+          m_category(category),
+          m_startUs(Tracer::instance().isEnabled() ? Tracer::nowUs() : -1)
+    {
+    }
+
+    ~TraceSpan()
+    {
+        if (m_startUs >= 0) {
+            Tracer::instance().complete(m_name, m_category, m_startUs, Tracer::nowUs() - m_startUs, m_detail);
+        }
+    }
+
+    // Shown in the event's args, e.g. sizes or outcomes
+    void setDetail(const QString& detail)
+    {
+        if (m_startUs >= 0) {
+            m_detail = detail;
+        }
+    }
+
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+
+private:
+    const char* m_name;
+    const char* m_category;
+    qint64      m_startUs;
+    QString     m_detail;
+};
+
+#endif // TRACER_H
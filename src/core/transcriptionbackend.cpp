@@ -0,0 +1,10 @@
+#include "transcriptionbackend.h"
+
+QStringList availableTranscriptionBackendNames()
+{
+    QStringList names{"openai"};
+#ifdef HAVE_WEBSOCKETS
+    names << "realtime";
+#endif
+    return names;
+}
@@ -0,0 +1,92 @@
+#ifndef TRANSCRIPTIONBACKEND_H
+#define TRANSCRIPTIONBACKEND_H
+
+#include <QList>
+#include <QObject>
+#include <QSharedPointer>
+#include <QString>
+#include <QStringList>
+
+#include "audioencoder.h"
+#include "chunkedarena.h"
+
+// Turns a finished recording into text. TranscriptionQueue only talks to this
+// interface, so the OpenAI upload and realtime APIs are interchangeable.
+// Every request ends in exactly one transcriptionCompleted or
+// transcriptionFailed, unless it is canceled.
+class TranscriptionBackend : public QObject
+{
+    Q_OBJECT
+public:
+    explicit TranscriptionBackend(QObject* parent = nullptr) : QObject(parent) {}
+    ~TranscriptionBackend() override = default;
+
+    // Name used on the command line and in logs ("openai", "realtime")
+    virtual QString name() const = 0;
+
+    // False when requests cannot succeed at all, e.g. no API key
+    virtual bool isAvailable() const = 0;
+
+    // Shown to the user when isAvailable() is false
+    virtual QString unavailableReason() const = 0;
+
+    // Start transcription of an in-memory recording
+    virtual void transcribeRecording(QSharedPointer<const ChunkedArena> audio, AudioFormat format,
+                                     const QString& language) = 0;
+
+    // Transcribe consecutive segments of one recording and deliver the texts
+    // joined in recording order
+    virtual void transcribeSegments(const QList<QSharedPointer<const ChunkedArena>>& segments,
+                                    AudioFormat format,
+                                    const QString& language) = 0;
+
+    // Whether streamRecording() can start before the recording has ended
+    virtual bool supportsStreaming() const { return false; }
+
+    // Start on a recording that is still in progress; the request completes
+    // on its own once `audio` is finished
+    virtual void streamRecording(QSharedPointer<const ChunkedArena> audio, AudioFormat format, const QString& language)
+    {
+        Q_UNUSED(audio);
+        Q_UNUSED(format);
+        Q_UNUSED(language);
+    }
+
+    // Whether `format` can be transcribed; the recorder is set up accordingly
+    virtual bool acceptsFormat(AudioFormat format) const
+    {
+        Q_UNUSED(format);
+        return true;
+    }
+
+    // Called when a recording starts, so setup work overlaps with speech
+    virtual void prepare() {}
+
+    // Re-read credentials from the environment before a request
+    virtual void refreshCredentials() {}
+
+    // Length of the recording being transcribed (-1 = unknown)
+    virtual void setAudioDuration(qint64 durationMs) { Q_UNUSED(durationMs); }
+
+    virtual void cancelTranscription() = 0;
+    virtual bool isTranscribing() const = 0;
+
+signals:
+    // Emitted when transcription completes successfully
+    void transcriptionCompleted(const QString& transcribedText);
+
+    // Emitted when transcription fails
+    void transcriptionFailed(const QString& errorMessage);
+
+    // Progress information
+    void transcriptionProgress(const QString& status);
+
+    // Best guess at the text so far, while the recording is still going on;
+    // replaced by each later emission and finally by transcriptionCompleted
+    void partialTranscription(const QString& text);
+};
+
+// Names accepted by --backend; "realtime" only when built with QtWebSockets
+QStringList availableTranscriptionBackendNames();
+
+#endif // TRANSCRIPTIONBACKEND_H
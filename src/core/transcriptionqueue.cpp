@@ -0,0 +1,296 @@
+#include "transcriptionqueue.h"
+
+#include <QDebug>
+#include <QTimer>
+
+#include "tracer.h"
+
+TranscriptionQueue::TranscriptionQueue(TranscriptionBackend* backend, BackendFactory factory, int maxParallelJobs,
+                                       QObject* parent)
+    : QObject(parent),
+      m_factory(std::move(factory)),
+      m_maxParallelJobs(m_factory ? qMax(1, maxParallelJobs) : 1),
+      m_nextId(1),
+      m_deliveryHeld(false)
+{
+    addBackend(backend);
+}
+
+TranscriptionBackend* TranscriptionQueue::addBackend(TranscriptionBackend* backend)
+{
+    backend->setParent(this);
+    m_backends.append(backend);
+
+    connect(backend, &TranscriptionBackend::transcriptionCompleted, this, [this, backend](const QString& text) {
+        onBackendFinished(backend, true, text);
+    });
+    connect(backend, &TranscriptionBackend::transcriptionFailed, this, [this, backend](const QString& error) {
+        onBackendFinished(backend, false, error);
+    });
+    connect(backend, &TranscriptionBackend::transcriptionProgress, this, [this, backend](const QString& status) {
+        if (const Job* job = jobOf(backend)) {
+            emit jobProgress(job->id, status);
+        }
+    });
+    connect(backend, &TranscriptionBackend::partialTranscription, this, [this, backend](const QString& text) {
+        if (const Job* job = jobOf(backend)) {
+            emit jobPartial(job->id, text);
+        }
+    });
+
+    if (m_backends.size() > 1) {
+        qInfo() << "Transcription backend instance" << m_backends.size() << "of" << m_maxParallelJobs << "created";
+    }
+    return backend;
+}
+
+void TranscriptionQueue::refreshCredentials()
+{
+    for (TranscriptionBackend* backend : m_backends) {
+        backend->refreshCredentials();
+    }
+}
+
+TranscriptionBackend* TranscriptionQueue::idleBackend()
+{
+    for (TranscriptionBackend* backend : m_backends) {
+        if (!jobOf(backend)) {
+            return backend;
+        }
+    }
+    if (m_factory && m_backends.size() < m_maxParallelJobs) {
+        if (TranscriptionBackend* backend = m_factory()) {
+            return addBackend(backend);
+        }
+        // No more instances to be had: carry on with the ones there are
+        qWarning() << "Cannot create another transcription backend, running" << m_backends.size()
+                   << "job(s) at a time";
+        m_maxParallelJobs = m_backends.size();
+    }
+    return nullptr;
+}
+
+TranscriptionBackend* TranscriptionQueue::backendFor(int id)
+{
+    // The instance that got ready for the job, if nothing took it meanwhile
+    const Job* job = findJob(id);
+    if (job && job->prepared && !jobOf(job->prepared)) {
+        return job->prepared;
+    }
+    return idleBackend();
+}
+
+TranscriptionQueue::Job* TranscriptionQueue::findJob(int id)
+{
+    for (Job& job : m_jobs) {
+        if (job.id == id) {
+            return &job;
+        }
+    }
+    return nullptr;
+}
+
+TranscriptionQueue::Job* TranscriptionQueue::jobOf(TranscriptionBackend* backend)
+{
+    for (Job& job : m_jobs) {
+        if (job.backend == backend) {
+            return &job;
+        }
+    }
+    return nullptr;
+}
+
+int TranscriptionQueue::beginJob(QSharedPointer<const ChunkedArena> audio, AudioFormat format,
+                                 const QString& language, bool stream)
+{
+    Job job;
+    job.id = m_nextId++;
+    job.audio = audio;
+    job.format = format;
+    job.language = language;
+    m_jobs.append(job);
+    const int id = job.id;
+
+    TranscriptionBackend* backend = idleBackend();
+    if (!backend) {
+        qInfo() << "Transcription job" << id << "waits for one of" << m_jobs.size() - 1 << "earlier job(s)";
+        return id;
+    }
+    if (stream && backend->supportsStreaming()) {
+        findJob(id)->backend = backend;
+        backend->refreshCredentials();
+        backend->streamRecording(audio, format, language);
+    } else {
+        findJob(id)->prepared = backend;
+        backend->prepare();
+    }
+    return id;
+}
+
+void TranscriptionQueue::submitJob(int id, const QList<QSharedPointer<const ChunkedArena>>& segments,
+                                   qint64 durationMs)
+{
+    Job* job = findJob(id);
+    if (!job || job->state != Job::State::Recording) {
+        return;
+    }
+    job->segments = segments;
+    job->durationMs = durationMs;
+
+    // A stream finishes by itself now that the recording is done
+    if (job->backend) {
+        job->state = Job::State::Running;
+        job->backend->setAudioDuration(durationMs);
+        return;
+    }
+    job->state = Job::State::Queued;
+    Tracer::instance().instant("transcription queued", "queue", QString::number(id));
+    dispatch();
+}
+
+void TranscriptionQueue::cancelJob(int id)
+{
+    for (int i = 0; i < m_jobs.size(); ++i) {
+        if (m_jobs.at(i).id != id) {
+            continue;
+        }
+        // Taken out first, so the backend's last signals find no job
+        const Job job = m_jobs.takeAt(i);
+        if (job.backend) {
+            job.backend->cancelTranscription();
+        }
+        qInfo() << "Transcription job" << id << "canceled";
+        deliverReady();
+        dispatch();
+        return;
+    }
+}
+
+void TranscriptionQueue::cancelAll()
+{
+    const QList<Job> jobs = m_jobs;
+    m_jobs.clear();
+    for (const Job& job : jobs) {
+        if (job.backend) {
+            job.backend->cancelTranscription();
+        }
+    }
+    m_lastFailed = Job();
+}
+
+int TranscriptionQueue::retryJob(int id)
+{
+    if (id < 0 || m_lastFailed.id != id) {
+        return -1;
+    }
+
+    Job job = m_lastFailed;
+    m_lastFailed = Job();
+    job.id = m_nextId++;
+    job.state = Job::State::Queued;
+    job.backend = nullptr;
+    job.prepared = nullptr;
+    job.result.clear();
+    m_jobs.append(job);
+    qInfo() << "Transcription job" << id << "retried as job" << job.id;
+
+    const int newId = job.id;
+    dispatch();
+    return newId;
+}
+
+void TranscriptionQueue::setDeliveryHeld(bool held)
+{
+    m_deliveryHeld = held;
+    if (!held) {
+        // Not from inside the caller, which is usually hiding a window
+        QTimer::singleShot(0, this, [this]() { deliverReady(); });
+    }
+}
+
+void TranscriptionQueue::onBackendFinished(TranscriptionBackend* backend, bool succeeded, const QString& result)
+{
+    Job* job = jobOf(backend);
+    if (!job) {
+        return;
+    }
+    job->backend = nullptr;
+
+    // A stream that broke while recording: the whole recording is sent once it stops
+    if (job->state == Job::State::Recording) {
+        qWarning() << "Streaming transcription of job" << job->id << "failed while recording:" << result
+                   << "- will send the recording after it stops";
+        dispatch();
+        return;
+    }
+
+    job->state = succeeded ? Job::State::Completed : Job::State::Failed;
+    job->result = result;
+    Tracer::instance().instant(succeeded ? "transcription done" : "transcription failed", "queue",
+                               QString::number(job->id));
+    deliverReady();
+    dispatch();
+}
+
+void TranscriptionQueue::dispatch()
+{
+    // By id and fresh lookups: starting a job can finish or retry others before it returns
+    while (true) {
+        int id = -1;
+        for (const Job& job : m_jobs) {
+            if (job.state == Job::State::Queued) {
+                id = job.id;
+                break;
+            }
+        }
+        if (id < 0) {
+            return;
+        }
+        TranscriptionBackend* backend = backendFor(id);
+        if (!backend) {
+            return;
+        }
+        start(id, backend);
+    }
+}
+
+void TranscriptionQueue::start(int id, TranscriptionBackend* backend)
+{
+    Job* job = findJob(id);
+    job->state = Job::State::Running;
+    job->backend = backend;
+    const QSharedPointer<const ChunkedArena> audio = job->audio;
+    const QList<QSharedPointer<const ChunkedArena>> segments = job->segments;
+    const AudioFormat format = job->format;
+    const QString language = job->language;
+    const qint64 durationMs = job->durationMs;
+
+    qInfo() << "Transcription job" << id << "started," << m_jobs.size() << "job(s) pending";
+    backend->refreshCredentials();
+    backend->setAudioDuration(durationMs);
+
+    // Long recordings were split at pauses; send the pieces side by side
+    if (segments.size() > 1) {
+        backend->transcribeSegments(segments, format, language);
+    } else {
+        backend->transcribeRecording(audio, format, language);
+    }
+}
+
+void TranscriptionQueue::deliverReady()
+{
+    while (!m_deliveryHeld && !m_jobs.isEmpty()) {
+        const Job::State state = m_jobs.first().state;
+        if (state != Job::State::Completed && state != Job::State::Failed) {
+            return;
+        }
+
+        const Job job = m_jobs.takeFirst();
+        if (state == Job::State::Completed) {
+            emit jobCompleted(job.id, job.result);
+        } else {
+            m_lastFailed = job;
+            emit jobFailed(job.id, job.result);
+        }
+    }
+}
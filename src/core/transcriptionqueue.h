@@ -0,0 +1,112 @@
+#ifndef TRANSCRIPTIONQUEUE_H
+#define TRANSCRIPTIONQUEUE_H
+
+#include <QList>
+#include <QObject>
+#include <QSharedPointer>
+#include <QString>
+#include <QVector>
+#include <functional>
+
+#include "audioencoder.h"
+#include "chunkedarena.h"
+#include "transcriptionbackend.h"
+
+// One transcription job per recording, so the next dictation can start while
+// the previous one is still being transcribed. Jobs run side by side, each on
+// a backend instance of its own, up to a fixed number at once; the rest wait
+// in recording order. Results come out in the order the recordings were made,
+// whichever finishes first, and can be held back while pasting would go to
+// the wrong window.
+//
+// A job keeps its own arenas, so neither the recorder nor the saved file of
+// the next recording can touch audio that is still being transcribed.
+class TranscriptionQueue : public QObject
+{
+    Q_OBJECT
+public:
+    using BackendFactory = std::function<TranscriptionBackend*()>;
+
+    // Takes ownership of `backend`. `factory` makes more instances like it
+    // as parallel jobs need them, up to `maxParallelJobs`; without one, or
+    // once it returns nullptr, jobs run on the instances there are.
+    TranscriptionQueue(TranscriptionBackend* backend, BackendFactory factory, int maxParallelJobs,
+                       QObject* parent = nullptr);
+
+    // Of the backend; all instances are configured alike
+    QString backendName() const { return m_backends.first()->name(); }
+    bool isAvailable() const { return m_backends.first()->isAvailable(); }
+    QString unavailableReason() const { return m_backends.first()->unavailableReason(); }
+    void refreshCredentials();
+
+    // A recording started. With `stream` and a backend that supports it and
+    // is free, it is transcribed while it is recorded; otherwise an idle
+    // backend gets ready for it. Returns the job id.
+    int beginJob(QSharedPointer<const ChunkedArena> audio, AudioFormat format, const QString& language, bool stream);
+
+    // The recording of job `id` stopped: queue it, unless a stream already
+    // has all but the end of it. `segments` as from recordedSegments().
+    void submitJob(int id, const QList<QSharedPointer<const ChunkedArena>>& segments, qint64 durationMs);
+
+    // Drop job `id` (canceled or empty recording) and stop its request
+    void cancelJob(int id);
+    void cancelAll();
+
+    // Send the audio of the last failed job again, as the newest job.
+    // Returns its new id, or -1 when `id` was not the last failure.
+    int retryJob(int id);
+
+    // While held, finished jobs wait, in order, instead of being delivered
+    void setDeliveryHeld(bool held);
+    bool isDeliveryHeld() const { return m_deliveryHeld; }
+
+    // Jobs begun but not delivered yet
+    int pendingJobs() const { return m_jobs.size(); }
+
+signals:
+    // In recording order, one of the two per job unless it was canceled
+    void jobCompleted(int id, const QString& text);
+    void jobFailed(int id, const QString& error);
+
+    // Forwarded from the job's backend as they happen
+    void jobProgress(int id, const QString& status);
+    void jobPartial(int id, const QString& text);
+
+private:
+    struct Job
+    {
+        enum class State { Recording, Queued, Running, Completed, Failed };
+
+        int        id = -1;
+        State      state = State::Recording;
+        QSharedPointer<const ChunkedArena>        audio;
+        QList<QSharedPointer<const ChunkedArena>> segments;
+        AudioFormat format = AudioFormat::Mp3;
+        QString    language;
+        qint64     durationMs = -1;
+        TranscriptionBackend* backend = nullptr;   // While streaming or running
+        TranscriptionBackend* prepared = nullptr;  // Got ready in beginJob(); preferred by dispatch()
+        QString    result;                         // Text, or the error
+    };
+
+    TranscriptionBackend* addBackend(TranscriptionBackend* backend);
+    TranscriptionBackend* idleBackend();
+    TranscriptionBackend* backendFor(int id);
+    Job* findJob(int id);
+    Job* jobOf(TranscriptionBackend* backend);
+    void onBackendFinished(TranscriptionBackend* backend, bool succeeded, const QString& result);
+    void dispatch();
+    void start(int id, TranscriptionBackend* backend);
+    void deliverReady();
+
+private:
+    QVector<TranscriptionBackend*> m_backends;
+    BackendFactory        m_factory;
+    int                   m_maxParallelJobs;
+    QList<Job>            m_jobs;           // Recording order, until delivered
+    Job                   m_lastFailed;     // Kept for retryJob(); id -1 when none
+    int                   m_nextId;
+    bool                  m_deliveryHeld;
+};
+
+#endif // TRANSCRIPTIONQUEUE_H
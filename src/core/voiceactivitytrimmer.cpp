@@ -0,0 +1,133 @@
+#include "voiceactivitytrimmer.h"
+
+#include "config/config.h"
+#include "levelmeter.h"
+
+namespace {
+
+constexpr int VAD_FRAME_MS = 20;
+
+} // namespace
+
+VoiceActivityTrimmer::VoiceActivityTrimmer(int sampleRate, int maxPauseMs)
+    : m_frameSamples(sampleRate * VAD_FRAME_MS / 1000),
+      m_hangoverFrames(VAD_HANGOVER_MS / VAD_FRAME_MS),
+      m_paddingSamples(static_cast<std::size_t>(sampleRate) * static_cast<std::size_t>(qMax(maxPauseMs, 0)) / 2000),
+      m_state(State::Leading),
+      m_pauseHeadKept(0),
+      m_hangover(0),
+      m_noiseFloor(VAD_MIN_SPEECH_RMS),
+      m_speechFrames(0),
+      m_silenceSamples(0),
+      m_inputSamples(0),
+      m_keptSamples(0)
+{
+    m_frame.reserve(static_cast<std::size_t>(m_frameSamples));
+    m_held.reserve(m_paddingSamples + static_cast<std::size_t>(m_frameSamples));
+}
+
+void VoiceActivityTrimmer::reset()
+{
+    m_state = State::Leading;
+    m_frame.clear();
+    m_held.clear();
+    m_pauseHeadKept = 0;
+    m_hangover = 0;
+    m_noiseFloor = VAD_MIN_SPEECH_RMS;
+    m_speechFrames = 0;
+    m_silenceSamples = 0;
+    m_inputSamples = 0;
+    m_keptSamples = 0;
+}
+
+void VoiceActivityTrimmer::process(const short* pcm, std::size_t count, std::vector<short>& out)
+{
+    m_inputSamples += static_cast<qint64>(count);
+
+    std::size_t position = 0;
+    while (position < count) {
+        const std::size_t take = qMin(count - position, static_cast<std::size_t>(m_frameSamples) - m_frame.size());
+        m_frame.insert(m_frame.end(), pcm + position, pcm + position + take);
+        position += take;
+
+        if (m_frame.size() == static_cast<std::size_t>(m_frameSamples)) {
+            processFrame(out);
+            m_frame.clear();
+        }
+    }
+}
+
+void VoiceActivityTrimmer::flush(std::vector<short>& out)
+{
+    // A partial frame after speech is the word's tail; otherwise it is silence
+    if (m_state == State::Speech) {
+        keep(m_frame.data(), m_frame.size(), out);
+    }
+    m_frame.clear();
+    m_held.clear();
+}
+
+bool VoiceActivityTrimmer::isSpeechFrame(float rms)
+{
+    // The floor follows quiet frames quickly and loud ones slowly, so it
+    // settles on the room noise rather than on the voice
+    if (rms < m_noiseFloor) {
+        m_noiseFloor += (rms - m_noiseFloor) * 0.2f;
+    } else {
+        m_noiseFloor += (rms - m_noiseFloor) * 0.005f;
+    }
+    return rms > VAD_MIN_SPEECH_RMS && rms > m_noiseFloor * VAD_SPEECH_TO_NOISE_RATIO;
+}
+
+void VoiceActivityTrimmer::processFrame(std::vector<short>& out)
+{
+    const float rms = measureLevel(m_frame.data(), m_frame.size()).rms;
+    const bool speech = isSpeechFrame(rms);
+
+    if (speech) {
+        ++m_speechFrames;
+        m_silenceSamples = 0;
+        m_hangover = m_hangoverFrames;
+        if (m_state != State::Speech) {
+            // The end of the pause leads into the word
+            keep(m_held.data(), m_held.size(), out);
+            m_held.clear();
+            m_state = State::Speech;
+        }
+        keep(m_frame.data(), m_frame.size(), out);
+        return;
+    }
+
+    m_silenceSamples += static_cast<qint64>(m_frame.size());
+
+    if (m_state == State::Speech) {
+        if (m_hangover > 0) {
+            --m_hangover;
+            keep(m_frame.data(), m_frame.size(), out);
+            return;
+        }
+        // The hangover already counts towards the kept head of the pause
+        m_state = State::Pause;
+        m_pauseHeadKept = static_cast<std::size_t>(m_hangoverFrames) * static_cast<std::size_t>(m_frameSamples);
+    }
+
+    // The start of a pause lets the last word ring out
+    if (m_state == State::Pause && m_pauseHeadKept < m_paddingSamples) {
+        m_pauseHeadKept += m_frame.size();
+        keep(m_frame.data(), m_frame.size(), out);
+        return;
+    }
+
+    // Hold on to the most recent silence in case speech follows; anything
+    // older is what gets trimmed
+    m_held.insert(m_held.end(), m_frame.begin(), m_frame.end());
+    if (m_held.size() > m_paddingSamples) {
+        m_held.erase(m_held.begin(), m_held.begin() + static_cast<std::ptrdiff_t>(m_held.size() - m_paddingSamples));
+    }
+}
+
+void VoiceActivityTrimmer::keep(const short* pcm, std::size_t count, std::vector<short>& out)
+{
+    out.insert(out.end(), pcm, pcm + count);
+    m_keptSamples += static_cast<qint64>(count);
+}
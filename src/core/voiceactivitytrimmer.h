@@ -0,0 +1,60 @@
+#ifndef VOICEACTIVITYTRIMMER_H
+#define VOICEACTIVITYTRIMMER_H
+
+#include <QtGlobal>
+#include <cstddef>
+#include <vector>
+
+// Energy-based voice activity detection that removes audio nobody needs to
+// upload: silence before the first word, silence after the last one, and the
+// middle of pauses longer than `maxPauseMs`. Half of the allowed pause is kept
+// on each side of speech so words are never clipped.
+//
+// Speech is a frame whose RMS is well above an adaptive noise floor (and above
+// an absolute minimum); a short hangover bridges the dips inside words.
+class VoiceActivityTrimmer
+{
+public:
+    VoiceActivityTrimmer(int sampleRate, int maxPauseMs);
+
+    // Append the samples to keep from `count` mono samples to `out`
+    void process(const short* pcm, std::size_t count, std::vector<short>& out);
+
+    // End of stream: whatever silence is still held back is dropped
+    void flush(std::vector<short>& out);
+
+    void reset();
+
+    // Totals since reset()
+    qint64 inputSamples() const { return m_inputSamples; }
+    qint64 keptSamples() const { return m_keptSamples; }
+
+    // For callers that react to speech (e.g. auto-stop)
+    bool hasSpeech() const { return m_speechFrames > 0; }
+    qint64 speechSamples() const { return m_speechFrames * m_frameSamples; }
+    qint64 silenceSamples() const { return m_silenceSamples; }
+
+private:
+    enum class State { Leading, Speech, Pause };
+
+    void processFrame(std::vector<short>& out);
+    bool isSpeechFrame(float rms);
+    void keep(const short* pcm, std::size_t count, std::vector<short>& out);
+
+private:
+    int                 m_frameSamples;
+    int                 m_hangoverFrames;
+    std::size_t         m_paddingSamples;   // Kept on each side of speech
+    State               m_state;
+    std::vector<short>  m_frame;            // Frame being filled
+    std::vector<short>  m_held;             // Most recent pause audio, may still be needed
+    std::size_t         m_pauseHeadKept;    // Pause samples passed through after speech
+    int                 m_hangover;         // Frames left before speech turns into a pause
+    float               m_noiseFloor;
+    qint64              m_speechFrames;
+    qint64              m_silenceSamples;   // Since the last speech frame
+    qint64              m_inputSamples;
+    qint64              m_keptSamples;
+};
+
+#endif // VOICEACTIVITYTRIMMER_H
@@ -0,0 +1,113 @@
+#include "wavencoder.h"
+
+#include <QtEndian>
+#include <cstring>
+
+#include "chunkedarena.h"
+
+WavEncoder::WavEncoder()
+    : m_sampleRate(0),
+      m_channels(1),
+      m_headerPending(false)
+{
+}
+
+bool WavEncoder::begin(int sampleRate, int channels)
+{
+    m_sampleRate = sampleRate;
+    m_channels = channels;
+    m_headerPending = true;
+    return true;
+}
+
+QByteArray WavEncoder::makeHeader(quint32 dataBytes) const
+{
+    QByteArray header(HeaderSize, '\0');
+    uchar* h = reinterpret_cast<uchar*>(header.data());
+    const quint16 blockAlign = static_cast<quint16>(m_channels * 2);
+
+    std::memcpy(h, "RIFF", 4);
+    qToLittleEndian<quint32>(dataBytes == 0xFFFFFFFFu ? dataBytes : dataBytes + HeaderSize - 8, h + 4);
+    std::memcpy(h + 8, "WAVE", 4);
+    std::memcpy(h + 12, "fmt ", 4);
+    qToLittleEndian<quint32>(16, h + 16);                                  // fmt chunk size
+    qToLittleEndian<quint16>(1, h + 20);                                   // PCM
+    qToLittleEndian<quint16>(static_cast<quint16>(m_channels), h + 22);
+    qToLittleEndian<quint32>(static_cast<quint32>(m_sampleRate), h + 24);
+    qToLittleEndian<quint32>(static_cast<quint32>(m_sampleRate) * blockAlign, h + 28); // byte rate
+    qToLittleEndian<quint16>(blockAlign, h + 32);
+    qToLittleEndian<quint16>(16, h + 34);                                  // bits per sample
+    std::memcpy(h + 36, "data", 4);
+    qToLittleEndian<quint32>(dataBytes, h + 40);
+    return header;
+}
+
+bool WavEncoder::encode(const short* pcm, int frames, QByteArray& out)
+{
+    if (m_headerPending) {
+        out.append(makeHeader(0xFFFFFFFFu));
+        m_headerPending = false;
+    }
+    if (frames <= 0) {
+        return true;
+    }
+
+    const int samples = frames * m_channels;
+    const int offset = out.size();
+    out.resize(offset + samples * 2);
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+    std::memcpy(out.data() + offset, pcm, static_cast<std::size_t>(samples) * 2);
+#else
+    uchar* dst = reinterpret_cast<uchar*>(out.data() + offset);
+    for (int i = 0; i < samples; ++i) {
+        qToLittleEndian<qint16>(pcm[i], dst + i * 2);
+    }
+#endif
+    return true;
+}
+
+bool WavEncoder::finish(QByteArray& out)
+{
+    // An empty recording still gets a valid header
+    return encode(nullptr, 0, out);
+}
+
+QByteArray WavEncoder::finalHeader(qint64 totalBytes) const
+{
+    const qint64 dataBytes = qBound<qint64>(0, totalBytes - HeaderSize, 0xFFFFFFFELL);
+    return makeHeader(static_cast<quint32>(dataBytes));
+}
+
+qint64 WavEncoder::readSamples(const ChunkedArena& wav, qint64 offset, std::size_t maxSamples,
+                               std::vector<short>& out)
+{
+    const qint64 size = wav.size();
+    qint64 remaining = static_cast<qint64>(maxSamples);
+
+    // Chunk by chunk, without copying the recording first
+    while (remaining > 0 && offset + 1 < size) {
+        qint64 length = 0;
+        const char* data = wav.span(offset, &length);
+        if (!data || length <= 0) {
+            break;
+        }
+        const qint64 samples = qMin(qMin(length, size - offset) / 2, remaining);
+        if (samples == 0) {
+            // A sample split across two chunks
+            char pair[2];
+            if (wav.read(offset, pair, 2) != 2) {
+                break;
+            }
+            out.push_back(qFromLittleEndian<qint16>(pair));
+            offset += 2;
+            --remaining;
+            continue;
+        }
+        for (qint64 i = 0; i < samples; ++i) {
+            out.push_back(qFromLittleEndian<qint16>(data + 2 * i));
+        }
+        offset += samples * 2;
+        remaining -= samples;
+    }
+    return offset;
+}
@@ -0,0 +1,45 @@
+#ifndef WAVENCODER_H
+#define WAVENCODER_H
+
+#include <cstddef>
+#include <vector>
+
+#include "audioencoder.h"
+
+class ChunkedArena;
+
+// Uncompressed 16-bit PCM in a RIFF/WAVE container. Costs no CPU, but the
+// upload is the largest of all formats.
+class WavEncoder : public AudioEncoder
+{
+public:
+    WavEncoder();
+
+    AudioFormat format() const override { return AudioFormat::Wav; }
+    bool begin(int sampleRate, int channels) override;
+    bool encode(const short* pcm, int frames, QByteArray& out) override;
+    bool finish(QByteArray& out) override;
+
+    // The header written by begin() carries placeholder sizes that streaming
+    // readers accept; this returns one with the real sizes
+    QByteArray finalHeader(qint64 totalBytes) const override;
+
+    static constexpr int HeaderSize = 44;
+
+    // Appends up to `maxSamples` samples of a WAV recording in `wav` to
+    // `out`, starting at byte `offset` (HeaderSize for the first sample).
+    // Reads only what is published, so it can follow a recording while it is
+    // written. Returns the offset to continue from.
+    static qint64 readSamples(const ChunkedArena& wav, qint64 offset, std::size_t maxSamples,
+                              std::vector<short>& out);
+
+private:
+    QByteArray makeHeader(quint32 dataBytes) const;
+
+private:
+    int  m_sampleRate;
+    int  m_channels;
+    bool m_headerPending;
+};
+
+#endif // WAVENCODER_H
@@ -0,0 +1,236 @@
+#include "mockrealtimesession.h"
+
+#include <QDebug>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QTimer>
+#include <QtEndian>
+#include <QtMath>
+
+namespace {
+
+constexpr int SAMPLE_RATE = 24000;          // pcm16 as the real endpoint takes it
+constexpr int VAD_FRAME_MS = 20;
+constexpr double VAD_SPEECH_RMS = 500.0;    // About -36 dBFS
+constexpr int MIN_TURN_SPEECH_MS = 200;     // Shorter blips do not start a turn
+constexpr int MIN_COMMIT_MS = 100;          // Like the API, refuse to commit less
+constexpr int SPEECH_MS_PER_WORD = 350;     // Length of the canned transcript per turn
+
+} // namespace
+
+MockRealtimeSession::MockRealtimeSession(QWebSocket* socket, int request, const MockResponsePlan& plan,
+                                         const QString& responseText, QObject* parent)
+    : QObject(parent),
+      m_socket(socket),
+      m_request(request),
+      m_plan(plan),
+      m_words(responseText.split(' ', Qt::SkipEmptyParts)),
+      m_silenceDurationMs(500)
+{
+    if (m_words.isEmpty()) {
+        m_words << "...";
+    }
+    m_since.start();
+    m_socket->setParent(this);
+    connect(m_socket, &QWebSocket::textMessageReceived, this, &MockRealtimeSession::onTextMessage);
+    connect(m_socket, &QWebSocket::disconnected, this, &MockRealtimeSession::onDisconnected);
+
+    qInfo().noquote() << QString("[mock] request %1: realtime session %2 from %3: %4")
+                             .arg(m_request)
+                             .arg(m_socket->requestUrl().toString())
+                             .arg(m_socket->peerAddress().toString())
+                             .arg(m_plan.describe());
+    sendEvent({{"type", "transcription_session.created"}, {"session", QJsonObject()}});
+}
+
+void MockRealtimeSession::onTextMessage(const QString& message)
+{
+    if (m_stalled) {
+        return;
+    }
+
+    const QJsonObject event = QJsonDocument::fromJson(message.toUtf8()).object();
+    const QString type = event.value("type").toString();
+    if (type == "input_audio_buffer.append") {
+        appendAudio(QByteArray::fromBase64(event.value("audio").toString().toLatin1()));
+    } else if (type == "input_audio_buffer.commit") {
+        commit(true);
+    } else if (type == "input_audio_buffer.clear") {
+        m_bufferSamples = 0;
+        m_turnSpeechMs = 0;
+        m_silenceRunMs = 0;
+        sendEvent({{"type", "input_audio_buffer.cleared"}});
+    } else if (type == "transcription_session.update") {
+        const QJsonObject session = event.value("session").toObject();
+        const QJsonValue turnDetection = session.value("turn_detection");
+        m_serverVad = !turnDetection.isNull();
+        m_silenceDurationMs = turnDetection.toObject().value("silence_duration_ms").toInt(m_silenceDurationMs);
+        qInfo() << "[mock]" << m_since.elapsed() << "ms: session update, turn detection"
+                << (m_serverVad ? QString("after %1 ms of silence").arg(m_silenceDurationMs) : QString("off"));
+        sendEvent({{"type", "transcription_session.updated"}, {"session", session}});
+    } else {
+        sendEvent({{"type", "error"},
+                   {"error", QJsonObject{{"type", "invalid_request_error"},
+                                         {"code", "unknown_event"},
+                                         {"message", QString("Unknown event type: %1").arg(type)}}}});
+    }
+}
+
+void MockRealtimeSession::appendAudio(const QByteArray& pcm)
+{
+    const qint64 now = m_since.elapsed();
+    if (m_firstAudioMs < 0) {
+        m_firstAudioMs = now;
+    }
+    m_lastAudioMs = now;
+    m_audioBytes += pcm.size();
+    ++m_appends;
+
+    if (m_plan.stallAfterBytes >= 0 && m_audioBytes >= m_plan.stallAfterBytes) {
+        m_stalled = true;
+        m_outcome = "stalled";
+        qInfo() << "[mock]" << now << "ms: no longer reacting after" << m_audioBytes << "audio bytes";
+        return;
+    }
+
+    const int frameSamples = SAMPLE_RATE * VAD_FRAME_MS / 1000;
+    const int samples = pcm.size() / 2;
+    for (int i = 0; i < samples; ++i) {
+        const double sample = qFromLittleEndian<qint16>(pcm.constData() + 2 * i);
+        m_frameEnergy += sample * sample;
+        ++m_bufferSamples;
+        if (++m_frameSamples < frameSamples) {
+            continue;
+        }
+
+        if (qSqrt(m_frameEnergy / m_frameSamples) >= VAD_SPEECH_RMS) {
+            m_turnSpeechMs += VAD_FRAME_MS;
+            m_silenceRunMs = 0;
+        } else if (m_turnSpeechMs > 0) {
+            m_silenceRunMs += VAD_FRAME_MS;
+        }
+        m_frameSamples = 0;
+        m_frameEnergy = 0.0;
+
+        if (m_serverVad && m_turnSpeechMs >= MIN_TURN_SPEECH_MS && m_silenceRunMs >= m_silenceDurationMs) {
+            commit(false);
+        }
+    }
+}
+
+void MockRealtimeSession::commit(bool requested)
+{
+    const qint64 bufferedMs = m_bufferSamples * 1000 / SAMPLE_RATE;
+    if (bufferedMs < MIN_COMMIT_MS) {
+        if (requested) {
+            sendEvent({{"type", "error"},
+                       {"error", QJsonObject{{"type", "invalid_request_error"},
+                                             {"code", "input_audio_buffer_commit_empty"},
+                                             {"message", QString("Error committing input audio buffer: buffer too small. "
+                                                                 "Expected at least %1ms of audio, but buffer only has "
+                                                                 "%2ms of audio.").arg(MIN_COMMIT_MS).arg(bufferedMs)}}}});
+        }
+        return;
+    }
+
+    const QString itemId = QString("item_mock_%1_%2").arg(m_request).arg(++m_items);
+    const qint64 committedMs = m_since.elapsed();
+    sendEvent({{"type", "input_audio_buffer.committed"},
+               {"previous_item_id", m_previousItemId.isEmpty() ? QJsonValue() : QJsonValue(m_previousItemId)},
+               {"item_id", itemId}});
+    qInfo().noquote() << QString("[mock] %1 ms: %2 turn %3 with %4 ms of audio, %5 ms of it speech")
+                             .arg(committedMs)
+                             .arg(requested ? QString("client committed") : QString("VAD cut"))
+                             .arg(itemId)
+                             .arg(bufferedMs)
+                             .arg(m_turnSpeechMs);
+
+    transcribeTurn(itemId, m_turnSpeechMs, committedMs);
+    m_previousItemId = itemId;
+    m_bufferSamples = 0;
+    m_turnSpeechMs = 0;
+    m_silenceRunMs = 0;
+}
+
+void MockRealtimeSession::transcribeTurn(const QString& itemId, qint64 speechMs, qint64 committedMs)
+{
+    QStringList words;
+    const int count = speechMs > 0 ? qMax<int>(1, static_cast<int>(speechMs / SPEECH_MS_PER_WORD)) : 0;
+    for (int i = 0; i < count; ++i) {
+        words << m_words.at(m_nextWord++ % m_words.size());
+    }
+
+    // Deltas spread over the plan's delay, the transcript at its end
+    const int steps = words.size() + 1;
+    for (int step = 0; step < steps; ++step) {
+        QTimer::singleShot(m_plan.delayMs * (step + 1) / steps, this, [this, itemId, words, step, committedMs]() {
+            if (m_stalled || m_socket->state() != QAbstractSocket::ConnectedState) {
+                return;
+            }
+            if (step < words.size()) {
+                sendEvent({{"type", "conversation.item.input_audio_transcription.delta"},
+                           {"item_id", itemId},
+                           {"content_index", 0},
+                           {"delta", (step > 0 ? " " : "") + words.at(step)}});
+                if (m_plan.truncate) {
+                    m_outcome = "truncated";
+                    qInfo() << "[mock]" << m_since.elapsed() << "ms: dropping the connection mid-transcript";
+                    m_socket->abort();
+                }
+                return;
+            }
+            const qint64 completedMs = m_since.elapsed();
+            m_turns.append(qMakePair(committedMs, completedMs));
+            sendEvent({{"type", "conversation.item.input_audio_transcription.completed"},
+                       {"item_id", itemId},
+                       {"content_index", 0},
+                       {"transcript", words.join(' ')}});
+            qInfo().noquote() << QString("[mock] %1 ms: transcript of %2: \"%3\"")
+                                     .arg(completedMs)
+                                     .arg(itemId, words.join(' '));
+        });
+    }
+}
+
+void MockRealtimeSession::sendEvent(const QJsonObject& event)
+{
+    m_socket->sendTextMessage(QString::fromUtf8(QJsonDocument(event).toJson(QJsonDocument::Compact)));
+}
+
+void MockRealtimeSession::onDisconnected()
+{
+    if (m_outcome.isEmpty()) {
+        m_outcome = "closed by client";
+    }
+    qInfo().noquote() << QString("[mock] request %1: realtime session ended after %2 ms, %3 audio bytes in %4 "
+                                 "appends, %5 turn(s): %6")
+                             .arg(m_request)
+                             .arg(m_since.elapsed())
+                             .arg(m_audioBytes)
+                             .arg(m_appends)
+                             .arg(m_items)
+                             .arg(m_outcome);
+    emit finished(this);
+}
+
+QJsonObject MockRealtimeSession::logEntry() const
+{
+    QJsonArray turns;
+    for (const auto& turn : m_turns) {
+        turns.append(QJsonArray{turn.first, turn.second});
+    }
+
+    QJsonObject entry;
+    entry["request"] = m_request;
+    entry["plan"] = m_plan.describe();
+    entry["realtime"] = true;
+    entry["request_line"] = "GET " + m_socket->requestUrl().toString();
+    entry["audio_bytes"] = m_audioBytes;
+    entry["appends"] = m_appends;
+    entry["first_audio_ms"] = m_firstAudioMs;
+    entry["last_audio_ms"] = m_lastAudioMs;
+    entry["turns"] = turns;
+    entry["closed_ms"] = m_since.elapsed();
+    entry["outcome"] = m_outcome;
+    return entry;
+}
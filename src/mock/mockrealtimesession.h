@@ -0,0 +1,72 @@
+#ifndef MOCKREALTIMESESSION_H
+#define MOCKREALTIMESESSION_H
+
+#include <QElapsedTimer>
+#include <QJsonObject>
+#include <QObject>
+#include <QPair>
+#include <QStringList>
+#include <QVector>
+#include <QWebSocket>
+
+#include "mocktranscriptionserver.h"
+
+// One WebSocket session of the stand-in realtime transcription endpoint.
+// Takes pcm16 appends at 24 kHz, cuts turns with a simple energy VAD after
+// the pause length the client asks for (or on an explicit commit) and
+// answers each turn with committed, word-by-word delta and completed events
+// built from the canned response text.
+//
+// Of the plan, `delay` is the time from a turn's end to its transcript,
+// `truncate` drops the connection after the first delta and `stall-after`
+// stops reacting once that many audio bytes have arrived.
+class MockRealtimeSession : public QObject
+{
+    Q_OBJECT
+public:
+    MockRealtimeSession(QWebSocket* socket, int request, const MockResponsePlan& plan, const QString& responseText,
+                        QObject* parent = nullptr);
+
+    // For the server's request log
+    QJsonObject logEntry() const;
+
+signals:
+    void finished(MockRealtimeSession* session);
+
+private slots:
+    void onTextMessage(const QString& message);
+    void onDisconnected();
+
+private:
+    void appendAudio(const QByteArray& pcm);
+    void commit(bool requested);
+    void transcribeTurn(const QString& itemId, qint64 speechMs, qint64 committedMs);
+    void sendEvent(const QJsonObject& event);
+
+private:
+    QWebSocket*      m_socket;
+    int              m_request;
+    MockResponsePlan m_plan;
+    QStringList      m_words;
+    int              m_nextWord = 0;
+    QElapsedTimer    m_since;
+    int              m_silenceDurationMs;
+    bool             m_serverVad = true;
+
+    qint64           m_audioBytes = 0;
+    int              m_appends = 0;
+    qint64           m_firstAudioMs = -1;
+    qint64           m_lastAudioMs = -1;
+    qint64           m_bufferSamples = 0;    // Appended since the last commit
+    qint64           m_turnSpeechMs = 0;
+    qint64           m_silenceRunMs = 0;
+    int              m_frameSamples = 0;     // Of the VAD frame being filled
+    double           m_frameEnergy = 0.0;
+    int              m_items = 0;
+    QString          m_previousItemId;
+    QVector<QPair<qint64, qint64>> m_turns;  // (committed ms, completed ms)
+    bool             m_stalled = false;
+    QString          m_outcome;
+};
+
+#endif // MOCKREALTIMESESSION_H
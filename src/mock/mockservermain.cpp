@@ -0,0 +1,99 @@
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDebug>
+#include <QPair>
+#include <QStringList>
+
+#include "mocktranscriptionserver.h"
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+    qSetMessagePattern("[%{time hh:mm:ss.zzz}] [%{type}] %{message}");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Local stand-in for the transcription API");
+    parser.addHelpOption();
+
+    QCommandLineOption portOption(QStringList() << "p" << "port", "Port to listen on (default: 8089).", "port", "8089");
+    parser.addOption(portOption);
+    QCommandLineOption textOption(QStringList() << "text", "Transcription text to return.", "text");
+    parser.addOption(textOption);
+    QCommandLineOption delayOption(QStringList() << "delay", "Wait <ms> after the request before answering.", "ms");
+    parser.addOption(delayOption);
+    QCommandLineOption uploadKbitOption(QStringList() << "upload-kbit", "Read uploads at no more than <n> kbit/s.", "n");
+    parser.addOption(uploadKbitOption);
+    QCommandLineOption statusOption(QStringList() << "status", "Answer with this HTTP status and an API-style error.", "code");
+    parser.addOption(statusOption);
+    QCommandLineOption retryAfterOption(QStringList() << "retry-after", "Send a Retry-After header of <s> seconds.", "s");
+    parser.addOption(retryAfterOption);
+    QCommandLineOption truncateOption(QStringList() << "truncate", "Close the connection halfway through the response body.");
+    parser.addOption(truncateOption);
+    QCommandLineOption stallOption(QStringList() << "stall", "Read the request but never answer.");
+    parser.addOption(stallOption);
+    QCommandLineOption stallAfterOption(QStringList() << "stall-after", "Stop reading the request after <bytes>.", "bytes");
+    parser.addOption(stallAfterOption);
+    QCommandLineOption scriptOption(QStringList() << "script",
+                                    "Per-request behavior, one line per request in the syntax of the options above "
+                                    "(e.g. \"delay=800 status=503 retry-after=2\"), repeated after the last line.",
+                                    "file");
+    parser.addOption(scriptOption);
+    QCommandLineOption logOption(QStringList() << "log", "Append one JSON line per request (bytes received and when) to <file>.", "file");
+    parser.addOption(logOption);
+
+    parser.process(app);
+
+    bool ok = false;
+    const int port = parser.value(portOption).toInt(&ok);
+    if (!ok || port < 0 || port > 65535) {
+        qCritical() << "Invalid port:" << parser.value(portOption);
+        return 1;
+    }
+
+    // The options form the default plan; script lines apply on top of it
+    QStringList planKeys;
+    const QList<QPair<QCommandLineOption, QString>> valueOptions = {
+        {delayOption, "delay"}, {uploadKbitOption, "upload-kbit"}, {statusOption, "status"},
+        {retryAfterOption, "retry-after"}, {stallAfterOption, "stall-after"}};
+    for (const auto& option : valueOptions) {
+        if (parser.isSet(option.first)) {
+            planKeys << option.second + "=" + parser.value(option.first);
+        }
+    }
+    if (parser.isSet(truncateOption)) {
+        planKeys << "truncate";
+    }
+    if (parser.isSet(stallOption)) {
+        planKeys << "stall";
+    }
+
+    MockTranscriptionServer server;
+    if (parser.isSet(textOption)) {
+        server.setResponseText(parser.value(textOption));
+    }
+
+    MockResponsePlan plan;
+    QString error;
+    if (!plan.parse(planKeys.join(' '), &error)) {
+        qCritical().noquote() << error;
+        return 1;
+    }
+    server.setDefaultPlan(plan);
+    if (parser.isSet(scriptOption) && !server.loadScript(parser.value(scriptOption), &error)) {
+        qCritical().noquote() << error;
+        return 1;
+    }
+    if (parser.isSet(logOption) && !server.setRequestLog(parser.value(logOption), &error)) {
+        qCritical().noquote() << error;
+        return 1;
+    }
+    if (!server.listen(QHostAddress::LocalHost, static_cast<quint16>(port))) {
+        qCritical() << "Cannot listen on port" << port << ":" << server.errorString();
+        return 1;
+    }
+
+    qInfo().noquote() << QString("Mock transcription server listening, point the app at it with:\n"
+                                 "  ./audio_recorder --api-base-url http://127.0.0.1:%1/v1")
+                             .arg(server.serverPort());
+    return app.exec();
+}
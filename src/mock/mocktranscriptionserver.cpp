@@ -0,0 +1,537 @@
+#include "mocktranscriptionserver.h"
+#ifdef HAVE_WEBSOCKETS
+#include "mockrealtimesession.h"
+#endif
+
+#include <QDebug>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QPointer>
+#include <QStringList>
+#include <QTextStream>
+
+namespace {
+
+constexpr int THROTTLE_TICK_MS = 10;
+constexpr int THROTTLED_READ_BUFFER_BYTES = 16 * 1024;  // Keeps unread upload in the client's send queue
+constexpr int MAX_REQUEST_HEAD_BYTES = 8 * 1024;        // Looked at for an Upgrade header
+
+// Bytes an upload of `kbit` kbit/s may deliver per throttle tick
+qint64 bytesPerTick(int kbit)
+{
+    return qMax<qint64>(1, static_cast<qint64>(kbit) * THROTTLE_TICK_MS / 8);
+}
+
+QByteArray reasonPhrase(int status)
+{
+    switch (status) {
+    case 200: return "OK";
+    case 400: return "Bad Request";
+    case 401: return "Unauthorized";
+    case 403: return "Forbidden";
+    case 404: return "Not Found";
+    case 408: return "Request Timeout";
+    case 413: return "Payload Too Large";
+    case 429: return "Too Many Requests";
+    case 500: return "Internal Server Error";
+    case 502: return "Bad Gateway";
+    case 503: return "Service Unavailable";
+    case 504: return "Gateway Timeout";
+    default:  return "Error";
+    }
+}
+
+bool parseNumber(const QString& key, const QString& value, qint64 minimum, qint64* number, QString* error)
+{
+    bool ok = false;
+    *number = value.toLongLong(&ok);
+    if (!ok || *number < minimum) {
+        *error = QString("Invalid value for %1: %2").arg(key, value);
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+bool MockResponsePlan::parse(const QString& line, QString* error)
+{
+    const QStringList tokens = line.split(' ', Qt::SkipEmptyParts);
+    for (const QString& token : tokens) {
+        const int equals = token.indexOf('=');
+        const QString key = (equals < 0 ? token : token.left(equals)).toLower();
+        const QString value = equals < 0 ? QString() : token.mid(equals + 1);
+        qint64 number = 0;
+
+        if (key == "ok") {
+            continue;
+        } else if (key == "truncate") {
+            truncate = true;
+        } else if (key == "stall") {
+            stall = true;
+        } else if (equals < 0) {
+            *error = QString("Unknown key or missing value: %1").arg(token);
+            return false;
+        } else if (key == "delay") {
+            if (!parseNumber(key, value, 0, &number, error)) return false;
+            delayMs = static_cast<int>(number);
+        } else if (key == "upload-kbit") {
+            if (!parseNumber(key, value, 0, &number, error)) return false;
+            uploadKbit = static_cast<int>(number);
+        } else if (key == "status") {
+            if (!parseNumber(key, value, 100, &number, error) || number > 599) {
+                *error = QString("Invalid HTTP status: %1").arg(value);
+                return false;
+            }
+            status = static_cast<int>(number);
+        } else if (key == "retry-after") {
+            if (!parseNumber(key, value, 0, &number, error)) return false;
+            retryAfterSeconds = static_cast<int>(number);
+        } else if (key == "stall-after") {
+            if (!parseNumber(key, value, 0, &number, error)) return false;
+            stallAfterBytes = number;
+        } else {
+            *error = QString("Unknown key: %1").arg(key);
+            return false;
+        }
+    }
+    return true;
+}
+
+QString MockResponsePlan::describe() const
+{
+    QStringList parts;
+    parts << QString("status=%1").arg(status);
+    if (delayMs > 0) parts << QString("delay=%1").arg(delayMs);
+    if (uploadKbit > 0) parts << QString("upload-kbit=%1").arg(uploadKbit);
+    if (retryAfterSeconds >= 0) parts << QString("retry-after=%1").arg(retryAfterSeconds);
+    if (truncate) parts << "truncate";
+    if (stall) parts << "stall";
+    if (stallAfterBytes >= 0) parts << QString("stall-after=%1").arg(stallAfterBytes);
+    return parts.join(' ');
+}
+
+MockTranscriptionServer::MockTranscriptionServer(QObject* parent)
+    : QObject(parent),
+      m_responseText("Hello world.")
+#ifdef HAVE_WEBSOCKETS
+      , m_realtimeServer("voice_input_mock_server", QWebSocketServer::NonSecureMode)
+#endif
+{
+    connect(&m_server, &QTcpServer::newConnection, this, &MockTranscriptionServer::onNewConnection);
+#ifdef HAVE_WEBSOCKETS
+    connect(&m_realtimeServer, &QWebSocketServer::newConnection, this, &MockTranscriptionServer::onRealtimeConnection);
+#endif
+    m_throttleTimer.setInterval(THROTTLE_TICK_MS);
+    m_throttleTimer.setTimerType(Qt::PreciseTimer);
+    connect(&m_throttleTimer, &QTimer::timeout, this, &MockTranscriptionServer::onThrottleTick);
+}
+
+bool MockTranscriptionServer::listen(const QHostAddress& address, quint16 port)
+{
+    return m_server.listen(address, port);
+}
+
+bool MockTranscriptionServer::loadScript(const QString& path, QString* error)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        *error = QString("Cannot read %1: %2").arg(path, file.errorString());
+        return false;
+    }
+
+    QList<MockResponsePlan> script;
+    QTextStream stream(&file);
+    int lineNumber = 0;
+    while (!stream.atEnd()) {
+        const QString line = stream.readLine().trimmed();
+        ++lineNumber;
+        if (line.isEmpty() || line.startsWith('#')) {
+            continue;
+        }
+        MockResponsePlan plan = m_defaultPlan;
+        QString lineError;
+        if (!plan.parse(line, &lineError)) {
+            *error = QString("%1:%2: %3").arg(path).arg(lineNumber).arg(lineError);
+            return false;
+        }
+        script.append(plan);
+    }
+    if (script.isEmpty()) {
+        *error = QString("%1 has no requests").arg(path);
+        return false;
+    }
+    m_script = script;
+    return true;
+}
+
+bool MockTranscriptionServer::setRequestLog(const QString& path, QString* error)
+{
+    m_requestLog.close();
+    m_requestLog.setFileName(path);
+    if (!m_requestLog.open(QIODevice::WriteOnly | QIODevice::Append)) {
+        *error = QString("Cannot write %1: %2").arg(path, m_requestLog.errorString());
+        return false;
+    }
+    return true;
+}
+
+MockResponsePlan MockTranscriptionServer::nextPlan()
+{
+    const int index = m_requestCount++;
+    return m_script.isEmpty() ? m_defaultPlan : m_script.at(index % m_script.size());
+}
+
+void MockTranscriptionServer::onNewConnection()
+{
+    while (QTcpSocket* socket = m_server.nextPendingConnection()) {
+        Connection& connection = m_connections[socket];
+        connection.plan = nextPlan();
+        connection.request = m_requestCount;
+        connection.since.start();
+        qInfo().noquote() << QString("[mock] request %1 from %2: %3")
+                                 .arg(connection.request)
+                                 .arg(socket->peerAddress().toString())
+                                 .arg(connection.plan.describe());
+
+        // Leave unread upload bytes in the kernel so the client feels the
+        // throttle or the stall instead of filling our buffer at full speed
+        if (connection.plan.uploadKbit > 0 || connection.plan.stallAfterBytes >= 0) {
+            const qint64 bufferBytes = connection.plan.uploadKbit > 0
+                                           ? qMax<qint64>(THROTTLED_READ_BUFFER_BYTES, 2 * bytesPerTick(connection.plan.uploadKbit))
+                                           : THROTTLED_READ_BUFFER_BYTES;
+            socket->setReadBufferSize(bufferBytes);
+            socket->setSocketOption(QAbstractSocket::ReceiveBufferSizeSocketOption, static_cast<int>(bufferBytes));
+        }
+        if (connection.plan.uploadKbit > 0 && !m_throttleTimer.isActive()) {
+            m_throttleTimer.start();
+        }
+
+        connect(socket, &QTcpSocket::readyRead, this, [this, socket]() { onReadyRead(socket); });
+        connect(socket, &QTcpSocket::disconnected, this, [this, socket]() {
+            Connection connection = m_connections.take(socket);
+            if (!connection.responded && connection.outcome.isEmpty()) {
+                qWarning() << "[mock] client disconnected after" << connection.bodyBytes
+                           << "body bytes without completing the request";
+                connection.outcome = "client disconnected";
+            }
+            logRequest(connection);
+            socket->deleteLater();
+        });
+    }
+}
+
+void MockTranscriptionServer::onThrottleTick()
+{
+    bool throttled = false;
+    for (auto it = m_connections.begin(); it != m_connections.end(); ++it) {
+        Connection& connection = it.value();
+        if (!connection.protocolChecked || connection.plan.uploadKbit <= 0 || connection.completeMs >= 0) {
+            continue;
+        }
+        throttled = true;
+        const qint64 tick = bytesPerTick(connection.plan.uploadKbit);
+        connection.allowance = qMin(connection.allowance + tick, 2 * tick);
+        readInput(it.key(), connection);
+    }
+    if (!throttled) {
+        m_throttleTimer.stop();
+    }
+}
+
+void MockTranscriptionServer::onReadyRead(QTcpSocket* socket)
+{
+    auto it = m_connections.find(socket);
+    if (it == m_connections.end()) {
+        return;
+    }
+    if (!it.value().protocolChecked && !checkProtocol(socket, it.value())) {
+        return;
+    }
+    readInput(socket, it.value());
+}
+
+bool MockTranscriptionServer::checkProtocol(QTcpSocket* socket, Connection& connection)
+{
+    // Only peeked, so an HTTP request is still read (and throttled) as usual
+    const QByteArray head = socket->peek(MAX_REQUEST_HEAD_BYTES);
+    const int headerEnd = head.indexOf("\r\n\r\n");
+    if (headerEnd < 0 && head.size() < MAX_REQUEST_HEAD_BYTES) {
+        return false;
+    }
+
+    // Error and stall plans go through the plain HTTP path, which fails or
+    // hangs the handshake the way a real gateway would
+#ifdef HAVE_WEBSOCKETS
+    const bool upgrade = head.left(headerEnd).toLower().contains("upgrade: websocket");
+#else
+    // Without QtWebSockets a handshake gets a plain HTTP answer, and fails
+    const bool upgrade = false;
+#endif
+    if (!upgrade || connection.plan.status != 200 || connection.plan.stall) {
+        connection.protocolChecked = true;
+        return true;
+    }
+
+#ifdef HAVE_WEBSOCKETS
+    m_pendingUpgrades.enqueue(qMakePair(connection.request, connection.plan));
+    m_connections.remove(socket);
+    socket->disconnect(this);
+    m_realtimeServer.handleConnection(socket);
+#endif
+    return false;
+}
+
+#ifdef HAVE_WEBSOCKETS
+void MockTranscriptionServer::onRealtimeConnection()
+{
+    while (QWebSocket* socket = m_realtimeServer.nextPendingConnection()) {
+        if (m_pendingUpgrades.isEmpty()) {
+            socket->deleteLater();
+            continue;
+        }
+        const QPair<int, MockResponsePlan> pending = m_pendingUpgrades.dequeue();
+        auto* session = new MockRealtimeSession(socket, pending.first, pending.second, m_responseText, this);
+        connect(session, &MockRealtimeSession::finished, this, &MockTranscriptionServer::onRealtimeFinished);
+    }
+}
+
+void MockTranscriptionServer::onRealtimeFinished(MockRealtimeSession* session)
+{
+    writeLogEntry(session->logEntry());
+    session->deleteLater();
+}
+#endif
+
+void MockTranscriptionServer::readInput(QTcpSocket* socket, Connection& connection)
+{
+    const MockResponsePlan& plan = connection.plan;
+    qint64 limit = socket->bytesAvailable();
+    if (plan.uploadKbit > 0) {
+        limit = qMin(limit, connection.allowance);
+    }
+    if (plan.stallAfterBytes >= 0) {
+        limit = qMin(limit, plan.stallAfterBytes - connection.receivedBytes);
+        if (limit <= 0 && !connection.uploadStalled) {
+            connection.uploadStalled = true;
+            connection.outcome = "upload stalled";
+            qInfo() << "[mock]" << connection.since.elapsed() << "ms: no longer reading the request after"
+                    << connection.receivedBytes << "bytes";
+        }
+    }
+    if (limit <= 0) {
+        return;
+    }
+
+    const QByteArray data = socket->read(limit);
+    if (data.isEmpty()) {
+        return;
+    }
+    if (plan.uploadKbit > 0) {
+        connection.allowance -= data.size();
+    }
+    connection.receivedBytes += data.size();
+    connection.reads.append(qMakePair(connection.since.elapsed(), static_cast<qint64>(data.size())));
+    connection.buffer += data;
+
+    if (!connection.headersParsed && !parseHeaders(connection)) {
+        return;
+    }
+
+    const qint64 before = connection.bodyBytes;
+    const bool complete = consumeBody(connection);
+    if (connection.bodyBytes > before) {
+        const qint64 now = connection.since.elapsed();
+        if (connection.firstBodyByteMs < 0) {
+            connection.firstBodyByteMs = now;
+        }
+        connection.lastBodyByteMs = now;
+        qDebug() << "[mock]" << now << "ms: +" << connection.bodyBytes - before
+                 << "bytes, body so far" << connection.bodyBytes;
+    }
+
+    if (complete && connection.completeMs < 0) {
+        onRequestComplete(socket, connection);
+    }
+}
+
+bool MockTranscriptionServer::parseHeaders(Connection& connection)
+{
+    const int headerEnd = connection.buffer.indexOf("\r\n\r\n");
+    if (headerEnd < 0) {
+        return false;
+    }
+
+    const QList<QByteArray> lines = connection.buffer.left(headerEnd).split('\n');
+    connection.requestLine = lines.first().trimmed();
+    for (int i = 1; i < lines.size(); ++i) {
+        const QByteArray line = lines.at(i).trimmed();
+        const int colon = line.indexOf(':');
+        if (colon < 0) {
+            continue;
+        }
+        const QByteArray name = line.left(colon).trimmed().toLower();
+        const QByteArray value = line.mid(colon + 1).trimmed();
+        if (name == "content-length") {
+            connection.contentLength = value.toLongLong();
+        } else if (name == "transfer-encoding" && value.toLower().contains("chunked")) {
+            connection.chunked = true;
+        }
+    }
+
+    connection.buffer.remove(0, headerEnd + 4);
+    connection.headersParsed = true;
+    qInfo() << "[mock]" << connection.since.elapsed() << "ms:" << connection.requestLine
+            << (connection.chunked ? QString("(chunked body)") : QString("(%1 byte body)").arg(connection.contentLength));
+    return true;
+}
+
+bool MockTranscriptionServer::consumeBody(Connection& connection)
+{
+    if (!connection.chunked) {
+        connection.bodyBytes += connection.buffer.size();
+        connection.buffer.clear();
+        return connection.bodyBytes >= connection.contentLength;
+    }
+
+    // Body bytes are counted and dropped; only the framing matters here
+    while (true) {
+        const int lineEnd = connection.buffer.indexOf("\r\n");
+        if (lineEnd < 0) {
+            return false;
+        }
+        bool ok = false;
+        const int size = connection.buffer.left(lineEnd).split(';').first().trimmed().toInt(&ok, 16);
+        if (!ok) {
+            qWarning() << "[mock] malformed chunk header:" << connection.buffer.left(lineEnd);
+            return true;
+        }
+        if (size == 0) {
+            // Last chunk, then the final CRLF (no trailers expected)
+            return connection.buffer.indexOf("\r\n", lineEnd + 2) >= 0;
+        }
+        if (connection.buffer.size() < lineEnd + 2 + size + 2) {
+            return false;
+        }
+        connection.bodyBytes += size;
+        connection.buffer.remove(0, lineEnd + 2 + size + 2);
+    }
+}
+
+void MockTranscriptionServer::onRequestComplete(QTcpSocket* socket, Connection& connection)
+{
+    connection.completeMs = connection.since.elapsed();
+
+    // With a streamed upload the body is spread over the whole recording and
+    // the last byte arrives right before the response
+    qInfo().noquote() << QString("[mock] %1 body bytes in %2 reads: first byte at %3 ms, last at %4 ms, "
+                                 "spread over %5 ms; request complete at %6 ms")
+                             .arg(connection.bodyBytes)
+                             .arg(connection.reads.size())
+                             .arg(connection.firstBodyByteMs)
+                             .arg(connection.lastBodyByteMs)
+                             .arg(connection.lastBodyByteMs - connection.firstBodyByteMs)
+                             .arg(connection.completeMs);
+
+    if (connection.plan.stall) {
+        connection.outcome = "stalled";
+        qInfo() << "[mock] stalling: the request will not be answered";
+        return;
+    }
+    if (connection.plan.delayMs <= 0) {
+        respond(socket, connection);
+        return;
+    }
+
+    QPointer<QTcpSocket> guard(socket);
+    QTimer::singleShot(connection.plan.delayMs, this, [this, guard]() {
+        if (!guard) {
+            return;
+        }
+        auto it = m_connections.find(guard.data());
+        if (it != m_connections.end() && !it.value().responded) {
+            respond(guard.data(), it.value());
+        }
+    });
+}
+
+void MockTranscriptionServer::respond(QTcpSocket* socket, Connection& connection)
+{
+    connection.responded = true;
+    connection.respondedMs = connection.since.elapsed();
+    const MockResponsePlan& plan = connection.plan;
+
+    QJsonObject response;
+    if (plan.status == 200) {
+        response["text"] = m_responseText;
+    } else {
+        // Same shape as the API's error responses
+        QJsonObject error;
+        error["message"] = QString("Mock server failure (HTTP %1)").arg(plan.status);
+        error["type"] = plan.status >= 500 ? "server_error" : "invalid_request_error";
+        error["param"] = QJsonValue();
+        error["code"] = QJsonValue();
+        response["error"] = error;
+    }
+    const QByteArray body = QJsonDocument(response).toJson(QJsonDocument::Compact);
+
+    QByteArray head = "HTTP/1.1 " + QByteArray::number(plan.status) + " " + reasonPhrase(plan.status) + "\r\n"
+                      "Content-Type: application/json\r\n"
+                      "Content-Length: " + QByteArray::number(body.size()) + "\r\n"
+                      "openai-processing-ms: " + QByteArray::number(plan.delayMs) + "\r\n";
+    if (plan.retryAfterSeconds >= 0) {
+        head += "Retry-After: " + QByteArray::number(plan.retryAfterSeconds) + "\r\n";
+    }
+    head += "Connection: close\r\n\r\n";
+
+    // A truncated response announces the full length and closes halfway through
+    const QByteArray sent = plan.truncate ? body.left(body.size() / 2) : body;
+    connection.outcome = plan.truncate ? "truncated" : "answered";
+    qInfo().noquote() << QString("[mock] %1 ms: HTTP %2, %3 of %4 body bytes%5")
+                             .arg(connection.respondedMs)
+                             .arg(plan.status)
+                             .arg(sent.size())
+                             .arg(body.size())
+                             .arg(plan.truncate ? " (truncated)" : "");
+
+    socket->write(head + sent);
+    socket->disconnectFromHost();
+}
+
+void MockTranscriptionServer::logRequest(const Connection& connection)
+{
+    if (!m_requestLog.isOpen()) {
+        return;
+    }
+
+    QJsonArray reads;
+    for (const auto& read : connection.reads) {
+        reads.append(QJsonArray{read.first, read.second});
+    }
+
+    QJsonObject entry;
+    entry["request"] = connection.request;
+    entry["plan"] = connection.plan.describe();
+    entry["request_line"] = QString::fromLatin1(connection.requestLine);
+    entry["chunked"] = connection.chunked;
+    entry["received_bytes"] = connection.receivedBytes;
+    entry["body_bytes"] = connection.bodyBytes;
+    entry["first_body_byte_ms"] = connection.firstBodyByteMs;
+    entry["last_body_byte_ms"] = connection.lastBodyByteMs;
+    entry["complete_ms"] = connection.completeMs;
+    entry["responded_ms"] = connection.respondedMs;
+    entry["closed_ms"] = connection.since.elapsed();
+    entry["outcome"] = connection.outcome;
+    entry["reads"] = reads;
+    writeLogEntry(entry);
+}
+
+void MockTranscriptionServer::writeLogEntry(const QJsonObject& entry)
+{
+    if (!m_requestLog.isOpen()) {
+        return;
+    }
+    m_requestLog.write(QJsonDocument(entry).toJson(QJsonDocument::Compact) + '\n');
+    m_requestLog.flush();
+}
@@ -0,0 +1,146 @@
+#ifndef MOCKTRANSCRIPTIONSERVER_H
+#define MOCKTRANSCRIPTIONSERVER_H
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QHash>
+#include <QHostAddress>
+#include <QJsonObject>
+#include <QList>
+#include <QObject>
+#include <QPair>
+#include <QQueue>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTimer>
+#include <QVector>
+#ifdef HAVE_WEBSOCKETS
+#include <QWebSocketServer>
+
+class MockRealtimeSession;
+#endif
+
+// How the stand-in treats one request. Parsed from a script line of
+// space-separated keys, e.g. "delay=800 upload-kbit=256 status=503 retry-after=2":
+//   ok                  answer normally (the line's defaults)
+//   delay=<ms>          wait this long after the body before answering
+//   upload-kbit=<n>     read the upload at no more than n kbit/s
+//   status=<code>       answer with this HTTP status and an API-style error body
+//   retry-after=<s>     add a Retry-After header
+//   truncate            send only half of the response body, then close
+//   stall               read the whole request but never answer
+//   stall-after=<bytes> stop reading the request after this many bytes
+struct MockResponsePlan
+{
+    int    delayMs = 0;
+    int    uploadKbit = 0;          // 0 = unlimited
+    int    status = 200;
+    int    retryAfterSeconds = -1;  // -1 = no header
+    bool   truncate = false;
+    bool   stall = false;
+    qint64 stallAfterBytes = -1;    // -1 = read everything
+
+    // Applies the keys of `line` on top of this plan
+    bool parse(const QString& line, QString* error);
+    QString describe() const;
+};
+
+// Local stand-in for the transcription endpoint. Accepts multipart uploads
+// with either Content-Length or chunked bodies, logs when body bytes arrive
+// and answers with a fixed OpenAI-style JSON transcription. WebSocket
+// upgrades (the realtime endpoint) become a MockRealtimeSession on the same
+// port when built with QtWebSockets. Latency, upload bandwidth and failures can be scripted per request,
+// and every request can be recorded as a JSON line for offline benchmarks of
+// the client.
+class MockTranscriptionServer : public QObject
+{
+    Q_OBJECT
+public:
+    explicit MockTranscriptionServer(QObject* parent = nullptr);
+
+    bool listen(const QHostAddress& address, quint16 port);
+    quint16 serverPort() const { return m_server.serverPort(); }
+    QString errorString() const { return m_server.errorString(); }
+
+    void setResponseText(const QString& text) { m_responseText = text; }
+
+    // Used for every request without a script
+    void setDefaultPlan(const MockResponsePlan& plan) { m_defaultPlan = plan; }
+    MockResponsePlan defaultPlan() const { return m_defaultPlan; }
+
+    // One plan per request, in order, starting over after the last one
+    void setScript(const QList<MockResponsePlan>& script) { m_script = script; }
+
+    // Reads a script file: one plan per line on top of the default plan,
+    // blank lines and lines starting with '#' are skipped
+    bool loadScript(const QString& path, QString* error);
+
+    // Appends one JSON object per finished request to `path`
+    bool setRequestLog(const QString& path, QString* error);
+
+private slots:
+    void onNewConnection();
+    void onThrottleTick();
+#ifdef HAVE_WEBSOCKETS
+    void onRealtimeConnection();
+    void onRealtimeFinished(MockRealtimeSession* session);
+#endif
+
+private:
+    struct Connection
+    {
+        int              request = 0;   // 1-based, in order of arrival
+        MockResponsePlan plan;
+        QElapsedTimer    since;         // Started when the connection was accepted
+        QByteArray       buffer;        // Unparsed bytes
+        bool             protocolChecked = false;  // Known to be plain HTTP, not a WebSocket upgrade
+        bool             headersParsed = false;
+        bool             chunked = false;
+        qint64           contentLength = 0;
+        QByteArray       requestLine;
+        qint64           receivedBytes = 0;  // Everything read from the socket, headers and framing included
+        qint64           bodyBytes = 0;
+        qint64           firstBodyByteMs = -1;
+        qint64           lastBodyByteMs = -1;
+        qint64           completeMs = -1;    // Whole request received
+        qint64           respondedMs = -1;
+        qint64           allowance = 0;      // Bytes that may still be read in this throttle tick
+        bool             uploadStalled = false;
+        QVector<QPair<qint64, qint64>> reads; // (ms, raw bytes) per socket read
+        bool             responded = false;
+        QString          outcome;
+    };
+
+    void onReadyRead(QTcpSocket* socket);
+    // Hands a WebSocket upgrade to m_realtimeServer. True once the
+    // connection is known to be plain HTTP; false while the request head is
+    // incomplete or after the socket was handed off
+    bool checkProtocol(QTcpSocket* socket, Connection& connection);
+    // Reads what the plan allows right now and handles it
+    void readInput(QTcpSocket* socket, Connection& connection);
+    bool parseHeaders(Connection& connection);
+    // Consume body bytes from the buffer; returns true once the body is complete
+    bool consumeBody(Connection& connection);
+    void onRequestComplete(QTcpSocket* socket, Connection& connection);
+    void respond(QTcpSocket* socket, Connection& connection);
+    void logRequest(const Connection& connection);
+    void writeLogEntry(const QJsonObject& entry);
+
+    MockResponsePlan nextPlan();
+
+private:
+    QTcpServer                      m_server;
+    QHash<QTcpSocket*, Connection>  m_connections;
+    QString                         m_responseText;
+    MockResponsePlan                m_defaultPlan;
+    QList<MockResponsePlan>         m_script;
+    int                             m_requestCount = 0;
+    QTimer                          m_throttleTimer;
+    QFile                           m_requestLog;
+#ifdef HAVE_WEBSOCKETS
+    QWebSocketServer                m_realtimeServer;
+    QQueue<QPair<int, MockResponsePlan>> m_pendingUpgrades;  // Request number and plan per handshake
+#endif
+};
+
+#endif // MOCKTRANSCRIPTIONSERVER_H
@@ -0,0 +1,100 @@
+#include <QtTest>
+#include <chrono>
+#include <vector>
+
+#include "config/config.h"
+#include "core/audiorecorder.h"
+
+// The recorder's per-buffer path across consecutive recordings, driven the
+// way the audio callback drives it but without a stream
+class AudioRecorderTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void startLatencyOnEveryRecording_data();
+    void startLatencyOnEveryRecording();
+    void preRollAfterIdleCallbacks();
+
+private:
+    // What startRecording() publishes to the callback; no callback runs in between
+    static void beginRecording(AudioRecorder& recorder);
+    static void endRecording(AudioRecorder& recorder);
+    static void feed(AudioRecorder& recorder, bool recording, int buffers);
+};
+
+void AudioRecorderTest::beginRecording(AudioRecorder& recorder)
+{
+    recorder.m_startRequestedNs.store(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                          std::chrono::steady_clock::now().time_since_epoch()).count());
+    recorder.m_startLatencyUs.store(-1);
+    recorder.m_preRollCoveredUs.store(-1);
+    recorder.m_pcmRing.reset();
+    recorder.m_recordingGeneration.fetch_add(1);
+}
+
+void AudioRecorderTest::endRecording(AudioRecorder& recorder)
+{
+    recorder.m_pcmRing.reset();
+}
+
+void AudioRecorderTest::feed(AudioRecorder& recorder, bool recording, int buffers)
+{
+    const std::vector<short> pcm(static_cast<std::size_t>(FRAMES_PER_BUFFER * NUM_CHANNELS), 1000);
+    for (int i = 0; i < buffers; ++i) {
+        recorder.processCapturedAudio(pcm.data(), FRAMES_PER_BUFFER, recording, nullptr, 0);
+    }
+}
+
+void AudioRecorderTest::startLatencyOnEveryRecording_data()
+{
+    QTest::addColumn<int>("preRollMs");
+
+    QTest::newRow("stream paused while idle") << 0;
+    QTest::newRow("warm standby") << 500;
+}
+
+void AudioRecorderTest::startLatencyOnEveryRecording()
+{
+    QFETCH(int, preRollMs);
+
+    AudioRecorder recorder;
+    recorder.setPreRoll(preRollMs);
+    recorder.configureCapture(FALLBACK_SAMPLE_RATE);
+
+    // Back to back, as when the stream is paused before the recording flag
+    // is cleared, or a stop and a start fall between two callbacks
+    for (int recording = 1; recording <= 3; ++recording) {
+        beginRecording(recorder);
+        feed(recorder, true, 4);
+        QVERIFY2(recorder.startLatencyUs() >= 0, qPrintable(QString("recording %1").arg(recording)));
+        QVERIFY2(recorder.preRollCoveredUs() >= 0, qPrintable(QString("recording %1").arg(recording)));
+        endRecording(recorder);
+    }
+}
+
+void AudioRecorderTest::preRollAfterIdleCallbacks()
+{
+    constexpr int PRE_ROLL_MS = 500;
+    AudioRecorder recorder;
+    recorder.setPreRoll(PRE_ROLL_MS);
+    recorder.configureCapture(FALLBACK_SAMPLE_RATE);
+    const qint64 buffersPerPreRoll = static_cast<qint64>(FALLBACK_SAMPLE_RATE) * PRE_ROLL_MS / 1000 / FRAMES_PER_BUFFER + 1;
+
+    for (int recording = 1; recording <= 2; ++recording) {
+        feed(recorder, false, static_cast<int>(buffersPerPreRoll));
+        beginRecording(recorder);
+        feed(recorder, true, 1);
+
+        // The whole pre-roll goes in ahead of the first block, every time
+        QCOMPARE(recorder.preRollCoveredUs(), static_cast<qint64>(PRE_ROLL_MS) * 1000);
+        QCOMPARE(recorder.m_pcmRing.readAvailable(),
+                 static_cast<std::size_t>(FALLBACK_SAMPLE_RATE) * NUM_CHANNELS * PRE_ROLL_MS / 1000
+                     + FRAMES_PER_BUFFER * NUM_CHANNELS);
+        endRecording(recorder);
+    }
+}
+
+QTEST_GUILESS_MAIN(AudioRecorderTest)
+
+#include "audiorecordertest.moc"
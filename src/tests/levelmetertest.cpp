@@ -0,0 +1,180 @@
+#include <QRandomGenerator>
+#include <QtTest>
+#include <vector>
+
+#include "config/config.h"
+#include "core/levelmeter.h"
+
+Q_DECLARE_METATYPE(LevelMeterKernel)
+
+namespace {
+
+// Keeps the optimizer from discarding benchmarked work
+volatile float g_benchSink = 0.0f;
+
+// The volume computation handleAudioData() used before the metering kernel
+float legacyMeanAbsVolume(const short* buffer, unsigned long frames)
+{
+    long sum = 0;
+    for (unsigned long i = 0; i < frames; ++i) {
+        sum += qAbs(buffer[i]);
+    }
+    float average = static_cast<float>(sum) / frames;
+    float normalizedVolume = average / 32767.0f;
+    return qMin(normalizedVolume * VOLUME_SCALING_FACTOR, 1.0f);
+}
+
+std::vector<short> makeSamples(const QString& fill, int count)
+{
+    std::vector<short> samples(static_cast<std::size_t>(count));
+    QRandomGenerator rng(static_cast<quint32>(count));
+    for (int i = 0; i < count; ++i) {
+        short& sample = samples[static_cast<std::size_t>(i)];
+        if (fill == "random") {
+            sample = static_cast<short>(rng.bounded(-32768, 32768));
+        } else if (fill == "full scale") {
+            // Both extremes in every vector lane and in the scalar tail
+            sample = i % 3 == 0 ? short(-32768) : i % 3 == 1 ? short(32767) : short(-32767);
+        } else if (fill == "negative full scale") {
+            sample = -32768;
+        } else {
+            sample = 0;
+        }
+    }
+    return samples;
+}
+
+} // namespace
+
+// The SIMD kernels against the scalar one, and what each costs per frame
+class LevelMeterTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void kernelsMatchScalar_data();
+    void kernelsMatchScalar();
+    void fullScale_data();
+    void fullScale();
+
+    void benchmark_data();
+    void benchmark();
+};
+
+void LevelMeterTest::kernelsMatchScalar_data()
+{
+    QTest::addColumn<LevelMeterKernel>("kernel");
+    QTest::addColumn<QString>("fill");
+    QTest::addColumn<int>("count");
+
+    // Odd lengths leave a scalar tail behind every vector width
+    for (LevelMeterKernel kernel : {LevelMeterKernel::Sse2, LevelMeterKernel::Avx2}) {
+        for (const QString fill : {"random", "full scale", "silence"}) {
+            for (int count : {1, 3, 7, 9, 15, 17, 31, 33, 255, 257, 4097}) {
+                QTest::addRow("%s %s %d", levelMeterKernelName(kernel), qPrintable(fill), count)
+                    << kernel << fill << count;
+            }
+        }
+    }
+}
+
+void LevelMeterTest::kernelsMatchScalar()
+{
+    QFETCH(LevelMeterKernel, kernel);
+    QFETCH(QString, fill);
+    QFETCH(int, count);
+    if (!isLevelMeterKernelSupported(kernel)) {
+        QSKIP("Kernel not supported on this CPU");
+    }
+
+    const std::vector<short> samples = makeSamples(fill, count);
+    const LevelStats expected = measureLevelWith(LevelMeterKernel::Scalar, samples.data(), samples.size());
+    const LevelStats actual = measureLevelWith(kernel, samples.data(), samples.size());
+
+    // Integer accumulators throughout, so the results are identical, not just close
+    QCOMPARE(actual.peak, expected.peak);
+    QCOMPARE(actual.clippedSamples, expected.clippedSamples);
+    QVERIFY(actual.rms == expected.rms);
+}
+
+void LevelMeterTest::fullScale_data()
+{
+    QTest::addColumn<LevelMeterKernel>("kernel");
+    QTest::addColumn<int>("count");
+
+    for (LevelMeterKernel kernel : {LevelMeterKernel::Scalar, LevelMeterKernel::Sse2, LevelMeterKernel::Avx2}) {
+        for (int count : {1, 17, 4097}) {
+            QTest::addRow("%s %d", levelMeterKernelName(kernel), count) << kernel << count;
+        }
+    }
+}
+
+void LevelMeterTest::fullScale()
+{
+    QFETCH(LevelMeterKernel, kernel);
+    QFETCH(int, count);
+    if (!isLevelMeterKernelSupported(kernel)) {
+        QSKIP("Kernel not supported on this CPU");
+    }
+
+    // -32768 squared twice overflows a signed 32-bit lane
+    const std::vector<short> negative = makeSamples("negative full scale", count);
+    const LevelStats low = measureLevelWith(kernel, negative.data(), negative.size());
+    QCOMPARE(low.peak, 32768);
+    QCOMPARE(low.clippedSamples, count);
+    QCOMPARE(low.rms, 1.0f);
+    QCOMPARE(low.peakNormalized(), 1.0f);
+
+    const std::vector<short> positive(static_cast<std::size_t>(count), 32767);
+    const LevelStats high = measureLevelWith(kernel, positive.data(), positive.size());
+    QCOMPARE(high.peak, 32767);
+    QCOMPARE(high.clippedSamples, count);
+    QCOMPARE(high.rms, 32767.0f / 32768.0f);
+}
+
+void LevelMeterTest::benchmark_data()
+{
+    QTest::addColumn<QString>("kernel");
+    QTest::addColumn<int>("frames");
+
+    // One callback-sized buffer (what runs ~172x per second) and a larger block
+    for (int frames : {FRAMES_PER_BUFFER, ENCODER_BATCH_FRAMES}) {
+        for (const QString kernel : {"legacy mean-abs", "scalar", "sse2", "avx2"}) {
+            QTest::addRow("%s [%d]", qPrintable(kernel), frames) << kernel << frames;
+        }
+    }
+}
+
+void LevelMeterTest::benchmark()
+{
+    QFETCH(QString, kernel);
+    QFETCH(int, frames);
+
+    const std::vector<short> samples = makeSamples("random", frames);
+    const short* data = samples.data();
+    const auto count = static_cast<std::size_t>(frames);
+
+    if (kernel == "legacy mean-abs") {
+        QBENCHMARK {
+            g_benchSink = g_benchSink + legacyMeanAbsVolume(data, static_cast<unsigned long>(frames));
+        }
+        return;
+    }
+
+    LevelMeterKernel selected = LevelMeterKernel::Scalar;
+    for (LevelMeterKernel candidate : {LevelMeterKernel::Sse2, LevelMeterKernel::Avx2}) {
+        if (kernel == levelMeterKernelName(candidate)) {
+            selected = candidate;
+        }
+    }
+    if (!isLevelMeterKernelSupported(selected)) {
+        QSKIP("Kernel not supported on this CPU");
+    }
+    QBENCHMARK {
+        g_benchSink = g_benchSink + measureLevelWith(selected, data, count).rms;
+    }
+}
+
+QTEST_APPLESS_MAIN(LevelMeterTest)
+
+#include "levelmetertest.moc"
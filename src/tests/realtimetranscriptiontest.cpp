@@ -0,0 +1,140 @@
+#include <QSignalSpy>
+#include <QtMath>
+#include <QtTest>
+#include <vector>
+
+#include "config/config.h"
+#include "core/chunkedarena.h"
+#include "core/realtimetranscriptionservice.h"
+#include "core/wavencoder.h"
+#include "mock/mocktranscriptionserver.h"
+
+namespace {
+
+// Canned text of the stand-in; each turn of TURN_SPEECH_MS gets the next two words
+constexpr auto RESPONSE_TEXT = "alpha bravo charlie delta echo foxtrot";
+constexpr int TURN_SPEECH_MS = 900;
+// Longer than the pause that ends a turn (REALTIME_VAD_SILENCE_MS)
+constexpr int TURN_PAUSE_MS = 700;
+
+// Odd-sized chunks, so samples straddle chunk boundaries
+constexpr std::size_t TEST_ARENA_CHUNK_BYTES = 4099;
+constexpr std::size_t TEST_ARENA_MAX_CHUNKS = 256;
+
+void appendTone(std::vector<short>& pcm, int ms)
+{
+    const int frames = SPEECH_SAMPLE_RATE * ms / 1000;
+    for (int i = 0; i < frames; ++i) {
+        pcm.push_back(static_cast<short>(8000.0 * qSin(2.0 * M_PI * 220.0 * i / SPEECH_SAMPLE_RATE)));
+    }
+}
+
+void appendSilence(std::vector<short>& pcm, int ms)
+{
+    pcm.insert(pcm.end(), static_cast<std::size_t>(SPEECH_SAMPLE_RATE * ms / 1000), 0);
+}
+
+// A finished recording as the recorder leaves it for the realtime backend
+QSharedPointer<const ChunkedArena> makeRecording(const std::vector<short>& pcm)
+{
+    WavEncoder encoder;
+    QByteArray wav;
+    encoder.begin(SPEECH_SAMPLE_RATE, NUM_CHANNELS);
+    encoder.encode(pcm.data(), static_cast<int>(pcm.size()), wav);
+    encoder.finish(wav);
+
+    QSharedPointer<ChunkedArena> arena =
+        QSharedPointer<ChunkedArena>::create(TEST_ARENA_CHUNK_BYTES, TEST_ARENA_MAX_CHUNKS);
+    arena->append(wav.constData(), wav.size());
+    arena->finish();
+    return arena;
+}
+
+} // namespace
+
+// RealtimeTranscriptionService end to end against the stand-in's realtime
+// session: turns cut by its VAD, the client's final commit and the texts
+class RealtimeTranscriptionTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    void turnsArriveInOrder();
+    void emptyFinalCommitStillCompletes();
+
+private:
+    // Transcribes `pcm` through the stand-in; the partial texts in order of
+    // arrival go to `partials`
+    QString transcribe(const std::vector<short>& pcm, QStringList* partials);
+
+private:
+    MockTranscriptionServer m_server;
+};
+
+void RealtimeTranscriptionTest::initTestCase()
+{
+    qputenv("OPENAI_API_KEY", "test");
+    m_server.setResponseText(RESPONSE_TEXT);
+    QVERIFY2(m_server.listen(QHostAddress::LocalHost, 0), qPrintable(m_server.errorString()));
+}
+
+QString RealtimeTranscriptionTest::transcribe(const std::vector<short>& pcm, QStringList* partials)
+{
+    RealtimeTranscriptionService service;
+    service.setApiBaseUrl(QString("http://127.0.0.1:%1/v1").arg(m_server.serverPort()));
+    connect(&service, &TranscriptionBackend::partialTranscription, this, [partials](const QString& text) {
+        partials->append(text);
+    });
+    QSignalSpy completed(&service, &TranscriptionBackend::transcriptionCompleted);
+    QSignalSpy failed(&service, &TranscriptionBackend::transcriptionFailed);
+
+    service.transcribeRecording(makeRecording(pcm), AudioFormat::Wav, "en");
+    // The session's delay is 0, so this takes well under a second
+    QTest::qWaitFor([&]() { return completed.count() + failed.count() > 0; }, 10000);
+    if (!failed.isEmpty()) {
+        return "failed: " + failed.first().first().toString();
+    }
+    return completed.isEmpty() ? QString("timed out") : completed.first().first().toString();
+}
+
+void RealtimeTranscriptionTest::turnsArriveInOrder()
+{
+    // Two pauses the stand-in cuts at, then words the client has to commit
+    std::vector<short> pcm;
+    appendTone(pcm, TURN_SPEECH_MS);
+    appendSilence(pcm, TURN_PAUSE_MS);
+    appendTone(pcm, TURN_SPEECH_MS);
+    appendSilence(pcm, TURN_PAUSE_MS);
+    appendTone(pcm, TURN_SPEECH_MS);
+
+    QStringList partials;
+    const QString text = transcribe(pcm, &partials);
+    QCOMPARE(text, QString(RESPONSE_TEXT));
+
+    // Every partial text so far keeps the turns in previous_item_id order
+    QVERIFY(!partials.isEmpty());
+    for (const QString& partial : partials) {
+        QVERIFY2(QString(RESPONSE_TEXT).startsWith(partial), qPrintable(partial));
+    }
+    QCOMPARE(partials.last(), QString(RESPONSE_TEXT));
+}
+
+void RealtimeTranscriptionTest::emptyFinalCommitStillCompletes()
+{
+    // The stand-in's VAD ends the turn less than REALTIME_MIN_COMMIT_MS
+    // before the recording does, after the client already sent everything:
+    // its final commit is answered with input_audio_buffer_commit_empty
+    std::vector<short> pcm;
+    appendTone(pcm, TURN_SPEECH_MS);
+    appendSilence(pcm, REALTIME_VAD_SILENCE_MS + REALTIME_MIN_COMMIT_MS / 2);
+
+    QStringList partials;
+    const QString text = transcribe(pcm, &partials);
+    QCOMPARE(text, QString("alpha bravo"));
+}
+
+QTEST_GUILESS_MAIN(RealtimeTranscriptionTest)
+
+#include "realtimetranscriptiontest.moc"
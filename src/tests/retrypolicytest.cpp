@@ -0,0 +1,244 @@
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QLocale>
+#include <QSignalSpy>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+#include <QtTest>
+
+#include "config/config.h"
+#include "core/chunkedarena.h"
+#include "core/openaitranscriptionservice.h"
+#include "core/retrypolicy.h"
+#include "mock/mocktranscriptionserver.h"
+
+namespace {
+
+constexpr auto RESPONSE_TEXT = "second time lucky";
+
+// Draws per attempt in the jitter bounds check
+constexpr int JITTER_SAMPLES = 500;
+
+// Slack for the clock running between a computation and its check
+constexpr qint64 CLOCK_SLACK_MS = 2000;
+
+} // namespace
+
+// RetryPolicy's classification, backoff and Retry-After handling, and one
+// retried request of the API backend against the stand-in
+class RetryPolicyTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    void isRetryable_data();
+    void isRetryable();
+    void parseRetryAfter_data();
+    void parseRetryAfter();
+    void parseRetryAfterDate();
+    void backoffWithinJitterBounds();
+    void retryAfterIsAFloor();
+    void deadlineCutsOff();
+    void retriesServiceUnavailable();
+
+private:
+    MockTranscriptionServer m_server;
+    QTemporaryDir           m_logDir;
+};
+
+void RetryPolicyTest::initTestCase()
+{
+    // Request timings go to a scratch cache, not the app's
+    QStandardPaths::setTestModeEnabled(true);
+    qputenv("OPENAI_API_KEY", "test");
+    QVERIFY(m_logDir.isValid());
+    QString error;
+    QVERIFY2(m_server.setRequestLog(m_logDir.filePath("requests.jsonl"), &error), qPrintable(error));
+    m_server.setResponseText(RESPONSE_TEXT);
+    QVERIFY2(m_server.listen(QHostAddress::LocalHost, 0), qPrintable(m_server.errorString()));
+}
+
+void RetryPolicyTest::isRetryable_data()
+{
+    QTest::addColumn<int>("status");
+    QTest::addColumn<QNetworkReply::NetworkError>("error");
+    QTest::addColumn<bool>("retryable");
+
+    // Worth another try
+    QTest::newRow("408") << 408 << QNetworkReply::UnknownContentError << true;
+    QTest::newRow("409") << 409 << QNetworkReply::ContentConflictError << true;
+    QTest::newRow("429") << 429 << QNetworkReply::UnknownContentError << true;
+    QTest::newRow("500") << 500 << QNetworkReply::InternalServerError << true;
+    QTest::newRow("503") << 503 << QNetworkReply::ServiceUnavailableError << true;
+    QTest::newRow("connection dropped") << 0 << QNetworkReply::RemoteHostClosedError << true;
+    QTest::newRow("stalled") << 0 << QNetworkReply::TimeoutError << true;
+    QTest::newRow("network flapped") << 0 << QNetworkReply::TemporaryNetworkFailureError << true;
+
+    // Would fail the same way again
+    QTest::newRow("400") << 400 << QNetworkReply::ProtocolInvalidOperationError << false;
+    QTest::newRow("401") << 401 << QNetworkReply::AuthenticationRequiredError << false;
+    QTest::newRow("404") << 404 << QNetworkReply::ContentNotFoundError << false;
+    QTest::newRow("413") << 413 << QNetworkReply::UnknownContentError << false;
+    QTest::newRow("unknown host") << 0 << QNetworkReply::HostNotFoundError << false;
+    QTest::newRow("TLS handshake") << 0 << QNetworkReply::SslHandshakeFailedError << false;
+    QTest::newRow("garbled response") << 0 << QNetworkReply::ProtocolFailure << false;
+    QTest::newRow("cancelled") << 0 << QNetworkReply::OperationCanceledError << false;
+}
+
+void RetryPolicyTest::isRetryable()
+{
+    QFETCH(int, status);
+    QFETCH(QNetworkReply::NetworkError, error);
+    QFETCH(bool, retryable);
+
+    QCOMPARE(RetryPolicy::isRetryable(status, error), retryable);
+}
+
+void RetryPolicyTest::parseRetryAfter_data()
+{
+    QTest::addColumn<QByteArray>("value");
+    QTest::addColumn<qint64>("delayMs");
+
+    QTest::newRow("delay-seconds") << QByteArray("2") << qint64(2000);
+    QTest::newRow("padded") << QByteArray(" 120 ") << qint64(120000);
+    QTest::newRow("zero") << QByteArray("0") << qint64(0);
+    QTest::newRow("past date") << QByteArray("Wed, 21 Oct 2015 07:28:00 GMT") << qint64(0);
+    QTest::newRow("missing") << QByteArray() << qint64(-1);
+    QTest::newRow("negative") << QByteArray("-5") << qint64(-1);
+    QTest::newRow("not a number") << QByteArray("soon") << qint64(-1);
+    QTest::newRow("invalid date") << QByteArray("Wed, 32 Oct 2015 07:28:00 GMT") << qint64(-1);
+    QTest::newRow("not GMT") << QByteArray("Wed, 21 Oct 2015 07:28:00 CET") << qint64(-1);
+}
+
+void RetryPolicyTest::parseRetryAfter()
+{
+    QFETCH(QByteArray, value);
+    QFETCH(qint64, delayMs);
+
+    QCOMPARE(RetryPolicy::parseRetryAfter(value), delayMs);
+}
+
+void RetryPolicyTest::parseRetryAfterDate()
+{
+    // IMF-fixdate has whole seconds, so up to one is lost to truncation
+    const QDateTime date = QDateTime::currentDateTimeUtc().addSecs(30);
+    const QByteArray value = QLocale::c().toString(date, "ddd, dd MMM yyyy HH:mm:ss 'GMT'").toLatin1();
+    const qint64 delayMs = RetryPolicy::parseRetryAfter(value);
+    QVERIFY2(delayMs > 30000 - 1000 - CLOCK_SLACK_MS && delayMs <= 30000, qPrintable(QString("%1 ms for %2")
+                                                                                       .arg(delayMs)
+                                                                                       .arg(QString(value))));
+}
+
+void RetryPolicyTest::backoffWithinJitterBounds()
+{
+    // No deadline until start()
+    RetryPolicy policy;
+    for (int attempts = 1; attempts < RETRY_MAX_ATTEMPTS; ++attempts) {
+        const qint64 backoff = qMin<qint64>(static_cast<qint64>(RETRY_BASE_DELAY_MS) << (attempts - 1),
+                                            RETRY_MAX_DELAY_MS);
+        qint64 lowest = backoff;
+        qint64 highest = 0;
+        for (int i = 0; i < JITTER_SAMPLES; ++i) {
+            const qint64 delay = policy.nextDelayMs(attempts, -1);
+            lowest = qMin(lowest, delay);
+            highest = qMax(highest, delay);
+        }
+
+        // Half fixed, half random; both halves actually used
+        QVERIFY2(lowest >= backoff / 2 && highest <= backoff,
+                 qPrintable(QString("attempt %1: %2..%3 ms").arg(attempts).arg(lowest).arg(highest)));
+        QVERIFY2(highest > lowest, qPrintable(QString("attempt %1: no jitter").arg(attempts)));
+    }
+
+    // The last attempt has been made
+    QCOMPARE(policy.nextDelayMs(RETRY_MAX_ATTEMPTS, -1), qint64(-1));
+}
+
+void RetryPolicyTest::retryAfterIsAFloor()
+{
+    RetryPolicy policy;
+    policy.start(-1);
+
+    // Longer than any backoff: the server's wait wins
+    QCOMPARE(policy.nextDelayMs(1, RETRY_MAX_DELAY_MS * 2), qint64(RETRY_MAX_DELAY_MS) * 2);
+
+    // Shorter: the backoff still applies
+    const qint64 delay = policy.nextDelayMs(1, 1);
+    QVERIFY(delay >= RETRY_BASE_DELAY_MS / 2 && delay <= RETRY_BASE_DELAY_MS);
+}
+
+void RetryPolicyTest::deadlineCutsOff()
+{
+    QCOMPARE(RetryPolicy::deadlineForAudio(-1), qint64(-1));
+    QCOMPARE(RetryPolicy::deadlineForAudio(0), qint64(RETRY_DEADLINE_BASE_MS));
+    QCOMPARE(RetryPolicy::deadlineForAudio(24LL * 3600 * 1000), qint64(RETRY_DEADLINE_MAX_MS));
+
+    RetryPolicy policy;
+    policy.start(0);
+    const qint64 remaining = policy.remainingMs();
+    QVERIFY(remaining > RETRY_DEADLINE_BASE_MS - CLOCK_SLACK_MS && remaining <= RETRY_DEADLINE_BASE_MS);
+
+    // A Retry-After that runs past the deadline gives up; one inside it is kept
+    QCOMPARE(policy.nextDelayMs(1, RETRY_DEADLINE_BASE_MS + 1000), qint64(-1));
+    QCOMPARE(policy.nextDelayMs(1, RETRY_DEADLINE_BASE_MS / 2), qint64(RETRY_DEADLINE_BASE_MS / 2));
+
+    // A streamed recording has no deadline until its length is known
+    policy.start(-1);
+    QCOMPARE(policy.remainingMs(), qint64(-1));
+    QCOMPARE(policy.nextDelayMs(1, RETRY_DEADLINE_BASE_MS + 1000), qint64(RETRY_DEADLINE_BASE_MS + 1000));
+}
+
+void RetryPolicyTest::retriesServiceUnavailable()
+{
+    constexpr int RETRY_AFTER_S = 1;
+    MockResponsePlan unavailable;
+    MockResponsePlan ok;
+    QString error;
+    QVERIFY2(unavailable.parse(QString("status=503 retry-after=%1").arg(RETRY_AFTER_S), &error), qPrintable(error));
+    QVERIFY2(ok.parse("ok", &error), qPrintable(error));
+    m_server.setScript({unavailable, ok});
+
+    QSharedPointer<ChunkedArena> audio =
+        QSharedPointer<ChunkedArena>::create(RECORDING_ARENA_CHUNK_BYTES, RECORDING_ARENA_MAX_CHUNKS);
+    const QByteArray payload(16 * 1024, 'a');
+    audio->append(payload.constData(), payload.size());
+    audio->finish();
+
+    OpenAiTranscriptionService service;
+    service.setApiBaseUrl(QString("http://127.0.0.1:%1/v1").arg(m_server.serverPort()));
+    QSignalSpy completed(&service, &TranscriptionBackend::transcriptionCompleted);
+    QSignalSpy failed(&service, &TranscriptionBackend::transcriptionFailed);
+    QElapsedTimer timer;
+    timer.start();
+    service.transcribeRecording(audio, AudioFormat::Mp3, "en");
+
+    // One 503, its Retry-After honored, then the answer
+    QVERIFY(QTest::qWaitFor([&]() { return completed.count() + failed.count() > 0; }, 15000));
+    QCOMPARE(failed.count(), 0);
+    QCOMPARE(completed.first().first().toString(), QString(RESPONSE_TEXT));
+    QVERIFY2(timer.elapsed() >= RETRY_AFTER_S * 1000, qPrintable(QString("%1 ms").arg(timer.elapsed())));
+
+    QFile log(m_logDir.filePath("requests.jsonl"));
+    QList<QByteArray> lines;
+    QVERIFY(QTest::qWaitFor([&]() {
+        if (!log.open(QIODevice::ReadOnly)) {
+            return false;
+        }
+        lines = log.readAll().split('\n');
+        log.close();
+        lines.removeAll(QByteArray());
+        return lines.size() >= 2;
+    }, 5000));
+    QCOMPARE(lines.size(), 2);
+    QVERIFY(QJsonDocument::fromJson(lines.at(0)).object().value("plan").toString().contains("status=503"));
+    QCOMPARE(QJsonDocument::fromJson(lines.at(1)).object().value("outcome").toString(), QString("answered"));
+}
+
+QTEST_GUILESS_MAIN(RetryPolicyTest)
+
+#include "retrypolicytest.moc"
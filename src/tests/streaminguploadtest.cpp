@@ -0,0 +1,212 @@
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSignalSpy>
+#include <QTemporaryDir>
+#include <QTimer>
+#include <QtTest>
+
+#include "config/config.h"
+#include "core/chunkedarena.h"
+#include "core/openaitranscriptionservice.h"
+#include "core/streamingupload.h"
+#include "mock/mocktranscriptionserver.h"
+
+namespace {
+
+constexpr auto RESPONSE_TEXT = "streamed while recording";
+constexpr auto FILENAME = "recording.mp3";
+
+// Odd-sized chunks and appends, so spans end at arbitrary offsets
+constexpr std::size_t TEST_ARENA_CHUNK_BYTES = 1531;
+constexpr std::size_t TEST_ARENA_MAX_CHUNKS = 256;
+constexpr int APPEND_BYTES = 997;
+constexpr int APPENDS = 40;
+constexpr int APPEND_INTERVAL_MS = 5;
+
+const StreamingUpload::HeaderList FIELDS = {{"model", "whisper-1"}, {"temperature", "0.1"}};
+
+// Multipart framing around the file part: the same strings
+// StreamingUpload::start() builds, with a boundary of the same length
+qint64 multipartOverhead()
+{
+    const QByteArray boundary(30, 'x');
+    QByteArray framing;
+    for (const auto& field : FIELDS) {
+        framing += "--" + boundary + "\r\n"
+                   "Content-Disposition: form-data; name=\"" + field.first + "\"\r\n\r\n"
+                   + field.second + "\r\n";
+    }
+    framing += "--" + boundary + "\r\n"
+               "Content-Disposition: form-data; name=\"file\"; filename=\"" + QByteArray(FILENAME) + "\"\r\n"
+               "Content-Type: application/octet-stream\r\n\r\n";
+    framing += "\r\n--" + boundary + "--\r\n";
+    return framing.size();
+}
+
+} // namespace
+
+// StreamingUpload's HTTP/1.1 client against the stand-in API: a recording
+// that grows while it is sent, and responses the stand-in breaks on purpose
+class StreamingUploadTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    void streamsGrowingRecording();
+    void errorStatusIsAResponse();
+    void brokenResponse_data();
+    void brokenResponse();
+
+private:
+    // Starts `upload` on an arena that is appended to while it is sent;
+    // returns the arena, finished once all APPENDS are in
+    QSharedPointer<ChunkedArena> startGrowingUpload(StreamingUpload& upload);
+    // The stand-in's log entry of its `request`th request (1-based)
+    QJsonObject logEntry(int request);
+
+private:
+    MockTranscriptionServer m_server;
+    QTemporaryDir           m_logDir;
+    int                     m_requests = 0;
+};
+
+void StreamingUploadTest::initTestCase()
+{
+    qRegisterMetaType<QNetworkReply::NetworkError>();
+    QVERIFY(m_logDir.isValid());
+    QString error;
+    QVERIFY2(m_server.setRequestLog(m_logDir.filePath("requests.jsonl"), &error), qPrintable(error));
+    m_server.setResponseText(RESPONSE_TEXT);
+    QVERIFY2(m_server.listen(QHostAddress::LocalHost, 0), qPrintable(m_server.errorString()));
+}
+
+QSharedPointer<ChunkedArena> StreamingUploadTest::startGrowingUpload(StreamingUpload& upload)
+{
+    QSharedPointer<ChunkedArena> arena =
+        QSharedPointer<ChunkedArena>::create(TEST_ARENA_CHUNK_BYTES, TEST_ARENA_MAX_CHUNKS);
+    const QByteArray block(APPEND_BYTES, 'a');
+    arena->append(block.constData(), block.size());
+
+    const QUrl url(QString("http://127.0.0.1:%1/v1%2").arg(m_server.serverPort()).arg(TRANSCRIPTION_API_PATH));
+    upload.start(url, {{"Authorization", "Bearer test"}}, FIELDS, FILENAME, arena);
+    ++m_requests;
+
+    // The rest arrives like encoder output while the upload is running
+    auto* timer = new QTimer(&upload);
+    connect(timer, &QTimer::timeout, timer, [timer, arena, block]() {
+        if (arena->size() < static_cast<qint64>(APPENDS) * APPEND_BYTES) {
+            arena->append(block.constData(), block.size());
+            return;
+        }
+        arena->finish();
+        timer->deleteLater();
+    });
+    timer->start(APPEND_INTERVAL_MS);
+    return arena;
+}
+
+QJsonObject StreamingUploadTest::logEntry(int request)
+{
+    QFile log(m_logDir.filePath("requests.jsonl"));
+    QList<QByteArray> lines;
+    QTest::qWaitFor([&]() {
+        if (!log.open(QIODevice::ReadOnly)) {
+            return false;
+        }
+        lines = log.readAll().split('\n');
+        log.close();
+        lines.removeAll(QByteArray());
+        return lines.size() >= request;
+    }, 5000);
+    return lines.size() >= request ? QJsonDocument::fromJson(lines.at(request - 1)).object() : QJsonObject();
+}
+
+void StreamingUploadTest::streamsGrowingRecording()
+{
+    m_server.setDefaultPlan(MockResponsePlan());
+    StreamingUpload upload;
+    QSignalSpy progress(&upload, &StreamingUpload::uploadProgress);
+    QSignalSpy finished(&upload, &StreamingUpload::finished);
+    QSignalSpy failed(&upload, &StreamingUpload::failed);
+    const QSharedPointer<ChunkedArena> arena = startGrowingUpload(upload);
+
+    QVERIFY(finished.wait(10000));
+    QCOMPARE(failed.count(), 0);
+    QCOMPARE(finished.first().at(0).toInt(), 200);
+    QString text;
+    QString error;
+    QVERIFY2(OpenAiTranscriptionService::parseTranscriptionResponse(finished.first().at(1).toByteArray(), &text,
+                                                                     &error),
+             qPrintable(error));
+    QCOMPARE(text, QString(RESPONSE_TEXT));
+
+    // Sent while it was still being recorded, and all of it
+    QVERIFY(progress.count() > 1);
+    QCOMPARE(progress.first().at(1).toBool(), false);
+    QCOMPARE(upload.audioBytesSent(), arena->size());
+    QCOMPARE(arena->size(), static_cast<qint64>(APPENDS) * APPEND_BYTES);
+
+    // Every audio byte arrived exactly once, inside intact chunked framing
+    const QJsonObject entry = logEntry(m_requests);
+    QCOMPARE(entry.value("chunked").toBool(), true);
+    QCOMPARE(entry.value("outcome").toString(), QString("answered"));
+    QCOMPARE(entry.value("body_bytes").toVariant().toLongLong(), arena->size() + multipartOverhead());
+}
+
+void StreamingUploadTest::errorStatusIsAResponse()
+{
+    MockResponsePlan plan;
+    QString error;
+    QVERIFY2(plan.parse("status=503 retry-after=2", &error), qPrintable(error));
+    m_server.setDefaultPlan(plan);
+
+    StreamingUpload upload;
+    QSignalSpy finished(&upload, &StreamingUpload::finished);
+    QSignalSpy failed(&upload, &StreamingUpload::failed);
+    startGrowingUpload(upload);
+
+    // The classification is up to the caller; the transport worked
+    QVERIFY(finished.wait(10000));
+    QCOMPARE(failed.count(), 0);
+    QCOMPARE(finished.first().at(0).toInt(), 503);
+    QCOMPARE(upload.retryAfter(), QByteArray("2"));
+}
+
+void StreamingUploadTest::brokenResponse_data()
+{
+    QTest::addColumn<QString>("plan");
+    QTest::addColumn<QNetworkReply::NetworkError>("code");
+
+    // Half the announced body, then the connection closes
+    QTest::newRow("truncated") << "truncate" << QNetworkReply::RemoteHostClosedError;
+    // The same for an error response
+    QTest::newRow("truncated error response") << "status=500 truncate" << QNetworkReply::RemoteHostClosedError;
+}
+
+void StreamingUploadTest::brokenResponse()
+{
+    QFETCH(QString, plan);
+    QFETCH(QNetworkReply::NetworkError, code);
+
+    MockResponsePlan responsePlan;
+    QString error;
+    QVERIFY2(responsePlan.parse(plan, &error), qPrintable(error));
+    m_server.setDefaultPlan(responsePlan);
+
+    StreamingUpload upload;
+    QSignalSpy finished(&upload, &StreamingUpload::finished);
+    QSignalSpy failed(&upload, &StreamingUpload::failed);
+    startGrowingUpload(upload);
+
+    QVERIFY(failed.wait(10000));
+    QCOMPARE(finished.count(), 0);
+    QCOMPARE(failed.first().at(1).value<QNetworkReply::NetworkError>(), code);
+    QVERIFY(!upload.isRunning());
+}
+
+QTEST_GUILESS_MAIN(StreamingUploadTest)
+
+#include "streaminguploadtest.moc"
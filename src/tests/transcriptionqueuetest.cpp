@@ -0,0 +1,287 @@
+#include <QSignalSpy>
+#include <QtTest>
+
+#include "core/chunkedarena.h"
+#include "core/transcriptionqueue.h"
+
+namespace {
+
+// Records what the queue asks of it; the test decides when and how it finishes
+class FakeBackend : public TranscriptionBackend
+{
+    Q_OBJECT
+public:
+    QString name() const override { return "fake"; }
+    bool isAvailable() const override { return true; }
+    QString unavailableReason() const override { return QString(); }
+
+    void transcribeRecording(QSharedPointer<const ChunkedArena> audio, AudioFormat format,
+                             const QString& language) override
+    {
+        Q_UNUSED(format);
+        Q_UNUSED(language);
+        m_audio = audio;
+        ++m_requests;
+    }
+
+    void transcribeSegments(const QList<QSharedPointer<const ChunkedArena>>& segments, AudioFormat format,
+                            const QString& language) override
+    {
+        transcribeRecording(segments.first(), format, language);
+    }
+
+    void cancelTranscription() override
+    {
+        m_audio.reset();
+        ++m_cancellations;
+    }
+    bool isTranscribing() const override { return !m_audio.isNull(); }
+
+    void succeed(const QString& text)
+    {
+        m_audio.reset();
+        emit transcriptionCompleted(text);
+    }
+    void fail(const QString& error)
+    {
+        m_audio.reset();
+        emit transcriptionFailed(error);
+    }
+
+    QSharedPointer<const ChunkedArena> audio() const { return m_audio; }
+    int requests() const { return m_requests; }
+    int cancellations() const { return m_cancellations; }
+
+private:
+    QSharedPointer<const ChunkedArena> m_audio;
+    int m_requests = 0;
+    int m_cancellations = 0;
+};
+
+QSharedPointer<const ChunkedArena> makeRecording()
+{
+    QSharedPointer<ChunkedArena> arena = QSharedPointer<ChunkedArena>::create(1024, 4);
+    arena->append("RIFF", 4);
+    arena->finish();
+    return arena;
+}
+
+} // namespace
+
+// Ordering, holding and retries of TranscriptionQueue, against a backend
+// that finishes whenever the test says so
+class TranscriptionQueueTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+
+    void deliversInRecordingOrder();
+    void cancelingHeadReleasesLaterJobs();
+    void releasingDeliveryFlushesHeldResults();
+    void retriesOnlyLastFailure();
+    void withoutMoreBackendsRunsOneAtATime_data();
+    void withoutMoreBackendsRunsOneAtATime();
+
+private:
+    // Submits a one-segment recording and returns its job id
+    int submitRecording(const QSharedPointer<const ChunkedArena>& audio);
+    // The instance transcribing `audio`, or nullptr
+    FakeBackend* backendOf(const QSharedPointer<const ChunkedArena>& audio) const;
+
+private:
+    TranscriptionQueue* m_queue = nullptr;
+    QList<FakeBackend*> m_backends;   // Owned by m_queue
+};
+
+void TranscriptionQueueTest::init()
+{
+    m_backends = {new FakeBackend};
+    m_queue = new TranscriptionQueue(
+        m_backends.first(),
+        [this]() {
+            m_backends.append(new FakeBackend);
+            return m_backends.last();
+        },
+        2);
+}
+
+void TranscriptionQueueTest::cleanup()
+{
+    delete m_queue;
+    m_queue = nullptr;
+    m_backends.clear();
+}
+
+int TranscriptionQueueTest::submitRecording(const QSharedPointer<const ChunkedArena>& audio)
+{
+    const int id = m_queue->beginJob(audio, AudioFormat::Wav, "en", false);
+    m_queue->submitJob(id, {audio}, 1000);
+    return id;
+}
+
+FakeBackend* TranscriptionQueueTest::backendOf(const QSharedPointer<const ChunkedArena>& audio) const
+{
+    for (FakeBackend* backend : m_backends) {
+        if (backend->audio() == audio) {
+            return backend;
+        }
+    }
+    return nullptr;
+}
+
+void TranscriptionQueueTest::deliversInRecordingOrder()
+{
+    QSignalSpy completed(m_queue, &TranscriptionQueue::jobCompleted);
+    const QSharedPointer<const ChunkedArena> first = makeRecording();
+    const QSharedPointer<const ChunkedArena> second = makeRecording();
+    const int firstId = submitRecording(first);
+    const int secondId = submitRecording(second);
+
+    // Side by side, on an instance each
+    FakeBackend* firstBackend = backendOf(first);
+    FakeBackend* secondBackend = backendOf(second);
+    QVERIFY(firstBackend);
+    QVERIFY(secondBackend);
+    QVERIFY(firstBackend != secondBackend);
+
+    // The later recording finishing first waits for the earlier one
+    secondBackend->succeed("second");
+    QCOMPARE(completed.count(), 0);
+
+    firstBackend->succeed("first");
+    QCOMPARE(completed.count(), 2);
+    QCOMPARE(completed.at(0).at(0).toInt(), firstId);
+    QCOMPARE(completed.at(0).at(1).toString(), QString("first"));
+    QCOMPARE(completed.at(1).at(0).toInt(), secondId);
+    QCOMPARE(completed.at(1).at(1).toString(), QString("second"));
+    QCOMPARE(m_queue->pendingJobs(), 0);
+}
+
+void TranscriptionQueueTest::cancelingHeadReleasesLaterJobs()
+{
+    QSignalSpy completed(m_queue, &TranscriptionQueue::jobCompleted);
+    const QSharedPointer<const ChunkedArena> first = makeRecording();
+    const QSharedPointer<const ChunkedArena> second = makeRecording();
+    const int firstId = submitRecording(first);
+    const int secondId = submitRecording(second);
+    FakeBackend* firstBackend = backendOf(first);
+    QVERIFY(firstBackend);
+
+    backendOf(second)->succeed("second");
+    QCOMPARE(completed.count(), 0);
+
+    m_queue->cancelJob(firstId);
+    QCOMPARE(firstBackend->cancellations(), 1);
+    QCOMPARE(completed.count(), 1);
+    QCOMPARE(completed.at(0).at(0).toInt(), secondId);
+
+    // Whatever the canceled request still reports goes nowhere
+    firstBackend->succeed("late");
+    QCOMPARE(completed.count(), 1);
+    QCOMPARE(m_queue->pendingJobs(), 0);
+}
+
+void TranscriptionQueueTest::releasingDeliveryFlushesHeldResults()
+{
+    QSignalSpy completed(m_queue, &TranscriptionQueue::jobCompleted);
+    QSignalSpy failed(m_queue, &TranscriptionQueue::jobFailed);
+    m_queue->setDeliveryHeld(true);
+
+    const QSharedPointer<const ChunkedArena> first = makeRecording();
+    const QSharedPointer<const ChunkedArena> second = makeRecording();
+    const int firstId = submitRecording(first);
+    const int secondId = submitRecording(second);
+    backendOf(first)->succeed("first");
+    backendOf(second)->fail("offline");
+    QCOMPARE(completed.count(), 0);
+    QCOMPARE(failed.count(), 0);
+    QCOMPARE(m_queue->pendingJobs(), 2);
+
+    // Delivered from the event loop, not inside setDeliveryHeld()
+    m_queue->setDeliveryHeld(false);
+    QCOMPARE(completed.count(), 0);
+    QTRY_COMPARE(failed.count(), 1);
+    QCOMPARE(completed.count(), 1);
+    QCOMPARE(completed.at(0).at(0).toInt(), firstId);
+    QCOMPARE(failed.at(0).at(0).toInt(), secondId);
+    QCOMPARE(failed.at(0).at(1).toString(), QString("offline"));
+    QCOMPARE(m_queue->pendingJobs(), 0);
+}
+
+void TranscriptionQueueTest::retriesOnlyLastFailure()
+{
+    QSignalSpy failed(m_queue, &TranscriptionQueue::jobFailed);
+    QSignalSpy completed(m_queue, &TranscriptionQueue::jobCompleted);
+    const QSharedPointer<const ChunkedArena> first = makeRecording();
+    const QSharedPointer<const ChunkedArena> second = makeRecording();
+    const int firstId = submitRecording(first);
+    const int secondId = submitRecording(second);
+    backendOf(first)->fail("timeout");
+    backendOf(second)->fail("offline");
+    QCOMPARE(failed.count(), 2);
+
+    // Neither an earlier failure nor an unknown id
+    QCOMPARE(m_queue->retryJob(firstId), -1);
+    QCOMPARE(m_queue->retryJob(secondId + 100), -1);
+    QCOMPARE(m_queue->pendingJobs(), 0);
+
+    // The last failure goes out again with the same audio, as the newest job
+    const int retryId = m_queue->retryJob(secondId);
+    QVERIFY(retryId > secondId);
+    FakeBackend* backend = backendOf(second);
+    QVERIFY(backend);
+
+    // Only once
+    QCOMPARE(m_queue->retryJob(secondId), -1);
+
+    backend->succeed("second");
+    QCOMPARE(completed.count(), 1);
+    QCOMPARE(completed.at(0).at(0).toInt(), retryId);
+}
+
+void TranscriptionQueueTest::withoutMoreBackendsRunsOneAtATime_data()
+{
+    QTest::addColumn<bool>("withFactory");
+
+    QTest::newRow("no factory") << false;
+    QTest::newRow("factory returns nullptr") << true;
+}
+
+void TranscriptionQueueTest::withoutMoreBackendsRunsOneAtATime()
+{
+    QFETCH(bool, withFactory);
+
+    delete m_queue;
+    m_backends = {new FakeBackend};
+    TranscriptionQueue::BackendFactory factory;
+    if (withFactory) {
+        factory = []() -> TranscriptionBackend* { return nullptr; };
+    }
+    m_queue = new TranscriptionQueue(m_backends.first(), factory, 4);
+
+    QSignalSpy completed(m_queue, &TranscriptionQueue::jobCompleted);
+    const QSharedPointer<const ChunkedArena> first = makeRecording();
+    const QSharedPointer<const ChunkedArena> second = makeRecording();
+    submitRecording(first);
+    submitRecording(second);
+
+    // The second recording waits for the only instance
+    FakeBackend* backend = m_backends.first();
+    QCOMPARE(m_backends.size(), 1);
+    QVERIFY(backend->audio() == first);
+    QCOMPARE(backend->requests(), 1);
+
+    backend->succeed("first");
+    QVERIFY(backend->audio() == second);
+    QCOMPARE(backend->requests(), 2);
+
+    backend->succeed("second");
+    QCOMPARE(completed.count(), 2);
+}
+
+QTEST_GUILESS_MAIN(TranscriptionQueueTest)
+
+#include "transcriptionqueuetest.moc"
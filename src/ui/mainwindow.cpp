@@ -2,31 +2,38 @@
 #include <QVBoxLayout>
 #include <QPalette>
 #include <QColor>
-#include <QProgressBar>
 #include <QKeyEvent>
 #include <QApplication>
 #include <QMessageBox>
 #include <QUrl>
 #include <QDir>
 #include <QCloseEvent>
+#include <QHideEvent>
 #include <QShowEvent>
 
 #include "core/audiorecorder.h"
-#include "core/openaitranscriptionservice.h"
+#include "core/transcriptionqueue.h"
 #include "core/statusutils.h"
+#include "core/tracer.h"
+#include "ui/volumebar.h"
 #include "config/config.h"
 
-MainWindow::MainWindow(AudioRecorder* recorder, QWidget* parent)
+MainWindow::MainWindow(AudioRecorder* recorder, TranscriptionQueue* transcriptions, QWidget* parent)
     : QMainWindow(parent),
       m_recorder(recorder),
-      m_transcriptionService(new OpenAiTranscriptionService(this)),
+      m_transcriptions(transcriptions),
       m_statusLabel(new QLabel(this)),
       m_transcriptionLabel(new QLabel(this)),
+      m_lastMeterLevel(-1.0f),
+      m_lastMeterPeak(-1.0f),
+      m_audioFlowing(false),
       m_transcribeButton(new QPushButton(this)),
-      m_hasApiKey(false),
+      m_backendAvailable(false),
       m_exitCode(APP_EXIT_FAILURE_GENERAL), // Default to failure exit code until successful transcription
       m_isClosingPermanently(false)
 {
+    m_transcriptions->setParent(this);
+    
     // Set window properties
     setWindowTitle("Audio Recorder");
     resize(400, 320);  // Increased size to accommodate transcription UI
@@ -38,14 +45,12 @@ MainWindow::MainWindow(AudioRecorder* recorder, QWidget* parent)
     // Configure all labels to be center-aligned
     m_statusLabel->setAlignment(Qt::AlignCenter);
     m_transcriptionLabel->setAlignment(Qt::AlignCenter);
+    m_transcriptionLabel->setWordWrap(true);  // Interim text grows while recording
     
     m_statusLabel->setText("Starting...");
     
     // Create volume meter
-    m_volumeBar = new QWidget(this);
-    m_volumeBarLayout = new QHBoxLayout(m_volumeBar);
-    m_volumeBarLayout->setContentsMargins(10, 5, 10, 5);
-    createVolumeBar();
+    m_volumeBar = new VolumeBar(this);
 
     layout->addWidget(m_statusLabel);
     layout->addWidget(m_volumeBar);
@@ -82,30 +87,35 @@ MainWindow::MainWindow(AudioRecorder* recorder, QWidget* parent)
     m_statusLabel->setText("Initializing... (Press Enter/Space to save, Esc to cancel)");
 
     // Connect signals from recorder
-    connect(m_recorder, &AudioRecorder::volumeChanged, this, &MainWindow::onVolumeChanged);
     connect(m_recorder, &AudioRecorder::recordingStopped, this, &MainWindow::onRecordingStopped);
     connect(m_recorder, &AudioRecorder::recordingStarted, this, &MainWindow::onRecordingStarted);
     connect(m_recorder, &AudioRecorder::audioDeviceReady, this, &MainWindow::onAudioDeviceReady);
     
     // Connect transcription signals
     connect(m_transcribeButton, &QPushButton::clicked, this, &MainWindow::onTranscribeButtonClicked);
-    connect(m_transcriptionService, &OpenAiTranscriptionService::transcriptionCompleted, 
+    connect(m_transcriptions, &TranscriptionQueue::jobCompleted, 
             this, &MainWindow::onTranscriptionCompleted);
-    connect(m_transcriptionService, &OpenAiTranscriptionService::transcriptionFailed, 
+    connect(m_transcriptions, &TranscriptionQueue::jobFailed, 
             this, &MainWindow::onTranscriptionFailed);
-    connect(m_transcriptionService, &OpenAiTranscriptionService::transcriptionProgress, 
+    connect(m_transcriptions, &TranscriptionQueue::jobProgress, 
             this, &MainWindow::onTranscriptionProgress);
+    connect(m_transcriptions, &TranscriptionQueue::jobPartial,
+            this, &MainWindow::onTranscriptionPartial);
 
     // Periodically update UI for elapsed time and file size
     m_updateTimer.setInterval(500); // 0.5 seconds
     connect(&m_updateTimer, &QTimer::timeout, this, &MainWindow::updateUI);
     m_updateTimer.start();
     
-    // Check for API key
-    m_hasApiKey = m_transcriptionService->hasApiKey();
-    if (!m_hasApiKey) {
+    // The level meter polls the recorder instead of receiving a signal per audio buffer
+    m_meterTimer.setInterval(METER_REFRESH_INTERVAL_MS);
+    connect(&m_meterTimer, &QTimer::timeout, this, &MainWindow::updateLevelMeter);
+    
+    // Check for API key or model
+    m_backendAvailable = m_transcriptions->isAvailable();
+    if (!m_backendAvailable) {
         m_transcriptionLabel->setStyleSheet(STYLE_TRANSCRIPTION_ERROR);
-        m_transcriptionLabel->setText("NO API KEY - Set OPENAI_API_KEY environment variable");
+        m_transcriptionLabel->setText(m_transcriptions->unavailableReason());
     }
     
     // Set up auto-close timer for transcription errors
@@ -138,8 +148,9 @@ void MainWindow::updateUI()
     
     // Only update timer and size if recording is still active
     if (m_recorder->isRecording()) {
-        qint64 size = m_recorder->fileSize();
-        qint64 elapsed = m_recorder->elapsedMs();
+        const RecordingStats stats = m_recorder->stats();
+        qint64 size = stats.bytesWritten;
+        qint64 elapsed = stats.elapsedMs(m_recorder->captureSampleRate());
         
         // Format elapsed time in a more readable format
         int seconds = elapsed / 1000;
@@ -163,119 +174,36 @@ void MainWindow::updateUI()
     }
 }
 
-void MainWindow::onVolumeChanged(float volume)
+void MainWindow::updateLevelMeter()
 {
-    // First volume update means audio is now flowing
-    static bool firstVolume = true;
-    if (firstVolume) {
-        firstVolume = false;
-        m_statusLabel->setText("Recording in progress... (Press Enter/Space to save, Esc to cancel)");
-        qInfo() << "First audio data received, volume:" << volume;
-    }
-    
     // Only update volume if currently recording
-    if (m_recorder && m_recorder->isRecording()) {
-        // Only update if we have a significant volume level (reduces noise in display)
-        static float lastVolume = 0.0f;
-        if (qAbs(volume - lastVolume) > 0.005f) {
-            // Just update the volume bar without showing percentage text
-            updateVolumeBar(volume);
-            lastVolume = volume;
-        }
-    } else {
-        // Not recording, set volume to zero
-        updateVolumeBar(0.0f);
-    }
-}
-
-void MainWindow::createVolumeBar()
-{
-    // Clear any existing widgets
-    QLayoutItem* item;
-    while ((item = m_volumeBarLayout->takeAt(0)) != nullptr) {
-        delete item->widget();
-        delete item;
+    if (!m_recorder || !m_recorder->isRecording()) {
+        m_volumeBar->setLevel(0.0f);
+        m_meterTimer.stop();
+        return;
     }
     
-    // Create 20 segments for the volume meter
-    const int segments = 20;
-    for (int i = 0; i < segments; i++) {
-        QProgressBar* bar = new QProgressBar(this);
-        bar->setFixedWidth(8);
-        bar->setFixedHeight(30);
-        bar->setMinimum(0);
-        bar->setMaximum(100);
-        bar->setValue(0);
-        bar->setTextVisible(false);
-        
-        // Color gradient from green to yellow to red - dark mode colors
-        QColor color;
-        if (i < segments * 0.6) {            // First 60% - Bright Green
-            color = QColor(0, 230, 118);
-        } else if (i < segments * 0.8) {     // Next 20% - Bright Yellow
-            color = QColor(255, 214, 0);
-        } else {                             // Last 20% - Bright Red
-            color = QColor(255, 82, 82);
-        }
-        
-        // Set the bar color via stylesheet with dark mode styling
-        QString style = QString("QProgressBar { background: #222; border: 1px solid #333; border-radius: 2px; } "
-                               "QProgressBar::chunk { background-color: %1; }")
-                        .arg(color.name());
-        bar->setStyleSheet(style);
-        
-        m_volumeBarLayout->addWidget(bar);
-    }
-}
-
-void MainWindow::updateVolumeBar(float volume)
-{
-    // Skip processing very low volumes (reduces noise in the display)
-    if (volume < VOLUME_MIN_THRESHOLD) {
-        volume = 0.0f;
-    }
+    const RecordingStats stats = m_recorder->stats();
     
-    // Scale volume with a curve to make small volumes more visible
-    // Using stronger log scale based on config parameters
-    float scaledVolume;
-    if (volume <= 0.0f) {
-        scaledVolume = 0.0f;
-    } else {
-        // Enhanced log transformation to boost low values
-        scaledVolume = (log10f(1.0f + volume * (VOLUME_LOG_BASE - 1.0f)) / log10f(VOLUME_LOG_BASE)) * 100.0f;
+    // First captured frames mean audio is now flowing
+    if (!m_audioFlowing && stats.framesCaptured > 0) {
+        m_audioFlowing = true;
+        m_statusLabel->setText("Recording in progress... (Press Enter/Space to save, Esc to cancel)");
+        qInfo() << "First audio data received, volume:" << stats.level;
     }
     
-    // Ensure scaledVolume is within 0-100 range
-    scaledVolume = qBound(0.0f, scaledVolume, 100.0f);
-    
-    // Update each segment
-    for (int i = 0; i < m_volumeBarLayout->count(); i++) {
-        QProgressBar* bar = qobject_cast<QProgressBar*>(m_volumeBarLayout->itemAt(i)->widget());
-        if (bar) {
-            int threshold = (i+1) * (100 / m_volumeBarLayout->count());
-            
-            // Each bar is either full or empty based on whether the volume reaches its threshold
-            if (scaledVolume >= threshold) {
-                bar->setValue(100);  // Full
-            } else {
-                // Calculate partial fill based on how close we are to threshold
-                int prevThreshold = i * (100 / m_volumeBarLayout->count());
-                int segmentRange = threshold - prevThreshold;
-                float segmentVolume = scaledVolume - prevThreshold;
-                if (segmentVolume > 0) {
-                    int pct = qBound(0, static_cast<int>((segmentVolume * 100) / segmentRange), 100);
-                    bar->setValue(pct);
-                } else {
-                    bar->setValue(0);  // Empty
-                }
-            }
-        }
+    // Only repaint on a visible change (reduces noise in display)
+    if (qAbs(stats.level - m_lastMeterLevel) > 0.005f || qAbs(stats.peakHold - m_lastMeterPeak) > 0.005f) {
+        m_volumeBar->setLevel(stats.level, stats.peakHold);
+        m_lastMeterLevel = stats.level;
+        m_lastMeterPeak = stats.peakHold;
     }
 }
 
 void MainWindow::onRecordingStopped()
 {
-    m_statusLabel->setText("Recording Stopped. File saved.");
+    TraceSpan span("onRecordingStopped", "ui");
+    m_statusLabel->setText("Recording Stopped.");
     m_statusLabel->setStyleSheet(STYLE_STATUS_SUCCESS);
     
     // Change background to indicate recording has stopped
@@ -287,27 +215,30 @@ void MainWindow::onRecordingStopped()
     m_statusLabel->setPalette(pal);
     
     // Reset volume bar when recording stops
-    updateVolumeBar(0.0f);
+    m_meterTimer.stop();
+    m_volumeBar->setLevel(0.0f);
+    
+    // Escape has already dropped the job of a canceled recording
+    const int job = m_currentJob;
+    m_currentJob = -1;
+    const bool transcribe = m_recorder->hasRecording() && m_backendAvailable && job >= 0;
+    if (!transcribe && job >= 0) {
+        m_transcriptions->cancelJob(job);
+    }
     
     // Check for valid recording and API key
-    QFile recordingFile(OUTPUT_FILE_PATH);
-    if (recordingFile.exists() && m_hasApiKey) {
-        // Auto-start transcription
-        m_transcriptionLabel->setText("Automatically starting transcription...");
-        m_transcriptionLabel->setStyleSheet(STYLE_TRANSCRIPTION_NEUTRAL);
-        
-        // Make sure the button is hidden during auto-transcription
-        m_transcribeButton->setVisible(false);
-        
-        // Update status for transcription
-        m_statusLabel->setText("Please wait while transcription completes...");
-        
-        // Slight delay to update UI before starting transcription
-        QTimer::singleShot(500, this, [this]() {
-            onTranscribeButtonClicked();
-        });
-    } else if (!m_hasApiKey) {
-        m_transcriptionLabel->setText("NO API KEY - Transcription unavailable");
+    if (transcribe) {
+        // A streaming upload already has most of the audio on the wire and
+        // finishes by itself; otherwise the recording waits for a free
+        // backend. Either way the window goes now, so the next recording can
+        // start while this one is transcribed, and the text is pasted after
+        // the texts of earlier recordings.
+        m_transcriptions->submitJob(job, m_recorder->recordedSegments(), m_recorder->recordedDurationMs());
+        qInfo() << "Recording queued for transcription as job" << job << "-"
+                << m_transcriptions->pendingJobs() << "job(s) pending";
+        hideAndReset();
+    } else if (!m_backendAvailable) {
+        m_transcriptionLabel->setText(m_transcriptions->unavailableReason());
         m_transcriptionLabel->setStyleSheet(STYLE_TRANSCRIPTION_ERROR);
         
         // Hide the transcribe button since there's no API key
@@ -317,13 +248,13 @@ void MainWindow::onRecordingStopped()
         QTimer::singleShot(1000, this, [this]() {
             m_statusLabel->setText("Press Enter/Space to save and exit, or Esc to cancel");
         });
-    } else if (isVisible()) {
-        // Only show "Recording file not found" message if we're visible
+    } else if (isVisible() && !m_recorder->hasRecording()) {
+        // Only show "Recording is empty" message if we're visible
         // This prevents showing error after cancellation and reopening
-        m_transcriptionLabel->setText("Recording file not found");
+        m_transcriptionLabel->setText("Recording is empty");
         m_transcriptionLabel->setStyleSheet(STYLE_TRANSCRIPTION_ERROR);
         
-        // Hide the transcribe button since there's no recording file
+        // Hide the transcribe button since there's nothing to transcribe
         m_transcribeButton->setVisible(false);
         
         // Update status with instruction
@@ -338,6 +269,24 @@ void MainWindow::onRecordingStarted()
     // Update UI when recording initialization starts
     m_statusLabel->setText("Initializing audio system...");
     
+    m_partialText.clear();
+    
+    // Start sampling the level snapshot from a clean meter
+    m_audioFlowing = false;
+    m_lastMeterLevel = -1.0f;
+    m_lastMeterPeak = -1.0f;
+    m_volumeBar->setLevel(0.0f);
+    m_meterTimer.start();
+    
+    // One job per recording. A free backend opens the request now and
+    // sends audio as it is encoded, or at least has the connection ready by
+    // the time the recording is done.
+    m_currentJob = -1;
+    if (m_backendAvailable) {
+        m_currentJob = m_transcriptions->beginJob(m_recorder->recordedAudio(), m_recorder->audioFormat(), "en",
+                                                  m_streamingUpload);
+    }
+    
     // Set status to busy
     setFileStatus(STATUS_BUSY);
 }
@@ -373,34 +322,42 @@ void MainWindow::keyPressEvent(QKeyEvent* event)
         m_exitCode = APP_EXIT_FAILURE_CANCELED;
         qInfo() << "Exit code set to" << m_exitCode << "(CANCELED)";
         
+        // Drop this recording's job before stopping, so it is not queued;
+        // earlier recordings are still transcribed and pasted
+        if (m_currentJob >= 0) {
+            m_transcriptions->cancelJob(m_currentJob);
+            m_currentJob = -1;
+        }
+        m_failedJob = -1;
+        
         // Stop recording
         m_recorder->stopRecording();
-        
-        // Cancel transcription if in progress
-        if (m_transcriptionService && m_transcriptionService->isTranscribing()) {
-            m_transcriptionService->cancelTranscription();
-        }
 
-        // Remove the audio file
-        QFile audioFile(OUTPUT_FILE_PATH);
+        // Drop the recording, and the saved copy if there is one
+        m_recorder->discardRecording();
+        QFile audioFile(m_recorder->outputFilePath());
         if (audioFile.exists()) {
             audioFile.remove();
-            qInfo() << "[INFO] Audio file removed:" << OUTPUT_FILE_PATH;
+            qInfo() << "[INFO] Audio file removed:" << audioFile.fileName();
         }
         
-        // Create empty transcription file instead of removing it
-        QFile transcriptionFile(TRANSCRIPTION_OUTPUT_PATH);
-        if (transcriptionFile.exists()) {
-            transcriptionFile.remove();
-        }
-        if (transcriptionFile.open(QIODevice::WriteOnly | QIODevice::Text)) {
-            // Just create an empty file
-            transcriptionFile.close();
-            qInfo() << "[INFO] Transcription file emptied:" << TRANSCRIPTION_OUTPUT_PATH;
+        // Earlier recordings still to be pasted keep the file and the busy status
+        const bool jobsPending = m_transcriptions->pendingJobs() > 0;
+        if (!jobsPending) {
+            // Create empty transcription file instead of removing it
+            QFile transcriptionFile(TRANSCRIPTION_OUTPUT_PATH);
+            if (transcriptionFile.exists()) {
+                transcriptionFile.remove();
+            }
+            if (transcriptionFile.open(QIODevice::WriteOnly | QIODevice::Text)) {
+                // Just create an empty file
+                transcriptionFile.close();
+                qInfo() << "[INFO] Transcription file emptied:" << TRANSCRIPTION_OUTPUT_PATH;
+            }
         }
         
         // Set status to ready (not idle)
-        setFileStatus(STATUS_READY);
+        setFileStatus(jobsPending ? STATUS_BUSY : STATUS_READY);
         
         // Update UI
         m_statusLabel->setText("Recording canceled.");
@@ -416,29 +373,26 @@ void MainWindow::keyPressEvent(QKeyEvent* event)
             m_recorder->pauseAudioStream();
         }
         
+        Tracer::instance().instant("canceled", "ui");
+        if (!jobsPending) {
+            Tracer::instance().endSession();
+        }
+
         // Hide the window
         QTimer::singleShot(200, [this]() {
             hide();
         });
     }
     else if (event->key() == Qt::Key_Return || event->key() == Qt::Key_Enter || event->key() == Qt::Key_Space) {
-        // First check if transcription is in progress
-        if (m_transcriptionService && m_transcriptionService->isTranscribing()) {
-            // Don't hide if transcription is in progress
-            qInfo() << "[INFO] Enter/Space key pressed - waiting for transcription to complete";
-            m_statusLabel->setText("Please wait for transcription to complete...");
-            return;
-        }
-        
-        // If recording is still active, stop it and begin the transcription process
+        // If recording is still active, stop it and queue the transcription
         if (m_recorder->isRecording()) {
             qInfo() << "[INFO] Enter/Space key pressed - stopping recording and saving";
             m_recorder->stopRecording();
-            // Don't hide yet - onRecordingStopped will start transcription
+            // onRecordingStopped queues the transcription and hides the window
             return;
         }
         
-        // If we're here, recording is stopped and transcription is done
+        // If we're here, recording is stopped and an error or notice is shown
         // Hide window instead of exiting
         qInfo() << "[INFO] Enter/Space key pressed - hiding window";
         hideAndReset();
@@ -469,6 +423,13 @@ void MainWindow::closeEvent(QCloseEvent* event)
 void MainWindow::showEvent(QShowEvent* event)
 {
     QMainWindow::showEvent(event);
+    m_transcriptions->setDeliveryHeld(true);
+    
+    // Back for a failed transcription: keep its message and the microphone off
+    if (m_showingFailure) {
+        qInfo() << "[INFO] Window is now shown for a failed transcription";
+        return;
+    }
     
     // Restore the default UI colors
     QPalette pal = palette();
@@ -494,6 +455,13 @@ void MainWindow::showEvent(QShowEvent* event)
     qInfo() << "[INFO] Window is now shown, UI reset";
 }
 
+void MainWindow::hideEvent(QHideEvent* event)
+{
+    QMainWindow::hideEvent(event);
+    m_showingFailure = false;
+    m_transcriptions->setDeliveryHeld(false);
+}
+
 void MainWindow::hideAndReset()
 {
     // Stop any ongoing recording
@@ -518,7 +486,7 @@ void MainWindow::hideAndReset()
 void MainWindow::resetUIForNextRecording()
 {
     // Reset volume display
-    updateVolumeBar(0.0f);
+    m_volumeBar->setLevel(0.0f);
     
     // Reset UI state
     m_statusLabel->setText("Ready for next recording.");
@@ -555,57 +523,58 @@ void MainWindow::setupTranscriptionUI()
 
 void MainWindow::onTranscribeButtonClicked()
 {
-    if (!m_transcriptionService) return;
-    
     // Cancel any auto-close timer when retry is attempted
     if (m_autoCloseTimer.isActive()) {
         m_autoCloseTimer.stop();
         qInfo() << "Auto-close timer canceled due to retry attempt";
     }
     
-    // Check if the recording file exists
-    QFile recordingFile(OUTPUT_FILE_PATH);
-    if (!recordingFile.exists()) {
-        m_transcriptionLabel->setText("Error: Recording file not found");
+    // The failed job still has its audio; it goes to the back of the queue
+    const int job = m_transcriptions->retryJob(m_failedJob);
+    m_failedJob = -1;
+    if (job < 0) {
+        m_transcriptionLabel->setText("Error: Nothing to transcribe");
         m_transcriptionLabel->setStyleSheet(STYLE_TRANSCRIPTION_ERROR);
+        m_transcribeButton->setVisible(false);
         return;
     }
     
-    // Start the transcription process
-    m_transcribeButton->setEnabled(false);
-    m_transcriptionLabel->setStyleSheet(STYLE_TRANSCRIPTION_NEUTRAL);
-    m_transcriptionLabel->setText("Starting transcription process...");
-    
-    // Check environment again for API key (might have been updated)
-    QProcessEnvironment env = QProcessEnvironment::systemEnvironment();
-    if (env.contains("OPENAI_API_KEY") && !env.value("OPENAI_API_KEY").isEmpty()) {
-        // Refresh the transcription service with the latest API key
-        m_transcriptionService->refreshApiKey();
-    }
-
-    m_transcriptionService->transcribeAudio(OUTPUT_FILE_PATH, "en");
+    // Pasted once it is done, like any other recording
+    setFileStatus(STATUS_BUSY);
+    hideAndReset();
 }
 
-void MainWindow::onTranscriptionCompleted(const QString& transcribedText)
+void MainWindow::onTranscriptionCompleted(int job, const QString& transcribedText)
 {
     // Set exit code to success
     m_exitCode = APP_EXIT_SUCCESS;
     
     // Log the transcription result to console
-    qInfo() << "Transcription result:\n-----\n" << transcribedText << "\n-----";
-    qInfo() << "Exit code set to" << m_exitCode << "(SUCCESS), hiding window immediately";
+    qInfo() << "Transcription result of job" << job << ":\n-----\n" << transcribedText << "\n-----";
+    qInfo() << "Exit code set to" << m_exitCode << "(SUCCESS)";
 
-    // Set status to ready
-    setFileStatus(STATUS_READY);
+    // Only delivered while the window is hidden, so the paste goes to the
+    // application the user dictated into
+    const bool jobsPending = m_transcriptions->pendingJobs() > 0;
+    {
+        TraceSpan span("deliver transcription", "ui");
 
-    // Hide window immediately after successful transcription
-    hideAndReset();
+        saveTranscription(transcribedText);
 
-    copyTranscriptionToClipboard(m_pressCtrlVAfterCopy);
+        // Busy until the last queued recording is pasted
+        setFileStatus(jobsPending ? STATUS_BUSY : STATUS_READY);
+
+        copyTranscriptionToClipboard(m_pressCtrlVAfterCopy);
+    }
+    if (!jobsPending) {
+        Tracer::instance().endSession();
+    }
 }
 
-void MainWindow::onTranscriptionFailed(const QString& errorMessage)
+void MainWindow::onTranscriptionFailed(int job, const QString& errorMessage)
 {
+    m_failedJob = job;
+    
     // Set appropriate exit code based on the error
     if (errorMessage.contains("API key", Qt::CaseInsensitive) || 
         errorMessage.contains("authentication", Qt::CaseInsensitive)) {
@@ -621,6 +590,15 @@ void MainWindow::onTranscriptionFailed(const QString& errorMessage)
     
     // Set status to error with the error message
     setFileStatus(STATUS_ERROR, errorMessage);
+    Tracer::instance().instant("transcription failed", "ui", errorMessage);
+    Tracer::instance().endSession();
+    
+    // Results are held while the window is up, so it is hidden now; bring
+    // it back for the error, and later results wait until it is dismissed
+    if (!isVisible()) {
+        m_showingFailure = true;
+        show();
+    }
     
     // Update UI with error message
     m_transcriptionLabel->setStyleSheet(STYLE_TRANSCRIPTION_ERROR);
@@ -630,9 +608,10 @@ void MainWindow::onTranscriptionFailed(const QString& errorMessage)
     m_statusLabel->setText("Transcription Failed");
     m_statusLabel->setStyleSheet(STYLE_STATUS_ERROR);
     
-    // Check environment again for API key (might have been updated)
-    QProcessEnvironment env = QProcessEnvironment::systemEnvironment();
-    if (!env.value("OPENAI_API_KEY").isEmpty()) {
+    // Check again for API key (might have been updated)
+    m_transcriptions->refreshCredentials();
+    const bool canRetry = m_transcriptions->isAvailable();
+    if (canRetry) {
         // Make the "Try Again" button visible
         m_transcribeButton->setVisible(true);
         m_transcribeButton->setEnabled(true);
@@ -664,7 +643,7 @@ void MainWindow::onTranscriptionFailed(const QString& errorMessage)
         countdownTimer->setInterval(1000);
         int remainingSeconds = m_autoCloseSeconds;
         
-        connect(countdownTimer, &QTimer::timeout, this, [this, countdownTimer, remainingSeconds, &env]() mutable {
+        connect(countdownTimer, &QTimer::timeout, this, [this, countdownTimer, remainingSeconds, canRetry]() mutable {
             remainingSeconds--;
             
             if (remainingSeconds <= 0) {
@@ -674,7 +653,7 @@ void MainWindow::onTranscriptionFailed(const QString& errorMessage)
             }
             
             // Update message with remaining time
-            if (!env.value("OPENAI_API_KEY").isEmpty()) {
+            if (canRetry) {
                 m_statusLabel->setText(QString("Click 'Try Again' or wait %1s for auto-close").arg(remainingSeconds));
             } else {
                 m_statusLabel->setText(QString("No API key found - Auto-closing in %1s").arg(remainingSeconds));
@@ -689,29 +668,34 @@ void MainWindow::onTranscriptionFailed(const QString& errorMessage)
     }
 }
 
-void MainWindow::onTranscriptionProgress(const QString& status)
+void MainWindow::onTranscriptionPartial(int job, const QString& text)
+{
+    if (job != m_currentJob) {
+        return;
+    }
+    
+    // Words appear while the user is still speaking
+    m_partialText = text;
+    if (!text.isEmpty()) {
+        m_transcriptionLabel->setStyleSheet(STYLE_TRANSCRIPTION_NEUTRAL);
+        m_transcriptionLabel->setText(text);
+    }
+}
+
+void MainWindow::onTranscriptionProgress(int job, const QString& status)
 {
+    // Earlier recordings finish in the background; only the one being
+    // recorded shows its upload, and interim text takes precedence
+    if (job != m_currentJob || !m_partialText.isEmpty()) {
+        return;
+    }
+    
     // Update UI with progress status
     m_transcriptionLabel->setStyleSheet(STYLE_TRANSCRIPTION_NEUTRAL);
     m_transcriptionLabel->setText(status);
-    
-    // Hide the retry button during transcription
-    m_transcribeButton->setVisible(false);
-    
-    // Update status label to show transcription progress rather than recording timer
-    m_statusLabel->setText("Transcription in Progress");
-    m_statusLabel->setStyleSheet("font-weight: bold; font-size: 12pt; color: #5CAAFF;");
-    
-    // Update status file to show busy state
-    setFileStatus(STATUS_BUSY);
-    
-    // Reset volume bar to zero when transcription starts
-    updateVolumeBar(0.0f);
 }
 
 void MainWindow::cancelTranscription()
 {
-    if (m_transcriptionService && m_transcriptionService->isTranscribing()) {
-        m_transcriptionService->cancelTranscription();
-    }
+    m_transcriptions->cancelAll();
 }
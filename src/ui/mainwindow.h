@@ -8,17 +8,19 @@
 #include <QPushButton>
 
 class AudioRecorder;
-class OpenAiTranscriptionService;
+class TranscriptionQueue;
+class VolumeBar;
 
 class MainWindow : public QMainWindow
 {
     Q_OBJECT
 
 public:
-    explicit MainWindow(AudioRecorder* recorder, QWidget* parent = nullptr);
+    // Takes ownership of `transcriptions`
+    MainWindow(AudioRecorder* recorder, TranscriptionQueue* transcriptions, QWidget* parent = nullptr);
     ~MainWindow() = default;
     
-    // Cancel any ongoing transcription - used by signal handler
+    // Cancel all queued and running transcriptions - used by signal handler
     void cancelTranscription();
     
     // Hide window and prepare for next recording - used after transcription completed
@@ -26,19 +28,23 @@ public:
     
     // Get the current exit code
     int exitCode() const { return m_exitCode; }
+    
+    // Upload while recording instead of after it stopped
+    void setStreamingUpload(bool enabled) { m_streamingUpload = enabled; }
 
 private slots:
     void updateUI();
-    void onVolumeChanged(float volume);
+    void updateLevelMeter();
     void onRecordingStopped();
     void onRecordingStarted();
     void onAudioDeviceReady();
     
     // Transcription slots
     void onTranscribeButtonClicked();
-    void onTranscriptionCompleted(const QString& transcribedText);
-    void onTranscriptionFailed(const QString& errorMessage);
-    void onTranscriptionProgress(const QString& status);
+    void onTranscriptionCompleted(int job, const QString& transcribedText);
+    void onTranscriptionFailed(int job, const QString& errorMessage);
+    void onTranscriptionProgress(int job, const QString& status);
+    void onTranscriptionPartial(int job, const QString& text);
 
 protected:
     // Override key press event to handle Enter/Escape keys
@@ -49,28 +55,37 @@ protected:
     
     // Override show event to reset UI when window is shown
     void showEvent(QShowEvent* event) override;
+    
+    // Results are pasted only while the window is hidden, or Ctrl+V would land here
+    void hideEvent(QHideEvent* event) override;
 
 private:
-    void createVolumeBar();
-    void updateVolumeBar(float volume);
     void setupTranscriptionUI();
     void resetUIForNextRecording(); // Resets UI only without removing files
 
 private:
     AudioRecorder* m_recorder;
-    OpenAiTranscriptionService* m_transcriptionService;
+    TranscriptionQueue* m_transcriptions;
     QLabel*        m_statusLabel;
     QLabel*        m_transcriptionLabel;
     QTimer         m_updateTimer;
-    QWidget*       m_volumeBar;
-    QHBoxLayout*   m_volumeBarLayout;
+    QTimer         m_meterTimer;    // Samples the recorder's level snapshot
+    float          m_lastMeterLevel;
+    float          m_lastMeterPeak;
+    bool           m_audioFlowing;
+    VolumeBar*     m_volumeBar;
     QPushButton*   m_transcribeButton;
-    bool           m_hasApiKey;
+    bool           m_backendAvailable;
     QTimer         m_autoCloseTimer;
     int            m_autoCloseSeconds;
     int            m_exitCode;  // Exit code to use when application terminates
     bool           m_isClosingPermanently;
     bool m_pressCtrlVAfterCopy{true};
+    bool m_streamingUpload{false};
+    QString m_partialText;      // Latest interim text of the current recording
+    int m_currentJob{-1};       // Transcription job of the recording on screen
+    int m_failedJob{-1};        // Shown with "Try Again"
+    bool m_showingFailure{false}; // Shown for a failed job, not for recording
 };
 
 #endif // MAINWINDOW_H
@@ -0,0 +1,91 @@
+#include "volumebar.h"
+#include <QColor>
+#include <QProgressBar>
+#include <cmath>
+
+#include "config/config.h"
+
+VolumeBar::VolumeBar(QWidget* parent)
+    : QWidget(parent),
+      m_layout(new QHBoxLayout(this))
+{
+    m_layout->setContentsMargins(10, 5, 10, 5);
+
+    // Create 20 segments for the volume meter
+    const int segments = 20;
+    for (int i = 0; i < segments; i++) {
+        QProgressBar* bar = new QProgressBar(this);
+        bar->setFixedWidth(8);
+        bar->setFixedHeight(30);
+        bar->setMinimum(0);
+        bar->setMaximum(100);
+        bar->setValue(0);
+        bar->setTextVisible(false);
+
+        // Color gradient from green to yellow to red - dark mode colors
+        QColor color;
+        if (i < segments * 0.6) {            // First 60% - Bright Green
+            color = QColor(0, 230, 118);
+        } else if (i < segments * 0.8) {     // Next 20% - Bright Yellow
+            color = QColor(255, 214, 0);
+        } else {                             // Last 20% - Bright Red
+            color = QColor(255, 82, 82);
+        }
+
+        // Set the bar color via stylesheet with dark mode styling
+        QString style = QString("QProgressBar { background: #222; border: 1px solid #333; border-radius: 2px; } "
+                               "QProgressBar::chunk { background-color: %1; }")
+                        .arg(color.name());
+        bar->setStyleSheet(style);
+
+        m_layout->addWidget(bar);
+    }
+}
+
+float VolumeBar::scaleForDisplay(float volume)
+{
+    // Skip processing very low volumes (reduces noise in the display)
+    if (volume < VOLUME_MIN_THRESHOLD) {
+        return 0.0f;
+    }
+
+    // Scale volume with a curve to make small volumes more visible
+    // Using stronger log scale based on config parameters
+    float scaledVolume = (log10f(1.0f + volume * (VOLUME_LOG_BASE - 1.0f)) / log10f(VOLUME_LOG_BASE)) * 100.0f;
+
+    // Ensure scaledVolume is within 0-100 range
+    return qBound(0.0f, scaledVolume, 100.0f);
+}
+
+void VolumeBar::setLevel(float volume, float peakHold)
+{
+    const float scaledVolume = scaleForDisplay(volume);
+    const float scaledPeak = scaleForDisplay(peakHold);
+
+    // Update each segment
+    const int segmentCount = m_layout->count();
+    for (int i = 0; i < segmentCount; i++) {
+        QProgressBar* bar = qobject_cast<QProgressBar*>(m_layout->itemAt(i)->widget());
+        if (bar) {
+            int threshold = (i+1) * (100 / segmentCount);
+            int prevThreshold = i * (100 / segmentCount);
+
+            // Each bar is either full or empty based on whether the volume reaches its threshold
+            if (scaledVolume >= threshold) {
+                bar->setValue(100);  // Full
+            } else if (scaledPeak > prevThreshold && scaledPeak <= threshold) {
+                bar->setValue(100);  // Peak hold marker
+            } else {
+                // Calculate partial fill based on how close we are to threshold
+                int segmentRange = threshold - prevThreshold;
+                float segmentVolume = scaledVolume - prevThreshold;
+                if (segmentVolume > 0) {
+                    int pct = qBound(0, static_cast<int>((segmentVolume * 100) / segmentRange), 100);
+                    bar->setValue(pct);
+                } else {
+                    bar->setValue(0);  // Empty
+                }
+            }
+        }
+    }
+}
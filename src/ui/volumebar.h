@@ -0,0 +1,24 @@
+#ifndef VOLUMEBAR_H
+#define VOLUMEBAR_H
+
+#include <QHBoxLayout>
+#include <QWidget>
+
+// Segmented level meter (green, yellow, red) with a peak-hold marker
+class VolumeBar : public QWidget
+{
+    Q_OBJECT
+public:
+    explicit VolumeBar(QWidget* parent = nullptr);
+
+    // `volume` and `peakHold` are display levels in 0..1
+    void setLevel(float volume, float peakHold = 0.0f);
+
+    // Level as shown: log-scaled to 0..100, 0 below VOLUME_MIN_THRESHOLD
+    static float scaleForDisplay(float volume);
+
+private:
+    QHBoxLayout* m_layout;
+};
+
+#endif // VOLUMEBAR_H